@@ -0,0 +1,16 @@
+
+#include "infrastructure/bitops.h"
+
+static bool DetectPopCnt() {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+	int cpuInfo[4];
+	__cpuid(cpuInfo, 1);
+	return (cpuInfo[2] & (1 << 23)) != 0; // ECX bit 23
+#elif defined(__GNUC__)
+	return __builtin_cpu_supports("popcnt") != 0;
+#else
+	return false;
+#endif
+}
+
+const bool BitOps::sHasPopCnt = DetectPopCnt();
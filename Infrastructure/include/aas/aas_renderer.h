@@ -50,6 +50,23 @@ namespace aas {
 			float alpha,
 			bool softShadows);
 
+		/**
+		 * Counts the submeshes whose vertex buffers had to be updated, and the ones that could be
+		 * drawn with what was uploaded before since the model hasn't been skinned again in between.
+		 */
+		struct BufferStats {
+			int updated = 0;
+			int reused = 0;
+		};
+
+		const BufferStats &GetBufferStats() const {
+			return mBufferStats;
+		}
+
+		void ResetBufferStats() {
+			mBufferStats = {};
+		}
+
 	private:
 		gfx::AnimatedModelFactory &mAasFactory;
 		gfx::RenderingDevice &mDevice;
@@ -65,9 +82,12 @@ namespace aas {
 		gfx::Material mGaussBlurHor; // Material for horizontal pass of gauss blur
 		gfx::Material mGaussBlurVer; // Material for vertical pass of gauss blur
 
+		BufferStats mBufferStats;
+
 		AasRenderSubmeshData &GetSubmeshData(AasRenderData& aasState,
 			int submeshId,
-			gfx::Submesh &submesh);
+			gfx::Submesh &submesh,
+			bool recalculateNormals = false);
 
 		static gfx::Material CreateGeometryShadowMaterial(gfx::RenderingDevice &device);
 		static gfx::Material CreateShadowMapMaterial(gfx::RenderingDevice &device);
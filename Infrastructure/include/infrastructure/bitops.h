@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * Bit counting primitives for bitmap based containers.
+ * PopCount uses the POPCNT instruction if the CPU supports it and
+ * falls back to a branch-free SWAR count otherwise.
+ */
+class BitOps {
+public:
+
+	// Number of set bits in the given value
+	static uint32_t PopCount(uint32_t value) {
+#if defined(_MSC_VER) && (defined(_M_IX86) || defined(_M_X64))
+		if (sHasPopCnt) {
+			return __popcnt(value);
+		}
+		return PopCountPortable(value);
+#elif defined(__GNUC__)
+		return __builtin_popcount(value);
+#else
+		return PopCountPortable(value);
+#endif
+	}
+
+	// Number of set bits below the given bit index (0-32)
+	static uint32_t PopCountBelow(uint32_t value, uint32_t bitIdx) {
+		if (bitIdx >= 32) {
+			return PopCount(value);
+		}
+		return PopCount(value & ((1u << bitIdx) - 1));
+	}
+
+	static uint32_t PopCountPortable(uint32_t value) {
+		value = value - ((value >> 1) & 0x55555555);
+		value = (value & 0x33333333) + ((value >> 2) & 0x33333333);
+		value = (value + (value >> 4)) & 0x0F0F0F0F;
+		return (value * 0x01010101) >> 24;
+	}
+
+	// Index of the lowest set bit. Value must not be 0.
+	static uint32_t CountTrailingZeros(uint32_t value) {
+#if defined(_MSC_VER)
+		unsigned long result;
+		_BitScanForward(&result, value);
+		return result;
+#elif defined(__GNUC__)
+		return __builtin_ctz(value);
+#else
+		uint32_t result = 0;
+		while (!(value & 1)) {
+			value >>= 1;
+			++result;
+		}
+		return result;
+#endif
+	}
+
+	static bool HasHardwarePopCount() {
+		return sHasPopCnt;
+	}
+
+private:
+	static const bool sHasPopCnt;
+};
+
+/**
+ * Rank bookkeeping for a bitmap of 32-bit blocks that indexes a packed array (one element per set bit),
+ * like the property bitmap of game objects. ranks[i] is the number of bits set in the blocks before
+ * block i, so the packed index of a bit is one rank load and one PopCountBelow.
+ * The caller owns both arrays; blockCount is their length.
+ */
+class BitmapRanks {
+public:
+
+	// Computes the ranks from scratch, e.g. after the bitmap has been loaded
+	static void Build(const uint32_t *blocks, uint32_t *ranks, size_t blockCount) {
+		uint32_t rank = 0;
+		for (size_t i = 0; i < blockCount; ++i) {
+			ranks[i] = rank;
+			rank += BitOps::PopCount(blocks[i]);
+		}
+	}
+
+	// Updates the ranks after a bit in the given block has been set (delta 1) or cleared (delta -1)
+	static void Adjust(uint32_t *ranks, size_t blockCount, size_t blockIdx, int delta) {
+		for (auto i = blockIdx + 1; i < blockCount; ++i) {
+			ranks[i] += delta;
+		}
+	}
+
+	// Number of bits set before the given bit
+	static uint32_t Rank(const uint32_t *blocks, const uint32_t *ranks, size_t blockIdx, uint32_t bitIdx) {
+		return ranks[blockIdx] + BitOps::PopCountBelow(blocks[blockIdx], bitIdx);
+	}
+
+	// Sets a cleared bit and inserts a default value for it into the packed array of count values,
+	// which must already have room for one more. Returns the packed index of the new value.
+	template <typename T>
+	static size_t Insert(uint32_t *blocks, uint32_t *ranks, size_t blockCount, size_t blockIdx, uint32_t bitIdx,
+		T *values, size_t count) {
+		blocks[blockIdx] |= 1u << bitIdx;
+		Adjust(ranks, blockCount, blockIdx, 1);
+
+		size_t idx = Rank(blocks, ranks, blockIdx, bitIdx);
+		for (auto i = count; i > idx; --i) {
+			values[i] = values[i - 1];
+		}
+		values[idx] = T();
+		return idx;
+	}
+
+	// Clears a set bit and removes its value from the packed array of count values.
+	// Afterwards only the first count - 1 values are used.
+	template <typename T>
+	static void Remove(uint32_t *blocks, uint32_t *ranks, size_t blockCount, size_t blockIdx, uint32_t bitIdx,
+		T *values, size_t count) {
+		size_t idx = Rank(blocks, ranks, blockIdx, bitIdx);
+		for (auto i = idx; i + 1 < count; ++i) {
+			values[i] = values[i + 1];
+		}
+
+		blocks[blockIdx] &= ~(1u << bitIdx);
+		Adjust(ranks, blockCount, blockIdx, -1);
+	}
+};
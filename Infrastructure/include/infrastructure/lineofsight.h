@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * The cells of a rectangular part of a grid (e.g. the subtiles around the party)
+ * that block vision. Cells outside of the rect block vision as well.
+ */
+class VisionBlockers {
+public:
+
+	// Clears the blockers and moves the rect to the given cells
+	void Reset(int originX, int originY, int width, int height);
+
+	void SetBlocking(int x, int y, bool blocking = true) {
+		if (Contains(x, y)) {
+			mCells[GetIndex(x, y)] = blocking ? 1 : 0;
+		}
+	}
+
+	bool IsBlocking(int x, int y) const {
+		return !Contains(x, y) || mCells[GetIndex(x, y)] != 0;
+	}
+
+	bool Contains(int x, int y) const {
+		return x >= mOriginX && y >= mOriginY && x < mOriginX + mWidth && y < mOriginY + mHeight;
+	}
+
+	// Index of a cell within the rect (row by row), which must be contained in it
+	uint32_t GetIndex(int x, int y) const {
+		return (uint32_t)((y - mOriginY) * mWidth + (x - mOriginX));
+	}
+
+	int GetOriginX() const {
+		return mOriginX;
+	}
+	int GetOriginY() const {
+		return mOriginY;
+	}
+	int GetWidth() const {
+		return mWidth;
+	}
+	int GetHeight() const {
+		return mHeight;
+	}
+
+private:
+	std::vector<uint8_t> mCells;
+	int mOriginX = 0;
+	int mOriginY = 0;
+	int mWidth = 0;
+	int mHeight = 0;
+};
+
+/**
+ * Finds the cells a viewer can see using recursive shadowcasting: each of the eight octants around
+ * the viewer is scanned row by row moving away from it, and blocking cells narrow down the range of
+ * slopes that is still visible in the rows behind them. Every cell within the radius is looked at
+ * once at most, so the cost only depends on the radius, not on the number of blockers.
+ * Blocking cells are visible themselves, so the walls around a room can be seen from inside of it.
+ */
+class ShadowCaster {
+public:
+	/**
+	 * Stores the indices (see VisionBlockers::GetIndex) of the cells within radius of the viewer
+	 * that it can see in visibleOut, in ascending order.
+	 */
+	static void Compute(const VisionBlockers &blockers, int viewerX, int viewerY, int radius,
+		std::vector<uint32_t> &visibleOut);
+};
+
+/**
+ * The cells that any of a number of viewers (e.g. the party members) can see.
+ * Keeps the cells seen by every viewer and how many viewers see each cell, so when
+ * only one viewer moves, only its line of sight has to be computed again.
+ */
+class LineOfSight {
+public:
+
+	// Replaces the blockers, which means all viewers have to be computed again
+	void SetBlockers(const VisionBlockers &blockers);
+
+	const VisionBlockers& GetBlockers() const {
+		return mBlockers;
+	}
+
+	// Changes a single blocking cell (e.g. a door that was opened). All viewers are computed again.
+	void SetBlocking(int x, int y, bool blocking);
+
+	// Places a viewer; nothing needs to be computed again if it has not moved
+	void SetViewer(size_t idx, int x, int y, int radius);
+
+	void RemoveViewer(size_t idx);
+
+	// Computes the line of sight of the viewers that moved. Returns how many were computed.
+	size_t Update();
+
+	// Whether any viewer can see the cell (as of the last Update)
+	bool IsVisible(int x, int y) const {
+		return mBlockers.Contains(x, y) && mViewerCounts[mBlockers.GetIndex(x, y)] > 0;
+	}
+
+	// The cells (see VisionBlockers::GetIndex) a single viewer can see as of the last Update, in ascending order
+	const std::vector<uint32_t>& GetVisibleCells(size_t idx) const;
+
+private:
+	struct Viewer {
+		bool active = false;
+		bool dirty = false;
+		int x = 0;
+		int y = 0;
+		int radius = 0;
+		std::vector<uint32_t> visible; // the cells counted for this viewer in mViewerCounts
+	};
+
+	VisionBlockers mBlockers;
+	std::vector<Viewer> mViewers;
+	std::vector<uint16_t> mViewerCounts; // per cell of mBlockers
+
+	void Uncount(Viewer &viewer);
+	void InvalidateViewers();
+};
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <DirectXMath.h>
 #include <gsl/span>
@@ -350,6 +352,14 @@ namespace gfx {
 		virtual gsl::span<DirectX::XMFLOAT4> GetNormals() = 0;
 		virtual gsl::span<DirectX::XMFLOAT2> GetUV() = 0;
 		virtual gsl::span<uint16_t> GetIndices() = 0;
+
+		/**
+		 * Changes whenever the positions or normals of the submesh are recomputed, so renderers
+		 * can keep using what they uploaded before. 0 means unknown, i.e. they may have changed.
+		 */
+		virtual uint32_t GetVersion() {
+			return 0;
+		}
 	};
 
 	class IRenderState {
@@ -357,6 +367,29 @@ namespace gfx {
 		virtual ~IRenderState() = default;
 	};
 
+	/**
+	 * Skins the submeshes of many animated models at once, spread over multiple threads.
+	 * Models add their submeshes with AnimatedModel::AddToSkinningBatch.
+	 */
+	class SkinningBatch {
+	public:
+		/**
+		 * skin may run on any thread. finish runs on the thread calling Run once all
+		 * submeshes are skinned, in the order they were added.
+		 */
+		void Add(int vertexCount, std::function<void()> skin, std::function<void()> finish);
+
+		void Run();
+
+	private:
+		struct Job {
+			std::function<void()> skin;
+			std::function<void()> finish;
+		};
+		std::vector<Job> mJobs;
+		int mVertexCount = 0;
+	};
+
 	class AnimatedModel {
 	public:
 		virtual ~AnimatedModel() {
@@ -416,6 +449,14 @@ namespace gfx {
 
 		virtual std::unique_ptr<Submesh> GetSubmeshForParticles(const AnimatedModelParams& params, int submeshIdx) = 0;
 
+		/**
+		 * Adds the submeshes that need skinning to the batch, so the following GetSubmesh calls
+		 * (with the same params) don't have to. Each model may only be added to a batch once.
+		 * Models that don't support it are skinned in GetSubmesh as before.
+		 */
+		virtual void AddToSkinningBatch(const AnimatedModelParams& params, SkinningBatch& batch) {
+		}
+
 		bool HitTestRay(const AnimatedModelParams& params, const Ray3d &ray, float &hitDistance);
 
 		/**
@@ -1,8 +1,106 @@
-
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <map>
+#include <vector>
+
+#include <gsl/span>
+
+/**
+ * Compact, read-only contents of a .mes file. Keys are stored in a sorted
+ * array and the values back to back in a single string blob. Every value is
+ * NUL terminated, so it can be handed out as a C string.
+ */
+class MesTable {
+public:
+
+	struct Entry {
+		int first;
+		std::string_view second;
+	};
+
+	class Iterator {
+	public:
+		Iterator(const MesTable *table, size_t idx) : mTable(table), mIdx(idx) {
+		}
+
+		Entry operator*() const {
+			return { mTable->mKeys[mIdx], mTable->GetValue(mIdx) };
+		}
+
+		Iterator &operator++() {
+			++mIdx;
+			return *this;
+		}
+
+		bool operator==(const Iterator &other) const {
+			return mIdx == other.mIdx;
+		}
+
+		bool operator!=(const Iterator &other) const {
+			return mIdx != other.mIdx;
+		}
+
+	private:
+		const MesTable *mTable;
+		size_t mIdx;
+	};
+
+	Iterator begin() const {
+		return Iterator(this, 0);
+	}
+
+	Iterator end() const {
+		return Iterator(this, mKeys.size());
+	}
+
+	size_t size() const {
+		return mKeys.size();
+	}
+
+	bool empty() const {
+		return mKeys.empty();
+	}
+
+	// Returns the value for the key, or nullptr if the key is not present
+	const char *Find(int key) const;
+
+	bool Contains(int key) const {
+		return Find(key) != nullptr;
+	}
+
+	// Returns the value for the key, or an empty string if the key is not present
+	std::string_view operator[](int key) const {
+		auto value = Find(key);
+		return value ? std::string_view(value) : std::string_view();
+	}
+
+	std::map<int, std::string> ToMap() const;
+
+	// Approximate number of bytes used by the table's storage
+	size_t GetMemoryUsage() const;
+
+	// Serializes the table into the binary cache format, tagged with a stamp (e.g. size and
+	// modification time) of the file it was parsed from
+	std::vector<uint8_t> Serialize(uint64_t sourceStamp) const;
+
+	// Reads a table from the binary cache format. Fails if the data is damaged or
+	// was parsed from a file with a different stamp.
+	static bool Deserialize(gsl::span<const uint8_t> data, uint64_t sourceStamp, MesTable &table);
+
+private:
+	friend class MesFile;
+
+	std::string_view GetValue(size_t idx) const {
+		return std::string_view(mBlob.data() + mOffsets[idx], mOffsets[idx + 1] - mOffsets[idx] - 1);
+	}
+
+	std::vector<int> mKeys;
+	// Start of each value in the blob, followed by the size of the blob
+	std::vector<uint32_t> mOffsets;
+	std::string mBlob;
+};
 
 class MesFile {
 public:
@@ -14,4 +112,19 @@ public:
 
 	static Content ParseString(const std::string &content, const std::string& filename = "<string>");
 
+	static MesTable ParseFileToTable(const std::string &filename);
+
+	static MesTable ParseStringToTable(const std::string &content, const std::string& filename = "<string>");
+
+	/**
+	 * Enables a cache for ParseFileToTable in the given directory. Cache entries are
+	 * keyed by the file name and validated against the size and modification time of
+	 * the file, so a warm start neither reads nor parses the .mes files.
+	 * ParseFile and ParseString don't use the cache.
+	 * Pass an empty string to disable the cache (the default).
+	 */
+	static void SetCacheDir(const std::string &dir);
+
+	static uint64_t HashContent(const std::string &content);
+
 };
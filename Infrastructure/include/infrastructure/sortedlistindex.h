@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+/**
+ * Ordered index over an intrusive singly linked list that is kept sorted by a 64-bit key.
+ * The list stays the canonical storage; for every distinct key the index remembers the last
+ * node with that key, so finding the insertion point of a new node is a tree lookup instead
+ * of a walk over the list.
+ * The index only sees insertions made through Insert and head removals reported through
+ * OnHeadRemoved. Code that changes the list in any other way has to call Invalidate afterwards;
+ * the index is then rebuilt from the list on the next insertion.
+ */
+template <typename Node, uint64_t (*KeyOf)(const Node&), Node* Node::*Next>
+class SortedListIndex {
+public:
+	// Inserts the node before any nodes with an equal or later key
+	void Insert(Node** head, Node* node) {
+		if (!mValid) {
+			Rebuild(*head);
+		}
+
+		auto key = KeyOf(*node);
+		auto it = mLastByKey.lower_bound(key);
+		if (it == mLastByKey.begin()) {
+			node->*Next = *head;
+			*head = node;
+		} else {
+			auto prevNode = std::prev(it)->second;
+			node->*Next = prevNode->*Next;
+			prevNode->*Next = node;
+		}
+
+		if (it == mLastByKey.end() || it->first != key) {
+			mLastByKey.emplace_hint(it, key, node);
+		}
+	}
+
+	// Must be called after the list head is unlinked
+	void OnHeadRemoved(const Node* node) {
+		if (!mValid) {
+			return;
+		}
+		// the head is the first node of its key; if it was also the last, its key is gone from the list
+		auto it = mLastByKey.find(KeyOf(*node));
+		if (it != mLastByKey.end() && it->second == node) {
+			mLastByKey.erase(it);
+		}
+	}
+
+	void Invalidate() {
+		mValid = false;
+	}
+
+	bool IsValid() const {
+		return mValid;
+	}
+
+	/**
+	 * Walks the list and checks that it is sorted and that the index has exactly the last node
+	 * of every key in it. An invalidated index is consistent with any sorted list.
+	 */
+	bool IsConsistent(const Node* head) const {
+		size_t keyCount = 0;
+		auto it = mLastByKey.begin();
+		for (auto node = head; node; node = node->*Next) {
+			auto key = KeyOf(*node);
+			auto next = node->*Next;
+			if (next && KeyOf(*next) < key) {
+				return false;
+			}
+			if (next && KeyOf(*next) == key) {
+				continue;
+			}
+			// node is the last one with its key
+			keyCount++;
+			if (mValid) {
+				if (it == mLastByKey.end() || it->first != key || it->second != node) {
+					return false;
+				}
+				++it;
+			}
+		}
+		return !mValid || keyCount == mLastByKey.size();
+	}
+
+private:
+	void Rebuild(Node* head) {
+		mLastByKey.clear();
+		for (auto node = head; node; node = node->*Next) {
+			mLastByKey[KeyOf(*node)] = node;
+		}
+		mValid = true;
+	}
+
+	std::map<uint64_t, Node*> mLastByKey;
+	bool mValid = false;
+};
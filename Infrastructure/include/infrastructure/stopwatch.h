@@ -20,6 +20,13 @@ public:
 		return (int) duration.count();
 	}
 
+	int64_t GetElapsedUs() const {
+		auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+			Clock::now() - mStart
+		);
+		return duration.count();
+	}
+
 private:
 	std::chrono::time_point<Clock> mStart;
 };
@@ -1,12 +1,73 @@
 
 #pragma once
 
+#include <cctype>
+#include <charconv>
 #include <functional>
 #include <vector>
 #include <map>
+#include <memory>
 
 #include <gsl/string_span>
 
+/**
+ * Case-insensitive lookup of names in tab file columns. The names are placed
+ * in a collision-free hash table when the index is built, so a lookup hashes
+ * the column once and compares against a single candidate.
+ */
+class TabFileEnumIndex {
+public:
+	explicit TabFileEnumIndex(std::vector<std::string> names);
+
+	// Returns the index of the name equal to text, or -1 if there is none.
+	// Like ToEE's parser, falls back to the first name that starts with text.
+	int Find(gsl::cstring_span<> text) const;
+
+private:
+	std::vector<std::string> mNames;
+	std::vector<int16_t> mSlots;
+	uint32_t mSeed = 0;
+	uint32_t mMask = 0;
+
+	static uint32_t Hash(const char *text, size_t length, uint32_t seed);
+};
+
+template<typename T>
+class TabFileEnumLookup {
+public:
+	TabFileEnumLookup(std::initializer_list<std::pair<const std::string, T>> mapping)
+		: TabFileEnumLookup(std::map<std::string, T>(mapping)) {
+	}
+
+	explicit TabFileEnumLookup(const std::map<std::string, T> &mapping)
+		: mIndex(GetNames(mapping)) {
+		for (auto &entry : mapping) {
+			mValues.push_back(entry.second);
+		}
+	}
+
+	bool TryGet(gsl::cstring_span<> text, T &value) const {
+		auto idx = mIndex.Find(text);
+		if (idx == -1) {
+			return false;
+		}
+		value = mValues[idx];
+		return true;
+	}
+
+private:
+	TabFileEnumIndex mIndex;
+	std::vector<T> mValues;
+
+	static std::vector<std::string> GetNames(const std::map<std::string, T> &mapping) {
+		std::vector<std::string> result;
+		for (auto &entry : mapping) {
+			result.push_back(entry.first);
+		}
+		return result;
+	}
+};
+
 class TabFileColumn {
 	friend class TabFileRecord;
 public:
@@ -31,15 +92,30 @@ public:
 		return !_strnicmp(mValue.data(), text, mValue.size());
 	}
 
+	// Accepts what sscanf's %f did: leading whitespace and a plus sign are skipped
+	// and anything following the number is ignored
 	bool TryGetFloat(float &value) const {
-		if (mValue.size() == 0) {
+		auto first = mValue.data();
+		auto last = first + mValue.size();
+		while (first < last && isspace((unsigned char)*first)) {
+			++first;
+		}
+		if (first < last && *first == '+' && last - first > 1 && first[1] != '-') {
+			++first;
+		}
+		if (first == last) {
 			return false;
 		}
-		return _snscanf_s(mValue.data(), mValue.size(), "%f", &value) == 1;
+		return std::from_chars(first, last, value).ec == std::errc();
 	}
 
 	template<typename T>
-	bool TryGetEnum(const std::map<std::string, T> &mapping, T& value) {
+	bool TryGetEnum(const TabFileEnumLookup<T> &lookup, T& value) const {
+		return lookup.TryGet(mValue, value);
+	}
+
+	template<typename T>
+	bool TryGetEnum(const std::map<std::string, T> &mapping, T& value) const {
 		for (auto it = mapping.begin(); it != mapping.end(); ++it) {
 			if (!_strnicmp(it->first.c_str(), mValue.data(), mValue.size())) {
 				value = it->second;
@@ -52,22 +128,26 @@ public:
 private:
 	explicit TabFileColumn(gsl::cstring_span<> value) : mValue(value) {
 	}
-	gsl::cstring_span<> mValue;	
+	gsl::cstring_span<> mValue;
 };
 
+/**
+ * A row of a tab file. This is a view into the columns of a TabFileTable
+ * and is only valid as long as the table is.
+ */
 class TabFileRecord {
-friend class TabFile;
+friend class TabFileTable;
 public:
 	int GetLineNumber() const {
 		return mLineNumber;
 	}
 
 	size_t GetColumnCount() const {
-		return mColumns.size();
+		return mColumnCount;
 	}
 
 	TabFileColumn operator[](size_t i) const {
-		if (i >= mColumns.size()) {
+		if (i >= mColumnCount) {
 			return TabFileColumn(mMissingColumn);
 		}
 		return TabFileColumn(mColumns[i]);
@@ -77,12 +157,68 @@ private:
 	static std::string mMissingColumn;
 
 	int mLineNumber = 0;
+	const gsl::cstring_span<> *mColumns = nullptr;
+	size_t mColumnCount = 0;
+};
+
+/**
+ * A tab file split into rows and columns. Columns are spans into the file
+ * content and rows are ranges of columns, so iterating over the rows doesn't
+ * allocate. Larger files are split at line boundaries and parsed on
+ * multiple threads.
+ */
+class TabFileTable {
+public:
+	// Parses content that will be owned by the table
+	explicit TabFileTable(std::string content);
+
+	// Parses content owned by the caller, which has to outlive the table
+	static TabFileTable FromView(gsl::cstring_span<> content);
+
+	static TabFileTable FromFile(const std::string &filename);
+
+	size_t GetRowCount() const {
+		return mRowOffsets.size() - 1;
+	}
+
+	TabFileRecord GetRow(size_t row) const {
+		TabFileRecord record;
+		SetRow(record, row);
+		return record;
+	}
+
+	template<typename Callback>
+	void ForEachRow(Callback &&callback) const {
+		TabFileRecord record;
+		for (size_t row = 0; row < GetRowCount(); ++row) {
+			SetRow(record, row);
+			callback(record);
+		}
+	}
+
+private:
+	TabFileTable() = default;
+
+	void Parse(gsl::cstring_span<> content);
+
+	void SetRow(TabFileRecord &record, size_t row) const {
+		record.mLineNumber = (int) row;
+		record.mColumns = mColumns.data() + mRowOffsets[row];
+		record.mColumnCount = mRowOffsets[row + 1] - mRowOffsets[row];
+	}
+
+	// Heap allocated so the column spans stay valid when the table is moved
+	std::unique_ptr<std::string> mContent;
+
 	std::vector<gsl::cstring_span<>> mColumns;
+
+	// Index of the first column of every row, followed by the total column count
+	std::vector<uint32_t> mRowOffsets;
 };
 
 class TabFile {
 public:
-	
+
 	typedef std::function<void(const TabFileRecord&)> Callback;
 
 	static void ParseFile(
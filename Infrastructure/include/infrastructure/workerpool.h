@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Worker threads that are kept around between batches of work, so batches that run
+ * every frame don't pay for starting threads, and the threads keep their thread_local
+ * scratch buffers. Start and Wait have to be called from the same thread.
+ */
+class WorkerPool {
+public:
+	WorkerPool() = default;
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Has threadCount of the workers (started as needed) run work once, without waiting for them
+	void Start(size_t threadCount, std::function<void()> work);
+
+	// Blocks until the workers are done with the work passed to Start
+	void Wait();
+
+private:
+	void Run(size_t idx);
+
+	std::vector<std::thread> mThreads;
+	std::mutex mMutex;
+	std::condition_variable mWorkPosted;
+	std::condition_variable mWorkDone;
+	std::function<void()> mWork;
+	uint64_t mGeneration = 0;
+	size_t mActiveCount = 0;
+	size_t mRunningCount = 0;
+	bool mStopping = false;
+};
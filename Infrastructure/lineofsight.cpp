@@ -0,0 +1,195 @@
+#include "infrastructure/lineofsight.h"
+
+#include <algorithm>
+
+void VisionBlockers::Reset(int originX, int originY, int width, int height) {
+	mOriginX = originX;
+	mOriginY = originY;
+	mWidth = width;
+	mHeight = height;
+	mCells.assign((size_t)width * height, 0);
+}
+
+namespace {
+
+	// Maps the coordinates of the first octant to the others (xx, xy, yx, yy)
+	constexpr int OctantTransforms[8][4] = {
+		{ 1, 0, 0, 1 },
+		{ 0, 1, 1, 0 },
+		{ 0, -1, 1, 0 },
+		{ -1, 0, 0, 1 },
+		{ -1, 0, 0, -1 },
+		{ 0, -1, -1, 0 },
+		{ 0, 1, -1, 0 },
+		{ 1, 0, 0, -1 }
+	};
+
+	struct ShadowCastScan {
+		const VisionBlockers &blockers;
+		int viewerX;
+		int viewerY;
+		int radius;
+		std::vector<uint32_t> &visible;
+
+		/*
+			Scans the rows starting at the given one for cells between the start and end slopes,
+			and recurses into the part of the next row that is visible next to a run of blockers.
+		*/
+		void ScanOctant(int row, float startSlope, float endSlope, const int (&transform)[4]) {
+			if (startSlope < endSlope) {
+				return;
+			}
+
+			auto radiusSquared = radius * radius;
+			auto nextStartSlope = startSlope;
+
+			for (auto distance = row; distance <= radius; distance++) {
+				auto dy = -distance;
+				auto blocked = false;
+
+				for (auto dx = -distance; dx <= 0; dx++) {
+					auto x = viewerX + dx * transform[0] + dy * transform[1];
+					auto y = viewerY + dx * transform[2] + dy * transform[3];
+
+					// Slopes of the corners of the cell
+					auto leftSlope = (dx - 0.5f) / (dy + 0.5f);
+					auto rightSlope = (dx + 0.5f) / (dy - 0.5f);
+
+					if (startSlope < rightSlope) {
+						continue;
+					}
+					if (endSlope > leftSlope) {
+						break;
+					}
+
+					if (dx * dx + dy * dy <= radiusSquared && blockers.Contains(x, y)) {
+						visible.push_back(blockers.GetIndex(x, y));
+					}
+
+					auto blocking = blockers.IsBlocking(x, y);
+					if (blocked) {
+						if (blocking) {
+							nextStartSlope = rightSlope;
+						} else {
+							blocked = false;
+							startSlope = nextStartSlope;
+						}
+					} else if (blocking && distance < radius) {
+						// The cells behind this run of blockers are hidden, so scan the ones beside it
+						blocked = true;
+						ScanOctant(distance + 1, startSlope, leftSlope, transform);
+						nextStartSlope = rightSlope;
+					}
+				}
+
+				if (blocked) {
+					break;
+				}
+			}
+		}
+	};
+
+}
+
+void ShadowCaster::Compute(const VisionBlockers &blockers, int viewerX, int viewerY, int radius,
+	std::vector<uint32_t> &visibleOut) {
+
+	visibleOut.clear();
+	if (!blockers.Contains(viewerX, viewerY)) {
+		return;
+	}
+
+	visibleOut.push_back(blockers.GetIndex(viewerX, viewerY));
+
+	ShadowCastScan scan{ blockers, viewerX, viewerY, radius, visibleOut };
+	for (auto &transform : OctantTransforms) {
+		scan.ScanOctant(1, 1.0f, 0.0f, transform);
+	}
+
+	// The cells on the borders of the octants are found twice
+	std::sort(visibleOut.begin(), visibleOut.end());
+	visibleOut.erase(std::unique(visibleOut.begin(), visibleOut.end()), visibleOut.end());
+}
+
+void LineOfSight::SetBlockers(const VisionBlockers &blockers) {
+	mBlockers = blockers;
+	mViewerCounts.assign((size_t)blockers.GetWidth() * blockers.GetHeight(), 0);
+	for (auto &viewer : mViewers) {
+		viewer.visible.clear();
+	}
+	InvalidateViewers();
+}
+
+void LineOfSight::SetBlocking(int x, int y, bool blocking) {
+	if (!mBlockers.Contains(x, y) || mBlockers.IsBlocking(x, y) == blocking) {
+		return;
+	}
+	mBlockers.SetBlocking(x, y, blocking);
+	InvalidateViewers();
+}
+
+void LineOfSight::SetViewer(size_t idx, int x, int y, int radius) {
+	if (idx >= mViewers.size()) {
+		mViewers.resize(idx + 1);
+	}
+
+	auto &viewer = mViewers[idx];
+	if (viewer.active && viewer.x == x && viewer.y == y && viewer.radius == radius) {
+		return;
+	}
+	viewer.active = true;
+	viewer.dirty = true;
+	viewer.x = x;
+	viewer.y = y;
+	viewer.radius = radius;
+}
+
+void LineOfSight::RemoveViewer(size_t idx) {
+	if (idx >= mViewers.size() || !mViewers[idx].active) {
+		return;
+	}
+	auto &viewer = mViewers[idx];
+	Uncount(viewer);
+	viewer.active = false;
+	viewer.dirty = false;
+}
+
+size_t LineOfSight::Update() {
+	size_t computed = 0;
+	for (auto &viewer : mViewers) {
+		if (!viewer.dirty) {
+			continue;
+		}
+		Uncount(viewer);
+		ShadowCaster::Compute(mBlockers, viewer.x, viewer.y, viewer.radius, viewer.visible);
+		for (auto cellIdx : viewer.visible) {
+			mViewerCounts[cellIdx]++;
+		}
+		viewer.dirty = false;
+		computed++;
+	}
+	return computed;
+}
+
+const std::vector<uint32_t>& LineOfSight::GetVisibleCells(size_t idx) const {
+	static const std::vector<uint32_t> sNone;
+	if (idx >= mViewers.size() || !mViewers[idx].active) {
+		return sNone;
+	}
+	return mViewers[idx].visible;
+}
+
+void LineOfSight::Uncount(Viewer &viewer) {
+	for (auto cellIdx : viewer.visible) {
+		mViewerCounts[cellIdx]--;
+	}
+	viewer.visible.clear();
+}
+
+void LineOfSight::InvalidateViewers() {
+	for (auto &viewer : mViewers) {
+		if (viewer.active) {
+			viewer.dirty = true;
+		}
+	}
+}
@@ -1,7 +1,13 @@
 
+#include <algorithm>
+
 #include "infrastructure/mesparser.h"
 #include "infrastructure/vfs.h"
 #include "infrastructure/logging.h"
+#include "infrastructure/exception.h"
+#include "infrastructure/stringutil.h"
+
+static std::string sCacheDir;
 
 class MesLexer {
 public:
@@ -23,7 +29,7 @@ private:
 	bool IsEof() const;
 	std::string mFilename;
 	std::string mToken;
-	std::string mContent;
+	const std::string &mContent;
 	size_t mContentPos = 0;
 	int mLine = 0;
 };
@@ -110,3 +116,229 @@ MesFile::Content MesFile::ParseString(const std::string& content, const std::str
 	return result;
 
 }
+
+static std::string GetCachePath(const std::string &filename) {
+	// Normalize the name, since the same file is referred to with both kinds of slashes
+	auto normalized = tolower(filename);
+	std::replace(normalized.begin(), normalized.end(), '/', '\\');
+	return fmt::format("{}\\{:016x}.mesb", sCacheDir, MesFile::HashContent(normalized));
+}
+
+// The size and modification time of the file, or 0 if it can't be found
+static uint64_t GetSourceStamp(const std::string &filename) {
+	auto found = vfs->Search(filename);
+	if (found.size() != 1 || found[0].dir) {
+		return 0;
+	}
+	return ((uint64_t)found[0].sizeInBytes << 32) | found[0].lastModified;
+}
+
+MesTable MesFile::ParseFileToTable(const std::string& filename) {
+	if (sCacheDir.empty()) {
+		return ParseStringToTable(vfs->ReadAsString(filename), filename);
+	}
+
+	// Checking the cache entry doesn't need the .mes file itself, so a warm start neither reads nor parses it
+	auto stamp = GetSourceStamp(filename);
+	auto cachePath = GetCachePath(filename);
+
+	MesTable table;
+	if (stamp && vfs->FileExists(cachePath)) {
+		try {
+			auto data = vfs->ReadAsBinary(cachePath);
+			if (MesTable::Deserialize(data, stamp, table)) {
+				return table;
+			}
+		} catch (TempleException &e) {
+			logger->debug("Unable to read cached {} from {}: {}", filename, cachePath, e.what());
+		}
+	}
+
+	table = ParseStringToTable(vfs->ReadAsString(filename), filename);
+	if (!stamp) {
+		return table;
+	}
+
+	try {
+		auto data = table.Serialize(stamp);
+		vfs->WriteBinaryFile(cachePath, data);
+	} catch (TempleException &e) {
+		logger->debug("Unable to cache {} in {}: {}", filename, cachePath, e.what());
+	}
+
+	return table;
+}
+
+MesTable MesFile::ParseStringToTable(const std::string& content, const std::string &filename) {
+
+	struct RawEntry {
+		int key;
+		uint32_t offset;
+		uint32_t length;
+	};
+	std::vector<RawEntry> entries;
+	std::string values;
+	values.reserve(content.size());
+
+	MesLexer lexer(filename, content);
+		
+	while (lexer.ReadNextToken()) {
+		size_t idx;
+		auto key = stoi(lexer.GetToken(), &idx);
+
+		if (idx == 0) {
+			logger->warn("Invalid numeric key @ {}:{}", filename, lexer.GetLine());
+		}
+
+		if (!lexer.ReadNextToken()) {
+			logger->warn("Key without value @ {}:{}", filename, lexer.GetLine());
+			break;
+		}
+
+		auto &token = lexer.GetToken();
+		entries.push_back({ key, (uint32_t)values.size(), (uint32_t)token.size() });
+		values.append(token);
+	}
+
+	std::stable_sort(entries.begin(), entries.end(), [](const RawEntry &a, const RawEntry &b) {
+		return a.key < b.key;
+	});
+
+	MesTable result;
+	result.mKeys.reserve(entries.size());
+	result.mOffsets.reserve(entries.size() + 1);
+	result.mBlob.reserve(values.size() + entries.size());
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		auto &entry = entries[i];
+		// Later definitions of a key replace earlier ones
+		if (i + 1 < entries.size() && entries[i + 1].key == entry.key) {
+			continue;
+		}
+		result.mKeys.push_back(entry.key);
+		result.mOffsets.push_back((uint32_t)result.mBlob.size());
+		result.mBlob.append(values, entry.offset, entry.length);
+		result.mBlob.push_back('\0');
+	}
+	result.mOffsets.push_back((uint32_t)result.mBlob.size());
+
+	return result;
+
+}
+
+void MesFile::SetCacheDir(const std::string &dir) {
+	sCacheDir = dir;
+	if (!sCacheDir.empty() && !vfs->DirExists(sCacheDir) && !vfs->MkDir(sCacheDir)) {
+		logger->warn("Unable to create .mes cache directory {}", sCacheDir);
+		sCacheDir.clear();
+	}
+}
+
+uint64_t MesFile::HashContent(const std::string &content) {
+	// 64-bit FNV-1a
+	uint64_t hash = 14695981039346656037ull;
+	for (auto ch : content) {
+		hash ^= (uint8_t)ch;
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+const char *MesTable::Find(int key) const {
+	auto it = std::lower_bound(mKeys.begin(), mKeys.end(), key);
+	if (it == mKeys.end() || *it != key) {
+		return nullptr;
+	}
+	return mBlob.data() + mOffsets[it - mKeys.begin()];
+}
+
+std::map<int, std::string> MesTable::ToMap() const {
+	std::map<int, std::string> result;
+	for (size_t i = 0; i < mKeys.size(); ++i) {
+		auto value = GetValue(i);
+		result.emplace_hint(result.end(), mKeys[i], std::string(value.data(), value.size()));
+	}
+	return result;
+}
+
+size_t MesTable::GetMemoryUsage() const {
+	return sizeof(MesTable)
+		+ mKeys.capacity() * sizeof(int)
+		+ mOffsets.capacity() * sizeof(uint32_t)
+		+ mBlob.capacity();
+}
+
+static constexpr uint32_t MesCacheMagic = 0x4253454D; // MESB
+static constexpr uint32_t MesCacheVersion = 2;
+
+struct MesCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t sourceStamp;
+	uint32_t count;
+	uint32_t blobSize;
+};
+
+std::vector<uint8_t> MesTable::Serialize(uint64_t sourceStamp) const {
+	MesCacheHeader header;
+	header.magic = MesCacheMagic;
+	header.version = MesCacheVersion;
+	header.sourceStamp = sourceStamp;
+	header.count = (uint32_t)mKeys.size();
+	header.blobSize = (uint32_t)mBlob.size();
+
+	auto keysSize = mKeys.size() * sizeof(int);
+	auto offsetsSize = mOffsets.size() * sizeof(uint32_t);
+
+	std::vector<uint8_t> result(sizeof(header) + keysSize + offsetsSize + mBlob.size());
+	auto out = result.data();
+	memcpy(out, &header, sizeof(header));
+	out += sizeof(header);
+	memcpy(out, mKeys.data(), keysSize);
+	out += keysSize;
+	memcpy(out, mOffsets.data(), offsetsSize);
+	out += offsetsSize;
+	memcpy(out, mBlob.data(), mBlob.size());
+	return result;
+}
+
+bool MesTable::Deserialize(gsl::span<const uint8_t> data, uint64_t sourceStamp, MesTable &table) {
+	MesCacheHeader header;
+	if ((size_t) data.size() < sizeof(header)) {
+		return false;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (header.magic != MesCacheMagic || header.version != MesCacheVersion || header.sourceStamp != sourceStamp) {
+		return false;
+	}
+
+	auto keysSize = (size_t)header.count * sizeof(int);
+	auto offsetsSize = ((size_t)header.count + 1) * sizeof(uint32_t);
+	if ((size_t) data.size() != sizeof(header) + keysSize + offsetsSize + header.blobSize) {
+		return false;
+	}
+
+	auto in = data.data() + sizeof(header);
+	table.mKeys.resize(header.count);
+	memcpy(table.mKeys.data(), in, keysSize);
+	in += keysSize;
+	table.mOffsets.resize(header.count + 1);
+	memcpy(table.mOffsets.data(), in, offsetsSize);
+	in += offsetsSize;
+	table.mBlob.assign(reinterpret_cast<const char*>(in), header.blobSize);
+
+	// Reject damaged files rather than handing out bad values later on
+	if (table.mOffsets[0] != 0 || table.mOffsets[header.count] != header.blobSize) {
+		return false;
+	}
+	for (size_t i = 0; i < header.count; ++i) {
+		if (table.mOffsets[i + 1] <= table.mOffsets[i] || table.mBlob[table.mOffsets[i + 1] - 1] != '\0') {
+			return false;
+		}
+		if (i > 0 && table.mKeys[i - 1] >= table.mKeys[i]) {
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -60,6 +60,7 @@ namespace aas {
 		std::unique_ptr<DX::XMFLOAT4[]> positions;
 		std::unique_ptr<DX::XMFLOAT4[]> normals;
 		bool fullyInitialized; // This could actually be: NEEDS UPDATE! (TODO)
+		uint32_t version = 0; // of the positions and normals, see gfx::Submesh::GetVersion
 		std::vector<SubmeshVertexClothStateWithoutFlag> cloth_vertices_without_flag;
 		std::vector<SubmeshVertexClothStateWithFlag> cloth_vertices_with_flag;
 		std::unique_ptr<uint16_t[]> indices;
@@ -1106,8 +1107,9 @@ namespace aas {
 			gsl::span<DX::XMFLOAT4> positions,
 			gsl::span<DX::XMFLOAT4> normals,
 			gsl::span<DX::XMFLOAT2> uv,
-			gsl::span<uint16_t> indices
-		) : vertexCount_(vertexCount), primitiveCount_(primitiveCount), positions_(positions), normals_(normals), uv_(uv), indices_(indices) {}
+			gsl::span<uint16_t> indices,
+			uint32_t version
+		) : vertexCount_(vertexCount), primitiveCount_(primitiveCount), positions_(positions), normals_(normals), uv_(uv), indices_(indices), version_(version) {}
 		SubmeshAdapter() {}
 
 		virtual int GetVertexCount() override
@@ -1134,6 +1136,10 @@ namespace aas {
 		{
 			return indices_;
 		}
+		virtual uint32_t GetVersion() override
+		{
+			return version_;
+		}
 
 	private:
 		int vertexCount_ = 0;
@@ -1142,6 +1148,7 @@ namespace aas {
 		gsl::span<DX::XMFLOAT4> normals_;
 		gsl::span<DX::XMFLOAT2> uv_;
 		gsl::span<uint16_t> indices_;
+		uint32_t version_ = 0;
 	};
 
 	std::unique_ptr<gfx::Submesh> AnimatedModel::GetSubmesh(int submeshIdx)
@@ -1151,181 +1158,222 @@ namespace aas {
 			return std::make_unique<SubmeshAdapter>();
 		}
 
+		if (PrepareSubmesh(submeshIdx)) {
+			SkinSubmesh(submeshIdx);
+			FinishSubmesh(submeshIdx);
+		}
+
+		auto &submesh = submeshes[submeshIdx];
+
+		// return;
+		// static auto method_org = temple::GetPointer<void __fastcall(AnimatedModel*, void*, int submesh_idx, int *vertex_count_out, XMFLOAT4 **positions_out, XMFLOAT4 **normals_out, XMFLOAT2 **uv_out, int *primitive_count_out, uint16_t **indices_out)>(0x102689c0);
+		// return method_org(this, 0, submesh_idx, vertex_count_out, positions_out, normals_out, uv_out, primitive_count_out, indices_out);
+
+		return std::make_unique<SubmeshAdapter>(
+			submesh.vertexCount,
+			submesh.primCount,
+			gsl::span(submesh.positions.get(), submesh.vertexCount),
+			gsl::span(submesh.normals.get(), submesh.vertexCount),
+			gsl::span(submesh.uv.get(), submesh.vertexCount),
+			gsl::span(submesh.indices.get(), submesh.primCount * 3),
+			submesh.version
+		);
+
+	}
+
+	void AnimatedModel::AddToSkinningBatch(gfx::SkinningBatch &batch)
+	{
+		for (int i = 0; i < (int) submeshes.size(); i++) {
+			if (PrepareSubmesh(i)) {
+				batch.Add(submeshes[i].vertexCount, [this, i]() { SkinSubmesh(i); }, [this, i]() { FinishSubmesh(i); });
+			}
+		}
+	}
+
+	bool AnimatedModel::PrepareSubmesh(int submeshIdx)
+	{
 		if (!submeshesValid) {
 			Method11();
 		}
 
+		Method19();
+
+		return submeshes[submeshIdx].fullyInitialized;
+	}
+
+	void AnimatedModel::SkinSubmesh(int submeshIdx)
+	{
 		auto &submesh = submeshes[submeshIdx];
 
-		Method19();
+		// The positions and normals of each bone, transformed by the bone's matrix.
+		// Per thread, so models can be skinned in parallel (see AddToSkinningBatch).
+		thread_local std::vector<DX::XMFLOAT4> bone_vecs_transformed;
 
-		if (submesh.fullyInitialized) {
-			static DX::XMFLOAT4A bone_floats_transformed[0x5FFF6];
-			
-			// The cur_pos "w" component is (in reality) the attachment weight
-			auto cur_float_in = submesh.bone_floats.get();
-			auto bones = skeleton->GetBones();
-			auto vec_out = &bone_floats_transformed[0];
-
-			for (int16_t bone_idx = 0; bone_idx <= bones.size(); bone_idx++) {
-				Matrix3x4 bone_matrix = boneMatrices[bone_idx];
-
-				auto elem_counts = submesh.bone_elem_counts[bone_idx];
-
-				for (int i = 0; i < elem_counts.position_count; i++) {
-					auto x = *(cur_float_in++);
-					auto y = *(cur_float_in++);
-					auto z = *(cur_float_in++);
-					auto weight = *(cur_float_in++);
-					vec_out->x = x * bone_matrix.m00 + y * bone_matrix.m01 + z * bone_matrix.m02 + weight * bone_matrix.m03;
-					vec_out->y = x * bone_matrix.m10 + y * bone_matrix.m11 + z * bone_matrix.m12 + weight * bone_matrix.m13;
-					vec_out->z = x * bone_matrix.m20 + y * bone_matrix.m21 + z * bone_matrix.m22 + weight * bone_matrix.m23;
-					vec_out++;
-				}
+		auto bone_count = skeleton->GetBones().size() + 1;
+		size_t vec_count = 0;
+		for (size_t bone_idx = 0; bone_idx < bone_count; bone_idx++) {
+			vec_count += submesh.bone_elem_counts[bone_idx].position_count + submesh.bone_elem_counts[bone_idx].normal_count;
+		}
+		if (bone_vecs_transformed.size() < vec_count) {
+			bone_vecs_transformed.resize(vec_count);
+		}
 
-				for (int i = 0; i < elem_counts.normal_count; i++) {
-					auto x = *(cur_float_in++);
-					auto y = *(cur_float_in++);
-					auto z = *(cur_float_in++);
-					vec_out->x = x * bone_matrix.m00 + y * bone_matrix.m01 + z * bone_matrix.m02;
-					vec_out->y = x * bone_matrix.m10 + y * bone_matrix.m11 + z * bone_matrix.m12;
-					vec_out->z = x * bone_matrix.m20 + y * bone_matrix.m21 + z * bone_matrix.m22;
-					vec_out++;
-				}
-			}
+		auto cur_float_in = submesh.bone_floats.get();
+		auto vec_out = bone_vecs_transformed.data();
 
-			if (submesh.vertexCount > 0) {
-				auto position_out = submesh.positions.get();
-				auto normal_out = submesh.normals.get();
-				auto cp_pos = submesh.vertex_copy_positions.get();
-				while (*cp_pos != -32768) {
-					*position_out = bone_floats_transformed[-(*cp_pos++  +1)];
-					while(*cp_pos >= 0) {
-						position_out->x += bone_floats_transformed[*cp_pos].x;
-						position_out->y += bone_floats_transformed[*cp_pos].y;
-						position_out->z += bone_floats_transformed[*cp_pos].z;
-						cp_pos++;
-					}
-					
-					*normal_out = bone_floats_transformed[-(*cp_pos++  +1)];
-					while(*cp_pos >= 0) {
-						normal_out->x += bone_floats_transformed[*cp_pos].x;
-						normal_out->y += bone_floats_transformed[*cp_pos].y;
-						normal_out->z += bone_floats_transformed[*cp_pos].z;
-						cp_pos++;
-					}
-					++position_out;
-					++normal_out;
-				}
+		for (size_t bone_idx = 0; bone_idx < bone_count; bone_idx++) {
+			auto &m = boneMatrices[bone_idx];
+
+			// A vector is transformed by x * col0 + y * col1 + z * col2 (+ w * col3 for positions)
+			auto col0 = DX::XMVectorSet(m.m00, m.m10, m.m20, 0);
+			auto col1 = DX::XMVectorSet(m.m01, m.m11, m.m21, 0);
+			auto col2 = DX::XMVectorSet(m.m02, m.m12, m.m22, 0);
+			auto col3 = DX::XMVectorSet(m.m03, m.m13, m.m23, 0);
+
+			auto elem_counts = submesh.bone_elem_counts[bone_idx];
+
+			// The position "w" component is (in reality) the attachment weight
+			for (int i = 0; i < elem_counts.position_count; i++) {
+				auto pos = DX::XMLoadFloat4((const DX::XMFLOAT4*) cur_float_in);
+				auto result = DX::XMVectorMultiply(DX::XMVectorSplatX(pos), col0);
+				result = DX::XMVectorMultiplyAdd(DX::XMVectorSplatY(pos), col1, result);
+				result = DX::XMVectorMultiplyAdd(DX::XMVectorSplatZ(pos), col2, result);
+				result = DX::XMVectorMultiplyAdd(DX::XMVectorSplatW(pos), col3, result);
+				DX::XMStoreFloat4(vec_out++, result);
+				cur_float_in += 4;
 			}
 
-			// Renormalize the normals if necessary
-			if (scale != 1.0f) {
-				auto normals = submesh.normals.get();
-				for (int i = 0; i < submesh.vertexCount; i++) {
-					auto v = DX::XMLoadFloat4(&normals[i]);
-					v = DX::XMVector3Normalize(v);
-					DX::XMStoreFloat4(&normals[i], v);
-				}
+			for (int i = 0; i < elem_counts.normal_count; i++) {
+				auto normal = DX::XMLoadFloat3((const DX::XMFLOAT3*) cur_float_in);
+				auto result = DX::XMVectorMultiply(DX::XMVectorSplatX(normal), col0);
+				result = DX::XMVectorMultiplyAdd(DX::XMVectorSplatY(normal), col1, result);
+				result = DX::XMVectorMultiplyAdd(DX::XMVectorSplatZ(normal), col2, result);
+				DX::XMStoreFloat4(vec_out++, result);
+				cur_float_in += 3;
 			}
+		}
 
-			if (hasClothBones) {
-				auto inverseSomeMatrix = invertOrthogonalAffineTransform(currentWorldMatrix);
+		if (submesh.vertexCount > 0) {
+			// Normals have to be renormalized if the model is scaled
+			auto renormalize = scale != 1.0f;
 
-				for (auto sphere = collisionSpheresHead.get(); sphere; sphere = sphere->next.get()) {
-					Method19();
-					auto boneMatrix = boneMatrices[sphere->boneId + 1];
-					makeMatrixOrthogonal(boneMatrix);
+			auto bone_vecs = bone_vecs_transformed.data();
+			auto position_out = submesh.positions.get();
+			auto normal_out = submesh.normals.get();
+			auto cp_pos = submesh.vertex_copy_positions.get();
+			while (*cp_pos != std::numeric_limits<short>::min()) {
+				auto position = DX::XMLoadFloat4(&bone_vecs[-(*cp_pos++ + 1)]);
+				while (*cp_pos >= 0) {
+					position = DX::XMVectorAdd(position, DX::XMLoadFloat4(&bone_vecs[*cp_pos++]));
+				}
+				DX::XMStoreFloat4(position_out++, position);
 
-					auto boneMult = multiplyMatrix3x4(boneMatrix, inverseSomeMatrix);
-					sphere->worldMatrix = boneMult;
-					sphere->worldMatrixInverse = invertOrthogonalAffineTransform(boneMult);
+				auto normal = DX::XMLoadFloat4(&bone_vecs[-(*cp_pos++ + 1)]);
+				while (*cp_pos >= 0) {
+					normal = DX::XMVectorAdd(normal, DX::XMLoadFloat4(&bone_vecs[*cp_pos++]));
 				}
-			
-				for (auto cylinder = collisionCylindersHead.get(); cylinder; cylinder = cylinder->next.get()) {
-					Method19();
-					auto boneMatrix = boneMatrices[cylinder->boneId + 1];
-					makeMatrixOrthogonal(boneMatrix);
-
-					auto boneMult = multiplyMatrix3x4(boneMatrix, inverseSomeMatrix);
-					cylinder->worldMatrix = boneMult;
-					cylinder->worldMatrixInverse = invertOrthogonalAffineTransform(boneMult);
+				if (renormalize) {
+					normal = DX::XMVector3Normalize(normal);
 				}
+				DX::XMStoreFloat4(normal_out++, normal);
+			}
+		}
+	}
+
+	void AnimatedModel::FinishSubmesh(int submeshIdx)
+	{
+		auto &submesh = submeshes[submeshIdx];
 
-				for (auto &state : submesh.cloth_vertices_with_flag) {
-					auto pos = submesh.positions[state.submesh_vertex_idx];
+		if (hasClothBones) {
+			auto inverseSomeMatrix = invertOrthogonalAffineTransform(currentWorldMatrix);
 
-					auto &pos_out = state.cloth_stuff1->clothStuff->clothVertexPos2[state.cloth_stuff_vertex_idx];
-					pos_out = transformPosition(inverseSomeMatrix, pos);
-				}
+			for (auto sphere = collisionSpheresHead.get(); sphere; sphere = sphere->next.get()) {
+				Method19();
+				auto boneMatrix = boneMatrices[sphere->boneId + 1];
+				makeMatrixOrthogonal(boneMatrix);
 
-				for (int i = 0; i < cloth_stuff1_count; i++) {
-					auto stuff1 = &cloth_stuff1[i];
-					if (stuff1->field_18) {
-						stuff1->clothStuff->UpdateBoneDistances();
-						stuff1->field_18 = 0;
-					}
+				auto boneMult = multiplyMatrix3x4(boneMatrix, inverseSomeMatrix);
+				sphere->worldMatrix = boneMult;
+				sphere->worldMatrixInverse = invertOrthogonalAffineTransform(boneMult);
+			}
+		
+			for (auto cylinder = collisionCylindersHead.get(); cylinder; cylinder = cylinder->next.get()) {
+				Method19();
+				auto boneMatrix = boneMatrices[cylinder->boneId + 1];
+				makeMatrixOrthogonal(boneMatrix);
+
+				auto boneMult = multiplyMatrix3x4(boneMatrix, inverseSomeMatrix);
+				cylinder->worldMatrix = boneMult;
+				cylinder->worldMatrixInverse = invertOrthogonalAffineTransform(boneMult);
+			}
+
+			for (auto &state : submesh.cloth_vertices_with_flag) {
+				auto pos = submesh.positions[state.submesh_vertex_idx];
+
+				auto &pos_out = state.cloth_stuff1->clothStuff->clothVertexPos2[state.cloth_stuff_vertex_idx];
+				pos_out = transformPosition(inverseSomeMatrix, pos);
+			}
+
+			for (int i = 0; i < cloth_stuff1_count; i++) {
+				auto stuff1 = &cloth_stuff1[i];
+				if (stuff1->field_18) {
+					stuff1->clothStuff->UpdateBoneDistances();
+					stuff1->field_18 = 0;
 				}
+			}
 
-				if (timeForClothSim > 0.0) {
-					for (int i = 0; i < cloth_stuff1_count; i++) {
-						cloth_stuff1[i].clothStuff->Simulate(timeForClothSim);
-						//static auto aas_cloth_stuff_sim_maybe = temple::GetPointer<void __fastcall(AasClothStuff*, void*, float)>(0x10269d50);
-						//aas_cloth_stuff_sim_maybe(cloth_stuff1[i].clothStuff, 0, timeForClothSim);
-					}
-					timeForClothSim = 0.0f;
+			if (timeForClothSim > 0.0) {
+				for (int i = 0; i < cloth_stuff1_count; i++) {
+					cloth_stuff1[i].clothStuff->Simulate(timeForClothSim);
+					//static auto aas_cloth_stuff_sim_maybe = temple::GetPointer<void __fastcall(AasClothStuff*, void*, float)>(0x10269d50);
+					//aas_cloth_stuff_sim_maybe(cloth_stuff1[i].clothStuff, 0, timeForClothSim);
 				}
+				timeForClothSim = 0.0f;
+			}
 
-				//auto someMatrixVec = DX::XMMatrixTranspose(DX::XMLoadFloat4x3((DX::XMFLOAT4X3*)&someMatrix));
-				//auto someMatrixInverse = DX::XMMatrixInverse(nullptr, someMatrixVec);
+			//auto someMatrixVec = DX::XMMatrixTranspose(DX::XMLoadFloat4x3((DX::XMFLOAT4X3*)&someMatrix));
+			//auto someMatrixInverse = DX::XMMatrixInverse(nullptr, someMatrixVec);
 
-				for (auto &cloth_vertex : submesh.cloth_vertices_without_flag) {
-					auto cloth_stuff_vertex_idx = cloth_vertex.cloth_stuff_vertex_idx;
-					auto submesh_vertex_idx = cloth_vertex.submesh_vertex_idx;
-					auto cloth_stuff1 = cloth_vertex.cloth_stuff1;
-				
-					auto &mesh_pos = submesh.positions[submesh_vertex_idx];
-					auto &cloth_pos = cloth_stuff1->clothStuff->clothVertexPos2[cloth_stuff_vertex_idx];
+			for (auto &cloth_vertex : submesh.cloth_vertices_without_flag) {
+				auto cloth_stuff_vertex_idx = cloth_vertex.cloth_stuff_vertex_idx;
+				auto submesh_vertex_idx = cloth_vertex.submesh_vertex_idx;
+				auto cloth_stuff1 = cloth_vertex.cloth_stuff1;
+			
+				auto &mesh_pos = submesh.positions[submesh_vertex_idx];
+				auto &cloth_pos = cloth_stuff1->clothStuff->clothVertexPos2[cloth_stuff_vertex_idx];
 
-					if (cloth_stuff1->bytePerClothVertex2[cloth_stuff_vertex_idx])
-					{
-						Matrix4x4 m = currentWorldMatrix;
-						m = m.inverse();
+				if (cloth_stuff1->bytePerClothVertex2[cloth_stuff_vertex_idx])
+				{
+					Matrix4x4 m = currentWorldMatrix;
+					m = m.inverse();
 
-						cloth_pos.x = m.m00 * mesh_pos.x + m.m01 * mesh_pos.y + m.m02 * mesh_pos.z + m.m03;
-						cloth_pos.y = m.m10 * mesh_pos.x + m.m11 * mesh_pos.y + m.m12 * mesh_pos.z + m.m13;
-						cloth_pos.z = m.m20 * mesh_pos.x + m.m21 * mesh_pos.y + m.m22 * mesh_pos.z + m.m23;
+					cloth_pos.x = m.m00 * mesh_pos.x + m.m01 * mesh_pos.y + m.m02 * mesh_pos.z + m.m03;
+					cloth_pos.y = m.m10 * mesh_pos.x + m.m11 * mesh_pos.y + m.m12 * mesh_pos.z + m.m13;
+					cloth_pos.z = m.m20 * mesh_pos.x + m.m21 * mesh_pos.y + m.m22 * mesh_pos.z + m.m23;
 
-						// DX::XMStoreFloat4(cloth_pos, DX::XMVector3TransformCoord(DX::XMLoadFloat4(mesh_pos), someMatrixInverse));
+					// DX::XMStoreFloat4(cloth_pos, DX::XMVector3TransformCoord(DX::XMLoadFloat4(mesh_pos), someMatrixInverse));
 
-						cloth_stuff1->bytePerClothVertex2[cloth_stuff_vertex_idx] = 0;
-						cloth_stuff1->field_18 = 1;
-					}
-					else
-					{
-						mesh_pos = transformPosition(currentWorldMatrix, cloth_pos);
-						// DX::XMStoreFloat4(mesh_pos, DX::XMVector3TransformCoord(DX::XMLoadFloat4(cloth_pos), someMatrixVec));
-					}
+					cloth_stuff1->bytePerClothVertex2[cloth_stuff_vertex_idx] = 0;
+					cloth_stuff1->field_18 = 1;
+				}
+				else
+				{
+					mesh_pos = transformPosition(currentWorldMatrix, cloth_pos);
+					// DX::XMStoreFloat4(mesh_pos, DX::XMVector3TransformCoord(DX::XMLoadFloat4(cloth_pos), someMatrixVec));
 				}
-
 			}
-		
-			submesh.fullyInitialized = false;
-		}
 
-		// return;
-		// static auto method_org = temple::GetPointer<void __fastcall(AnimatedModel*, void*, int submesh_idx, int *vertex_count_out, XMFLOAT4 **positions_out, XMFLOAT4 **normals_out, XMFLOAT2 **uv_out, int *primitive_count_out, uint16_t **indices_out)>(0x102689c0);
-		// return method_org(this, 0, submesh_idx, vertex_count_out, positions_out, normals_out, uv_out, primitive_count_out, indices_out);
+		}
 
-		return std::make_unique<SubmeshAdapter>(
-			submesh.vertexCount,
-			submesh.primCount,
-			gsl::span(submesh.positions.get(), submesh.vertexCount),
-			gsl::span(submesh.normals.get(), submesh.vertexCount),
-			gsl::span(submesh.uv.get(), submesh.vertexCount),
-			gsl::span(submesh.indices.get(), submesh.primCount * 3)
-		);
+		submesh.fullyInitialized = false;
 
+		// Every skinning pass (be it for a new animation frame, world matrix or cloth simulation step)
+		// gets a new version, unique across all models. Only called on the main thread.
+		static uint32_t lastSubmeshVersion = 0;
+		if (++lastSubmeshVersion == 0) {
+			++lastSubmeshVersion;
+		}
+		submesh.version = lastSubmeshVersion;
 	}
 
 	void AnimatedModel::AddRunningAnim(AnimPlayer *player)
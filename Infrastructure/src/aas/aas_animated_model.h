@@ -77,6 +77,12 @@ namespace aas {
 		void SetTime(float time, const Matrix3x4 &worldMatrix);
 		float GetCurrentFrame();
 		std::unique_ptr<gfx::Submesh> GetSubmesh(int submeshIdx);
+
+		/**
+		 * Adds the skinning of the submeshes that need it to the batch. After it has run,
+		 * GetSubmesh returns the results as long as the model hasn't changed in the meantime.
+		 */
+		void AddToSkinningBatch(gfx::SkinningBatch &batch);
 		void AddRunningAnim(AnimPlayer* player);
 		void RemoveRunningAnim(AnimPlayer* player);
 		int GetAnimCount();
@@ -107,6 +113,11 @@ namespace aas {
 	private:
 		AasSubmeshWithMaterial * GetOrAddSubmesh(AasMaterial material, IMaterialResolver *materialResolver);
 
+		// The steps of GetSubmesh. Only SkinSubmesh is safe to run on other threads (for different submeshes).
+		bool PrepareSubmesh(int submeshIdx); // returns whether the submesh needs to be skinned
+		void SkinSubmesh(int submeshIdx);
+		void FinishSubmesh(int submeshIdx);
+
 		std::unique_ptr<gfx::IRenderState> renderState_;
 
 		void CleanupAnimations(AnimPlayer *player);
@@ -219,6 +219,12 @@ namespace aas {
 			return model_.GetSubmesh(submeshIdx);
 		}
 
+		void AddToSkinningBatch(const gfx::AnimatedModelParams& params, gfx::SkinningBatch& batch) override {
+			auto aasParams(Convert(params));
+			aasSystem_.UpdateWorldMatrix(handle_, aasParams);
+			model_.AddToSkinningBatch(batch);
+		}
+
 		float GetHeight(int scale) override {
 			model_.SetScale(scale / 100.0f);
 			return model_.GetHeight();
@@ -27,6 +27,8 @@ struct AasRenderSubmeshData {
 	VertexBufferPtr uvBuffer;
 	IndexBufferPtr idxBuffer;
 	BufferBinding binding;
+	uint32_t version = 0; // of the submesh when the buffers were last updated
+	bool normalsRecalculated = false; // ... and whether its normals have been recalculated since
 
 	AasRenderSubmeshData(RenderingDevice &device) : binding(device.CreateMdfBufferBinding()) {
 	}
@@ -61,13 +63,36 @@ Renderer::Renderer(gfx::AnimatedModelFactory &aasFactory,
 
 Renderer::~Renderer() = default;
 
-AasRenderSubmeshData& Renderer::GetSubmeshData(AasRenderData& renderData, int submeshId, Submesh & submesh)
+AasRenderSubmeshData& Renderer::GetSubmeshData(AasRenderData& renderData, int submeshId, Submesh & submesh, bool recalculateNormals)
 {
 	if (!renderData.submeshes[submeshId]) {
 		renderData.submeshes[submeshId] = std::make_unique<AasRenderSubmeshData>(mDevice);
 	}
 
 	auto& submeshData = *renderData.submeshes[submeshId];
+
+	// Models that haven't been skinned again since the last update (idle, paused, or drawn again
+	// for another pass) can be drawn with the buffers as they are
+	auto version = submesh.GetVersion();
+	auto upToDate = submeshData.created && version != 0 && version == submeshData.version;
+	if (!upToDate) {
+		submeshData.normalsRecalculated = false;
+	}
+	submeshData.version = version;
+
+	// The normals are recalculated in place, so once is enough for each version
+	auto recalcNormals = recalculateNormals && !submeshData.normalsRecalculated;
+	if (recalcNormals) {
+		RecalcNormals(
+			submesh.GetVertexCount(),
+			submesh.GetPositions().data(),
+			submesh.GetNormals().data(),
+			submesh.GetPrimitiveCount(),
+			submesh.GetIndices().data()
+		);
+		submeshData.normalsRecalculated = true;
+	}
+
 	if (!submeshData.created) {
 		submeshData.posBuffer = mDevice.CreateVertexBuffer(submesh.GetPositions(), false);
 		submeshData.normalsBuffer = mDevice.CreateVertexBuffer(submesh.GetNormals(), false);
@@ -82,9 +107,16 @@ AasRenderSubmeshData& Renderer::GetSubmeshData(AasRenderData& renderData, int su
 			.AddElement(VertexElementType::Float2, VertexElementSemantic::TexCoord);
 
 		submeshData.created = true;
-	} else {
+		mBufferStats.updated++;
+	} else if (!upToDate) {
 		submeshData.posBuffer->Update(submesh.GetPositions());
 		submeshData.normalsBuffer->Update(submesh.GetNormals());
+		mBufferStats.updated++;
+	} else if (recalcNormals) {
+		submeshData.normalsBuffer->Update(submesh.GetNormals());
+		mBufferStats.updated++;
+	} else {
+		mBufferStats.reused++;
 	}
 
 	return submeshData;
@@ -221,18 +253,7 @@ void Renderer::Render(gfx::AnimatedModel *model,
 
 		material->Bind(mDevice, lights, materialOverrides);
 
-		// Do we have to recalculate the normals?
-		if (material->GetSpec()->recalculateNormals) {
-			RecalcNormals(
-				submesh->GetVertexCount(),
-				submesh->GetPositions().data(),
-				submesh->GetNormals().data(),
-				submesh->GetPrimitiveCount(),
-				submesh->GetIndices().data()
-			);
-		}
-
-		auto &submeshData = GetSubmeshData(renderData, i, *submesh);
+		auto &submeshData = GetSubmeshData(renderData, i, *submesh, material->GetSpec()->recalculateNormals);
 		submeshData.binding.Bind();
 
 		mDevice.SetIndexBuffer(*submeshData.idxBuffer);
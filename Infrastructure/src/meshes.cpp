@@ -5,6 +5,11 @@
 
 #include <DirectXCollision.h>
 
+#include <atomic>
+#include <thread>
+
+#include "infrastructure/workerpool.h"
+
 using namespace gfx;
 using namespace DirectX;
 
@@ -399,3 +404,44 @@ float gfx::AnimatedModel::GetDistanceToMesh(const AnimatedModelParams & params,
 	return closestDist;
 
 }
+
+void gfx::SkinningBatch::Add(int vertexCount, std::function<void()> skin, std::function<void()> finish)
+{
+	mJobs.push_back({ std::move(skin), std::move(finish) });
+	mVertexCount += vertexCount;
+}
+
+// Shared by all batches, since they run every frame
+static WorkerPool sSkinningWorkers;
+
+void gfx::SkinningBatch::Run()
+{
+	// Below this, handing the jobs to the workers takes longer than the skinning itself
+	constexpr int MinParallelVertexCount = 8192;
+
+	std::atomic<int> nextJob{ 0 };
+	auto skinJobs = [&]() {
+		for (int jobIdx = nextJob++; jobIdx < (int)mJobs.size(); jobIdx = nextJob++) {
+			mJobs[jobIdx].skin();
+		}
+	};
+
+	// This thread skins as well, so one worker fewer is needed
+	size_t workerCount = 0;
+	if (mVertexCount >= MinParallelVertexCount && mJobs.size() > 1) {
+		workerCount = std::min<size_t>(mJobs.size(), std::max(1u, std::thread::hardware_concurrency())) - 1;
+	}
+	if (workerCount > 0) {
+		sSkinningWorkers.Start(workerCount, skinJobs);
+	}
+	skinJobs();
+	if (workerCount > 0) {
+		sSkinningWorkers.Wait();
+	}
+
+	for (auto& job : mJobs) {
+		job.finish();
+	}
+	mJobs.clear();
+	mVertexCount = 0;
+}
@@ -1,4 +1,6 @@
 
+#include <algorithm>
+#include <thread>
 #include <vector>
 
 #include <gsl/string_span>
@@ -11,79 +13,136 @@ std::string TabFileRecord::mMissingColumn;
 
 using strview = gsl::cstring_span<gsl::dynamic_extent>;
 
+// Files smaller than this are not worth splitting across threads
+static constexpr size_t MinChunkSize = 256 * 1024;
+
 static strview PostProcessColumn(strview column);
 
-class LineReader {
-public:
-	LineReader(const std::string &content) : mContent(content) {
-	}
+static bool IsLineEnd(char ch) {
+	return ch == '\n' || ch == '\r';
+}
 
-	bool NextLine() {
+/**
+ * Parses the lines of a chunk into columns. Empty lines are skipped entirely.
+ * rowEnds receives the end of every row as an index into columns.
+ */
+static void ParseChunk(strview chunk, std::vector<strview> &columns, std::vector<uint32_t> &rowEnds) {
+	size_t pos = 0;
+	auto size = (size_t) chunk.size();
 
+	while (pos < size) {
 		// Skip all \r\n
-		while (!IsAtEnd() && IsAtLineEnd()) {
-			mPos++;
+		if (IsLineEnd(chunk[pos])) {
+			pos++;
+			continue;
 		}
 
-		if (IsAtEnd()) {
-			return false;
+		auto lineStart = pos;
+		while (pos < size && !IsLineEnd(chunk[pos])) {
+			pos++;
 		}
-
-		auto start = mPos;
-		size_t count = 0;
-		while (!IsAtEnd() && !IsAtLineEnd()) {
-			mPos++;
-			count++;
+		auto line = chunk.subspan(lineStart, pos - lineStart);
+
+		// Columns are separated by tabs, but a tab at the end of the line does not start another column
+		size_t colPos = 0;
+		auto lineSize = (size_t) line.size();
+		while (colPos < lineSize) {
+			auto colStart = colPos;
+			while (colPos < lineSize && line[colPos] != '\t') {
+				colPos++;
+			}
+			columns.push_back(PostProcessColumn(line.subspan(colStart, colPos - colStart)));
+			colPos++; // Skip the tab
 		}
-		
-		mCurLine = strview(&mContent[start], count);
-		return true;
+
+		rowEnds.push_back((uint32_t) columns.size());
 	}
+}
+
+TabFileTable::TabFileTable(std::string content) : mContent(std::make_unique<std::string>(std::move(content)))
+{
+	Parse(*mContent);
+}
+
+TabFileTable TabFileTable::FromView(gsl::cstring_span<> content)
+{
+	TabFileTable result;
+	result.Parse(content);
+	return result;
+}
+
+TabFileTable TabFileTable::FromFile(const std::string &filename)
+{
+	return TabFileTable(vfs->ReadAsString(filename));
+}
+
+void TabFileTable::Parse(gsl::cstring_span<> content)
+{
+	auto size = (size_t) content.size();
 
-	strview GetLine() const {
-		return mCurLine;
+	size_t chunkCount = std::max<size_t>(1, std::min<size_t>(std::thread::hardware_concurrency(), size / MinChunkSize));
+
+	// Split the content into chunks that each start at the beginning of a line
+	std::vector<strview> chunks;
+	size_t chunkStart = 0;
+	for (size_t i = 1; i < chunkCount && chunkStart < size; ++i) {
+		auto chunkEnd = std::max(chunkStart, i * size / chunkCount);
+		while (chunkEnd < size && !IsLineEnd(content[chunkEnd])) {
+			chunkEnd++;
+		}
+		chunks.push_back(content.subspan(chunkStart, chunkEnd - chunkStart));
+		chunkStart = chunkEnd;
 	}
+	chunks.push_back(content.subspan(chunkStart, size - chunkStart));
 
-private:
-	strview mCurLine;
-	const std::string &mContent;
-	size_t mPos = 0;
+	mRowOffsets.clear();
+	mRowOffsets.push_back(0);
 
-	bool IsAtEnd() const {
-		return mPos >= mContent.size();
+	if (chunks.size() == 1) {
+		ParseChunk(chunks[0], mColumns, mRowOffsets);
+		return;
 	}
 
-	bool IsAtLineEnd() const {
-		auto ch = mContent[mPos];
-		return ch == '\n' || ch == '\r';
+	std::vector<std::vector<strview>> chunkColumns(chunks.size());
+	std::vector<std::vector<uint32_t>> chunkRowEnds(chunks.size());
+	std::vector<std::thread> threads;
+	for (size_t i = 1; i < chunks.size(); ++i) {
+		threads.emplace_back([&, i]() {
+			ParseChunk(chunks[i], chunkColumns[i], chunkRowEnds[i]);
+		});
+	}
+	ParseChunk(chunks[0], chunkColumns[0], chunkRowEnds[0]);
+	for (auto &thread : threads) {
+		thread.join();
 	}
-};
+
+	// Stitch the chunks together, rebasing each chunk's row ends onto the combined column list
+	size_t totalColumns = 0, totalRows = 0;
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		totalColumns += chunkColumns[i].size();
+		totalRows += chunkRowEnds[i].size();
+	}
+	mColumns.reserve(totalColumns);
+	mRowOffsets.reserve(totalRows + 1);
+
+	for (size_t i = 0; i < chunks.size(); ++i) {
+		auto base = (uint32_t) mColumns.size();
+		mColumns.insert(mColumns.end(), chunkColumns[i].begin(), chunkColumns[i].end());
+		for (auto rowEnd : chunkRowEnds[i]) {
+			mRowOffsets.push_back(base + rowEnd);
+		}
+	}
+}
 
 void TabFile::ParseFile(const std::string & filename, const Callback & callback)
 {
-	auto content = vfs->ReadAsString(filename);
-	ParseString(content, callback);
+	auto table = TabFileTable::FromFile(filename);
+	table.ForEachRow(callback);
 }
 
 void TabFile::ParseString(const std::string &content, const TabFile::Callback &callback) {
-	TabFileRecord record;
-	
-	LineReader reader(content);
-	while (reader.NextLine()) {
-		auto line = reader.GetLine();
-		
-		record.mColumns.clear();
-		split(line, '\t', record.mColumns, false, true);
-
-		// Post-Process the columns
-		for (auto& column : record.mColumns) {
-			column = PostProcessColumn(column);
-		}
-
-		callback(record);
-		record.mLineNumber++;
-	}
-
+	auto table = TabFileTable::FromView(content);
+	table.ForEachRow(callback);
 }
 
 static strview PostProcessColumn(strview column) {
@@ -103,3 +162,69 @@ static strview PostProcessColumn(strview column) {
 		return column;
 	}
 }
+
+TabFileEnumIndex::TabFileEnumIndex(std::vector<std::string> names) : mNames(std::move(names))
+{
+	Expects(mNames.size() < INT16_MAX);
+
+	size_t tableSize = 4;
+	while (tableSize < mNames.size() * 2) {
+		tableSize *= 2;
+	}
+
+	// Search for a seed that maps every name to its own slot, growing the
+	// table if none can be found quickly. The name lists are short enum
+	// mappings, so this settles almost immediately.
+	for (;;) {
+		mMask = (uint32_t) tableSize - 1;
+		for (uint32_t seed = 1; seed <= 64; ++seed) {
+			mSlots.assign(tableSize, -1);
+			bool collision = false;
+			for (size_t i = 0; i < mNames.size() && !collision; ++i) {
+				auto slot = Hash(mNames[i].data(), mNames[i].size(), seed) & mMask;
+				if (mSlots[slot] != -1) {
+					collision = true;
+				} else {
+					mSlots[slot] = (int16_t) i;
+				}
+			}
+			if (!collision) {
+				mSeed = seed;
+				return;
+			}
+		}
+		tableSize *= 2;
+	}
+}
+
+int TabFileEnumIndex::Find(gsl::cstring_span<> text) const
+{
+	auto length = (size_t) text.size();
+
+	auto candidate = mSlots[Hash(text.data(), length, mSeed) & mMask];
+	if (candidate != -1) {
+		auto &name = mNames[candidate];
+		if (name.size() == length && !_strnicmp(name.data(), text.data(), length)) {
+			return candidate;
+		}
+	}
+
+	for (size_t i = 0; i < mNames.size(); ++i) {
+		if (mNames[i].size() >= length && !_strnicmp(mNames[i].data(), text.data(), length)) {
+			return (int) i;
+		}
+	}
+
+	return -1;
+}
+
+uint32_t TabFileEnumIndex::Hash(const char *text, size_t length, uint32_t seed)
+{
+	// FNV-1a over the lowercased text
+	uint32_t hash = 2166136261u ^ (seed * 16777619u);
+	for (size_t i = 0; i < length; ++i) {
+		hash ^= (uint8_t) tolower((unsigned char) text[i]);
+		hash *= 16777619u;
+	}
+	return hash;
+}
@@ -4,6 +4,7 @@
 #include <cstdio>
 #include <sys/stat.h>
 #include <direct.h>
+#include <io.h>
 
 #include "infrastructure/exception.h"
 #include <fmt/format.h>
@@ -81,7 +82,29 @@ public:
 	}
 
 	std::vector<VfsSearchResult> Search(std::string_view globPattern) override {
-		throw TempleException("Unsupported Operation");
+		std::vector<VfsSearchResult> result;
+
+		_finddata_t data;
+		auto handle = _findfirst(std::string(globPattern).c_str(), &data);
+		if (handle == -1) {
+			return result;
+		}
+
+		do {
+			std::string name(data.name);
+			if (name == "." || name == "..") {
+				continue;
+			}
+			VfsSearchResult entry;
+			entry.filename = name;
+			entry.dir = (data.attrib & _A_SUBDIR) != 0;
+			entry.sizeInBytes = data.size;
+			entry.lastModified = (uint32_t)data.time_write;
+			result.push_back(entry);
+		} while (_findnext(handle, &data) == 0);
+
+		_findclose(handle);
+		return result;
 	}
 	bool RemoveDir(std::string_view path) override {
 		throw TempleException("Unsupported Operation");
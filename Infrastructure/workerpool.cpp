@@ -0,0 +1,51 @@
+
+#include "infrastructure/workerpool.h"
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mStopping = true;
+	}
+	mWorkPosted.notify_all();
+	for (auto &thread : mThreads) {
+		thread.join();
+	}
+}
+
+void WorkerPool::Start(size_t threadCount, std::function<void()> work) {
+	std::lock_guard<std::mutex> lock(mMutex);
+	while (mThreads.size() < threadCount) {
+		mThreads.emplace_back(&WorkerPool::Run, this, mThreads.size());
+	}
+	mWork = std::move(work);
+	mActiveCount = threadCount;
+	mRunningCount = threadCount;
+	mGeneration++;
+	mWorkPosted.notify_all();
+}
+
+void WorkerPool::Wait() {
+	std::unique_lock<std::mutex> lock(mMutex);
+	mWorkDone.wait(lock, [&] { return mRunningCount == 0; });
+	mWork = nullptr;
+}
+
+void WorkerPool::Run(size_t idx) {
+	uint64_t generationDone = 0;
+	std::unique_lock<std::mutex> lock(mMutex);
+	while (true) {
+		mWorkPosted.wait(lock, [&] { return mStopping || (mGeneration != generationDone && idx < mActiveCount); });
+		if (mStopping) {
+			return;
+		}
+		generationDone = mGeneration;
+
+		lock.unlock();
+		mWork();
+		lock.lock();
+
+		if (--mRunningCount == 0) {
+			mWorkDone.notify_all();
+		}
+	}
+}
@@ -11,12 +11,12 @@
 
 namespace particles {
 
-	static const std::map<std::string, PartSysCoordSys> CoordSysMapping = {
+	static const TabFileEnumLookup<PartSysCoordSys> CoordSysMapping = {
 		{"Cartesian", PartSysCoordSys::Cartesian},
 		{"Polar", PartSysCoordSys::Polar}
 	};
 
-	static const std::map<std::string, PartSysEmitterSpace> EmitterSpaceMapping = {
+	static const TabFileEnumLookup<PartSysEmitterSpace> EmitterSpaceMapping = {
 		{"World", PartSysEmitterSpace::World},
 		{"Object Pos", PartSysEmitterSpace::ObjectPos},
 		{"Object YPR", PartSysEmitterSpace::ObjectYpr},
@@ -25,7 +25,7 @@ namespace particles {
 		{"Bones", PartSysEmitterSpace::Bones}
 	};
 
-	static const std::map<std::string, PartSysParticleType> ParticleTypeMapping = {
+	static const TabFileEnumLookup<PartSysParticleType> ParticleTypeMapping = {
 		{"Point", PartSysParticleType::Point},
 		{"Sprite", PartSysParticleType::Sprite},
 		{"Disc", PartSysParticleType::Disc},
@@ -33,14 +33,14 @@ namespace particles {
 		{"Model", PartSysParticleType::Model}
 	};
 
-	static const std::map<std::string, PartSysBlendMode> BlendModeMapping = {
+	static const TabFileEnumLookup<PartSysBlendMode> BlendModeMapping = {
 		{"Add", PartSysBlendMode::Add},
 		{"Blend", PartSysBlendMode::Blend},
 		{"Multiply", PartSysBlendMode::Multiply},
 		{"Subtract", PartSysBlendMode::Subtract}
 	};
 
-	static const std::map<std::string, PartSysParticleSpace> ParticleSpaceMapping = {
+	static const TabFileEnumLookup<PartSysParticleSpace> ParticleSpaceMapping = {
 		{"World", PartSysParticleSpace::World},
 		{"Emitter YPR", PartSysParticleSpace::EmitterYpr},
 		{"Same as Emitter", PartSysParticleSpace::SameAsEmitter}
@@ -93,7 +93,7 @@ namespace particles {
 	static void ParseOptionalEnum(const TabFileRecord& record,
 	                              int col,
 	                              const char* name,
-	                              const std::map<std::string, T>& mapping,
+	                              const TabFileEnumLookup<T>& mapping,
 	                              const std::function<void(T)>& setter) {
 		T value;
 		auto column = record[col];
@@ -764,7 +764,21 @@ BOOL AiSystem::ConsiderTarget(objHndl obj, objHndl tgt)
 	return 1;
 }
 
-objHndl AiSystem::GetFriendsCombatFocus(objHndl handle, objHndl friendHandle, objHndl leader){
+// Short distance pathfinding, used to simulate sensing nearby critters (new in Temple+)
+static PathQueryFlags GetSensingPathFlags(){
+	auto pathFlags = PathQueryFlags::PQF_HAS_CRITTER | PQF_IGNORE_CRITTERS
+		| PathQueryFlags::PQF_800 | PathQueryFlags::PQF_TARGET_OBJ
+		| PathQueryFlags::PQF_ADJUST_RADIUS | PathQueryFlags::PQF_ADJ_RADIUS_REQUIRE_LOS
+		| PathQueryFlags::PQF_DONT_USE_PATHNODES | PathQueryFlags::PQF_A_STAR_TIME_CAPPED;
+
+	if (!config.alertAiThroughDoors) {
+		pathFlags |= PathQueryFlags::PQF_DOORS_ARE_BLOCKING;
+	}
+	return (PathQueryFlags)pathFlags;
+}
+
+objHndl AiSystem::GetFriendsCombatFocus(objHndl handle, objHndl friendHandle, objHndl leader, bool &needsPath){
+	needsPath = false;
 	auto tgtObj = objSystem->GetObject(friendHandle);
 	if (tgtObj->IsNPC()) {
 		AiFightStatus aifs;
@@ -789,24 +803,8 @@ objHndl AiSystem::GetFriendsCombatFocus(objHndl handle, objHndl friendHandle, ob
 				}
 				else {
 					// new in Temple+ : check pathfinding short distances (to simulate sensing nearby critters)
-					auto pathFlags = PathQueryFlags::PQF_HAS_CRITTER | PQF_IGNORE_CRITTERS
-						| PathQueryFlags::PQF_800 | PathQueryFlags::PQF_TARGET_OBJ
-						| PathQueryFlags::PQF_ADJUST_RADIUS | PathQueryFlags::PQF_ADJ_RADIUS_REQUIRE_LOS
-						| PathQueryFlags::PQF_DONT_USE_PATHNODES | PathQueryFlags::PQF_A_STAR_TIME_CAPPED;
-
-					if (!config.alertAiThroughDoors) {
-						pathFlags |= PathQueryFlags::PQF_DOORS_ARE_BLOCKING;
-					}
-
-					if (pathfindingSys.CanPathTo(handle, targetsFocus, (PathQueryFlags)pathFlags, 40)) {
-						return targetsFocus;
-					}
-					else if (!party.IsInParty(handle)) {
-						auto partyTgt = pathfindingSys.CanPathToParty(handle);
-						if (partyTgt) {
-							return partyTgt;
-						}
-					}
+					needsPath = true;
+					return targetsFocus;
 				}
 			}
 
@@ -863,6 +861,43 @@ objHndl AiSystem::FindSuitableTarget(objHndl handle){
 		}
 	}
 
+	// The friends' combat foci that can only be sensed by pathing to them are checked in one FindPaths batch,
+	// made the first time one of them is needed, for that friend and all the ones behind it
+	std::vector<objHndl> pathTargets;
+	std::vector<bool> canPath;
+	auto pathsChecked = false;
+	auto canPathToFocus = [&](int idx, objHndl focus) {
+		if (!pathsChecked) {
+			pathsChecked = true;
+			for (auto j = idx; j < numCritters; j++) {
+				auto other = critterList[j];
+				if (other == handle)
+					continue;
+				int isUnconcealed = !critterSys.IsMovingSilently(other)
+					&& !critterSys.IsConcealed(other);
+				if (aiSys.CannotHear(handle, other, isUnconcealed) && critterSys.HasLineOfSight(handle, other))
+					continue;
+				bool needsPath;
+				auto otherFocus = aiSys.GetFriendsCombatFocus(handle, other, leader, needsPath);
+				if (otherFocus && needsPath && std::find(pathTargets.begin(), pathTargets.end(), otherFocus) == pathTargets.end()) {
+					pathTargets.push_back(otherFocus);
+				}
+			}
+			pathfindingSys.CanPathTo(handle, pathTargets, canPath, GetSensingPathFlags(), 40);
+		}
+
+		auto it = std::find(pathTargets.begin(), pathTargets.end(), focus);
+		if (it != pathTargets.end()) {
+			return (bool)canPath[it - pathTargets.begin()];
+		}
+		// the focus has changed since the batch
+		return pathfindingSys.CanPathTo(handle, focus, GetSensingPathFlags(), 40);
+	};
+
+	// doesn't depend on the friend, so it's only checked once
+	auto partyTgt = objHndl::null;
+	auto partyChecked = false;
+
 	auto kosCandidate = objHndl::null;
 	for (auto i =0; i < numCritters; i++){
 		auto target = critterList[i];
@@ -886,7 +921,18 @@ objHndl AiSystem::FindSuitableTarget(objHndl handle){
 				break;
 			}
 
-			auto friendsCombatFocus = aiSys.GetFriendsCombatFocus(handle, target, leader);
+			bool needsPath;
+			auto friendsCombatFocus = aiSys.GetFriendsCombatFocus(handle, target, leader, needsPath);
+			if (friendsCombatFocus && needsPath && !canPathToFocus(i, friendsCombatFocus)){
+				friendsCombatFocus = objHndl::null;
+				if (!party.IsInParty(handle)) {
+					if (!partyChecked) {
+						partyTgt = pathfindingSys.CanPathToParty(handle);
+						partyChecked = true;
+					}
+					friendsCombatFocus = partyTgt;
+				}
+			}
 			if (friendsCombatFocus){
 				kosCandidate = friendsCombatFocus;
 				break;
@@ -1150,6 +1196,14 @@ void AiSystem::AlertAllies2(objHndl handle, objHndl alertFrom)
 	// test cases:
 	// moathouse frogs - 12 is enough to pull them all in
 	objList.ListRangeTiles(handle, ALLY_ALERTING_DISTANCE, OLC_CRITTERS);
+
+	struct AllyToAlert {
+		objHndl handle;
+		int pathIdx; // into pathTargets if it has to be reachable, -1 otherwise
+	};
+	std::vector<AllyToAlert> allies;
+	std::vector<objHndl> pathTargets;
+
 	for (auto i = 0; i < objList.size(); i++) {
 		auto resHandle = objList[i];
 		if (!resHandle)
@@ -1177,22 +1231,31 @@ void AiSystem::AlertAllies2(objHndl handle, objHndl alertFrom)
 			if (locSys.DistanceToObj(handle, resHandle) > 30) {
 				continue;
 			}
-			// check pathfinding short distances
-			auto pathFlags = PathQueryFlags::PQF_HAS_CRITTER | PQF_IGNORE_CRITTERS
-				| PathQueryFlags::PQF_800 | PathQueryFlags::PQF_TARGET_OBJ
-				| PathQueryFlags::PQF_ADJUST_RADIUS | PathQueryFlags::PQF_ADJ_RADIUS_REQUIRE_LOS
-				| PathQueryFlags::PQF_DONT_USE_PATHNODES | PathQueryFlags::PQF_A_STAR_TIME_CAPPED;
-
-			if (!config.alertAiThroughDoors) {
-				pathFlags |= PathQueryFlags::PQF_DOORS_ARE_BLOCKING;
-			}
+			allies.push_back({ resHandle, (int)pathTargets.size() });
+			pathTargets.push_back(resHandle);
+			continue;
+		}
 
-			if (!pathfindingSys.CanPathTo(handle, resHandle, (PathQueryFlags)pathFlags, 40)) {
-				//logger->debug("Failed to alert {} because of PF distance", resHandle);
-				continue;
-			}
+		allies.push_back({ resHandle, -1 });
+	}
+
+	// check pathfinding short distances, for all of them at once
+	std::vector<bool> canPath;
+	if (!pathTargets.empty()) {
+		pathfindingSys.CanPathTo(handle, pathTargets, canPath, GetSensingPathFlags(), 40);
+	}
+
+	for (auto& ally : allies) {
+		auto resHandle = ally.handle;
+		if (ally.pathIdx != -1 && !canPath[ally.pathIdx]) {
+			//logger->debug("Failed to alert {} because of PF distance", resHandle);
+			continue;
 		}
 
+		// may have joined the fight already when the ones before were alerted
+		if (tbSys.IsInInitiativeList(resHandle) || critterSys.IsCombatModeActive(resHandle))
+			continue;
+
 		if (aiSys.GetAllegianceStrength(resHandle, handle)) { // check that they have a faction in common
 			aiSys.ProvokeHostility(alertFrom, resHandle, 3, 0);
 			continue;
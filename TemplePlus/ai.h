@@ -174,7 +174,8 @@ struct AiSystem : temple::AddressTable
 	objHndl GetCombatFocus(objHndl npc);
 	objHndl GetWhoHitMeLast(objHndl npc);
 	BOOL ConsiderTarget(objHndl obj, objHndl tgt); // checks if it's a good target
-	objHndl GetFriendsCombatFocus(objHndl handle, objHndl friendHandle, objHndl leader);
+	// The combat focus of friendHandle if handle should join in; needsPath is set if handle can only sense it by pathing to it
+	objHndl GetFriendsCombatFocus(objHndl handle, objHndl friendHandle, objHndl leader, bool &needsPath);
 	objHndl FindSuitableTarget(objHndl handle); // was 0x1005CED0;
 	int CannotHate(objHndl aiHandle, objHndl triggerer, objHndl aiLeader);
 	int WillKos(objHndl aiHandle, objHndl triggerer); // does the triggerer provoke KOS hostility
@@ -750,6 +750,7 @@ void _CondNodeAddToSubDispNodeArray(Dispatcher* dispatcher, CondNode* condNode)
 			dispatcher->subDispNodes[subDispDef->dispType] = subDispNodeNew;
 		}
 
+		_DispatcherIndexSubDispNode(dispatcher, subDispNodeNew);
 
 		subDispDef += 1;
 	}
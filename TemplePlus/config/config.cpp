@@ -191,6 +191,7 @@ static ConfigSetting configSettings[] = {
 	CONF_BOOL(nonCoreMaterials),
 	CONF_BOOL(tolerantNpcs),
 	CONF_STRING(fogOfWar),
+	CONF_BOOL(nativeLineOfSight),
 	CONF_DOUBLE(speedupFactor),
 	CONF_BOOL(fastSneakAnim),
 	CONF_BOOL(disableScreenShake),
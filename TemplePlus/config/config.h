@@ -110,6 +110,7 @@ struct TemplePlusConfig
 	bool tolerantNpcs = false; // NPCs tolerate monster party members
 	std::string fogOfWar = "Normal";
 	bool disableFogOfWar = false; // Previously: -nofog
+	bool nativeLineOfSight = false; // computes the party's line of sight for the fog of war with TemplePlus' own shadowcasting instead of the vanilla fog checks
 	double speedupFactor = 1.0;
 	bool equalizeMoveSpeed = true;
 	bool fastSneakAnim = false;
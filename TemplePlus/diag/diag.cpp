@@ -8,6 +8,7 @@
 #include <animgoals/anim.h>
 #include <graphics/device.h>
 #include <graphics/textures.h>
+#include <aas/aas_renderer.h>
 
 #include "../gamesystems/gamesystems.h"
 #include "../gamesystems/legacysystems.h"
@@ -92,6 +93,9 @@ void DiagScreen::Render() {
 	lines.push_back(fmt::format("{} of {} rendered", mapObjRenderer.GetRenderedLastFrame(),
 		mapObjRenderer.GetTotalLastFrame()));
 	lines.push_back(fmt::format("AnimSlots used: {}", gameSystems->GetAnim().GetSlotUsedCount()));
+	auto& aasBufferStats = mGameRenderer.GetAnimatedModelRenderer().GetBufferStats();
+	lines.push_back(fmt::format("Skinned submeshes: {} updated, {} reused", aasBufferStats.updated,
+		aasBufferStats.reused));
 	
 	auto& clipping = mGameSystems.GetClipping();
 	lines.push_back(fmt::format("# Clipping Objects"));
@@ -21,6 +21,10 @@ public:
 
 	static int Dispatch54AoE(objHndl, DispIO *, D20DispatcherKey);
 
+	// Temple+: frees the key index along with the dispatcher
+	static int(*orgRemoveDispatcher)(objHndl);
+	static int RemoveDispatcher(objHndl handle);
+
 	void apply() override {
 		logger->info("Replacing basic Dispatcher functions");
 		
@@ -45,6 +49,7 @@ public:
 		replaceFunction(0x100E2760, _DispatcherClearConds);
 		replaceFunction(0x100E2120, _DispatcherProcessor);
 		replaceFunction(0x100E1F10, _DispatcherInit);
+		orgRemoveDispatcher = replaceFunction(0x1004FEE0, RemoveDispatcher);
 		replaceFunction(0x1004DBA0, DispIOType21Init);
 		replaceFunction(0x1004D3A0, _Dispatch62);
 		replaceFunction(0x1004D440, _Dispatch63);
@@ -1037,19 +1042,96 @@ void DispIO::AssertType(enum_dispIO_type eventObjType) const
 
 #pragma region Dispatcher Functions
 
+/*
+	Secondary index over Dispatcher::subDispNodes.
+	For each dispatch type there is a wildcard bucket (nodes with dispKey 0), and a bucket per specific key
+	holding that key's nodes together with the wildcard ones, in list order. Processing a key thus visits
+	exactly the nodes that the full list walk would have fired, in the same order.
+*/
+struct DispatcherKeyIndex {
+	typedef std::vector<SubDispNode*> NodeList;
+
+	struct KeyBucket {
+		uint32_t dispKey;
+		NodeList nodes;
+	};
+
+	struct TypeIndex {
+		NodeList wildcard;
+		std::vector<std::unique_ptr<KeyBucket>> buckets; // sorted by dispKey
+	};
+
+	TypeIndex types[dispTypeCount];
+
+	const NodeList& Find(enum_disp_type dispType, uint32_t dispKey) const {
+		auto& typeIdx = types[dispType];
+		if (dispKey == 0 || typeIdx.buckets.empty())
+			return typeIdx.wildcard;
+		auto it = std::lower_bound(typeIdx.buckets.begin(), typeIdx.buckets.end(), dispKey,
+			[](const std::unique_ptr<KeyBucket>& bucket, uint32_t key) { return bucket->dispKey < key; });
+		if (it == typeIdx.buckets.end() || (*it)->dispKey != dispKey)
+			return typeIdx.wildcard;
+		return (*it)->nodes;
+	}
+
+	// Nodes are always appended to the tail of their list, so appending to the buckets preserves list order
+	void Add(SubDispNode* node) {
+		auto sdd = node->subDispDef;
+		auto& typeIdx = types[sdd->dispType];
+		if (sdd->dispKey == 0) {
+			typeIdx.wildcard.push_back(node);
+			for (auto& bucket : typeIdx.buckets) {
+				bucket->nodes.push_back(node);
+			}
+			return;
+		}
+
+		auto it = std::lower_bound(typeIdx.buckets.begin(), typeIdx.buckets.end(), sdd->dispKey,
+			[](const std::unique_ptr<KeyBucket>& bucket, uint32_t key) { return bucket->dispKey < key; });
+		if (it == typeIdx.buckets.end() || (*it)->dispKey != sdd->dispKey) {
+			auto bucket = std::make_unique<KeyBucket>();
+			bucket->dispKey = sdd->dispKey;
+			bucket->nodes = typeIdx.wildcard;
+			it = typeIdx.buckets.insert(it, std::move(bucket));
+		}
+		(*it)->nodes.push_back(node);
+	}
+
+	void Remove(enum_disp_type dispType, CondNode* cond) {
+		auto isCondNode = [cond](SubDispNode* node) { return node->condNode == cond; };
+		auto& typeIdx = types[dispType];
+		typeIdx.wildcard.erase(std::remove_if(typeIdx.wildcard.begin(), typeIdx.wildcard.end(), isCondNode), typeIdx.wildcard.end());
+		for (auto& bucket : typeIdx.buckets) {
+			bucket->nodes.erase(std::remove_if(bucket->nodes.begin(), bucket->nodes.end(), isCondNode), bucket->nodes.end());
+		}
+	}
+};
+
+void _DispatcherIndexSubDispNode(Dispatcher* dispatcher, SubDispNode* subDispNode)
+{
+	if (_SubDispNodeIsImmunityTrigger(subDispNode)) {
+		dispatcher->immunityTriggerCount++;
+	}
+	dispatcher->keyIndex->Add(subDispNode);
+}
+
 void __cdecl _DispatcherRemoveSubDispNodes(Dispatcher * dispatcher, CondNode * cond)
 {
 	for (uint32_t i = 0; i < dispTypeCount; i++)
 	{
+		auto removedAny = false;
 		SubDispNode ** ppSubDispNode = &dispatcher->subDispNodes[i];
 		while (*ppSubDispNode != nullptr)
 		{
 			if ((*ppSubDispNode)->condNode == cond)
 			{
+				if (_SubDispNodeIsImmunityTrigger(*ppSubDispNode)) {
+					dispatcher->immunityTriggerCount--;
+				}
 				SubDispNode * savedNext = (*ppSubDispNode)->next;
 				free(*ppSubDispNode);
 				*ppSubDispNode = savedNext;
-
+				removedAny = true;
 			}
 			else
 			{
@@ -1057,10 +1139,20 @@ void __cdecl _DispatcherRemoveSubDispNodes(Dispatcher * dispatcher, CondNode * c
 			}
 
 		}
+		if (removedAny) {
+			dispatcher->keyIndex->Remove((enum_disp_type)i, cond);
+		}
 	}
 
 	};
 
+bool _SubDispNodeIsImmunityTrigger(const SubDispNode* subDispNode)
+{
+	auto sdd = subDispNode->subDispDef;
+	return sdd->dispType == dispTypeImmunityTrigger
+		&& (sdd->dispKey == DK_IMMUNITY_SPELL || sdd->dispKey == 0);
+}
+
 
 void __cdecl _DispatcherClearField(Dispatcher *dispatcher, CondNode ** dispCondList)
 {
@@ -1183,18 +1275,23 @@ void _DispatcherProcessor(Dispatcher* dispatcher, enum_disp_type dispType, D20Di
 	}
 	dispCounter++;
 	
-	SubDispNode* subDispNode = dispatcher->subDispNodes[dispType];
+	// Callbacks may add conditions (appending to the bucket, or creating the key's bucket out of the
+	// wildcard one), so the bucket is looked up again after each callback and walked by index.
+	auto keyIndex = dispatcher->keyIndex;
+	auto nodes = &keyIndex->Find(dispType, dispKey);
 
-	while (subDispNode != nullptr) {
+	for (size_t i = 0; i < nodes->size(); i++) {
+		auto subDispNode = (*nodes)[i];
 
-		if ((subDispNode->subDispDef->dispKey == dispKey || subDispNode->subDispDef->dispKey == 0) && ((subDispNode->condNode->flags & 1) == 0)) {
+		if ((subDispNode->condNode->flags & 1) == 0) {
 
 			DispIoTypeImmunityTrigger dispIoImmunity;
 			DispIOType21Init((DispIoTypeImmunityTrigger*)&dispIoImmunity);
 			dispIoImmunity.condNode = (CondNode *)subDispNode->condNode;
 
-			// prevent recursion
-			if (dispKey != DK_IMMUNITY_SPELL || dispType != dispTypeImmunityTrigger) {
+			// prevent recursion; also skip the nested dispatch altogether when nothing could respond to it
+			if (dispatcher->immunityTriggerCount > 0
+				&& (dispKey != DK_IMMUNITY_SPELL || dispType != dispTypeImmunityTrigger)) {
 				_Dispatch62(dispatcher->objHnd, (DispIO*)&dispIoImmunity, DK_IMMUNITY_SPELL);
 			}
 			
@@ -1212,9 +1309,8 @@ void _DispatcherProcessor(Dispatcher* dispatcher, enum_disp_type dispType, D20Di
 				subDispNode->subDispDef->dispCallback(subDispNode, dispatcher->objHnd, dispType, dispKey, (DispIO*)dispIO);
 			}
 
+			nodes = &keyIndex->Find(dispType, dispKey);
 		}
-
-		subDispNode = subDispNode->next;
 	}
 
 	dispCounter--;
@@ -1295,9 +1391,27 @@ void Dispatcher::Process(enum_disp_type dispType, D20DispatcherKey key, DispIO*
 	dispatch.DispatcherProcessor(this, dispType, key, dispIo);
 }
 
+int(*DispatcherReplacements::orgRemoveDispatcher)(objHndl);
+
+int DispatcherReplacements::RemoveDispatcher(objHndl handle){
+	DispatcherKeyIndex* keyIndex = nullptr;
+	auto obj = objSystem->GetObject(handle);
+	if (obj) {
+		auto dispatcher = obj->GetDispatcher();
+		if (dispatcher) {
+			keyIndex = dispatcher->keyIndex;
+		}
+	}
+	auto result = orgRemoveDispatcher(handle);
+	delete keyIndex;
+	return result;
+}
+
 Dispatcher* _DispatcherInit(objHndl objHnd) {
 	Dispatcher* dispatcherNew = (Dispatcher *)malloc(sizeof(Dispatcher));
 	memset(&dispatcherNew->subDispNodes, 0, dispTypeCount * sizeof(SubDispNode*));
+	dispatcherNew->immunityTriggerCount = 0;
+	dispatcherNew->keyIndex = new DispatcherKeyIndex();
 	CondNode* condNode = *(conds.pCondNodeGlobal);
 	while (condNode != nullptr) {
 		_CondNodeAddToSubDispNodeArray(dispatcherNew, condNode);
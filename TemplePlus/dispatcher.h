@@ -45,6 +45,7 @@ struct SubDispDef;
 struct CondStruct;
 struct DispatcherCallbackArgs;
 struct Dispatcher;
+struct DispatcherKeyIndex;
 
 
 struct DispatcherSystem : temple::AddressTable
@@ -669,6 +670,8 @@ struct Dispatcher : temple::TempleAlloc {
 	CondNode* itemConds;
 	CondNode* conditions;
 	SubDispNode* subDispNodes[dispTypeCount];
+	int immunityTriggerCount; // Temple+: number of SubDispNodes that respond to the DK_IMMUNITY_SPELL check (incl. disabled ones); while 0, the nested immunity dispatch is skipped
+	DispatcherKeyIndex* keyIndex; // Temple+: per dispatch type/key buckets over subDispNodes, used by _DispatcherProcessor
 	bool IsValid();
 	void Process(enum_disp_type dispTypeInitiativeMod, D20DispatcherKey key, DispIO* dispIo);
 };
@@ -682,6 +685,8 @@ struct Dispatcher : temple::TempleAlloc {
 Dispatcher* _DispatcherInit(objHndl objHnd);
 
 void  _DispatcherRemoveSubDispNodes(Dispatcher * dispatcher, CondNode * cond);
+bool  _SubDispNodeIsImmunityTrigger(const SubDispNode* subDispNode); // Temple+: can the node respond to the immunity check made by _DispatcherProcessor
+void  _DispatcherIndexSubDispNode(Dispatcher* dispatcher, SubDispNode* subDispNode); // Temple+: registers a node newly appended to subDispNodes with the key index
 void  _DispatcherClearField(Dispatcher *dispatcher, CondNode ** dispCondList);
 void  _DispatcherClearPermanentMods(Dispatcher *dispatcher);
 void  _DispatcherClearItemConds(Dispatcher *dispatcher);
@@ -77,48 +77,11 @@ void FogOfWarRenderer::Render() {
 
 	gfx::PerfGroup perfGroup(mDevice, "Fog Of War");
 
-	// Reset the blurred buffer
-	eastl::fill(mBlurredFog.begin(), mBlurredFog.end(), 0);
-
-	static auto sOpaquePattern = FogBlurKernel::Create(0xFF);
-	static auto sHalfTransparentPattern = FogBlurKernel::Create(0xA0);
-
 	static auto& fogCheckData = temple::GetRef<uint8_t*>(0x108A5498);
 
-	// Get [0,0] of the subtile data
-	auto fogCheckSubtile = &fogCheckData[0];
-
-	for (size_t y = 0; y < mNumSubtilesY; y++) {
-		for (size_t x = 0; x < mNumSubtilesX; x++) {
-			auto fogState = *fogCheckSubtile;
-
-			// Bit 2 -> Currently in LoS of the party
-			if (!(fogState & 2)) {
-				uint8_t* patternSrc;
-				// Bit 3 -> Explored
-				if (fogState & 4) {
-					patternSrc = &sHalfTransparentPattern.patterns[x & 3][0][0];
-				} else {
-					patternSrc = &sOpaquePattern.patterns[x & 3][0][0];
-				}
-
-				// Now we copy 5 rows of 2 dwords each, to apply
-				// the filter-kernel to the blurred fog map
-				for (auto row = 0; row < 5; ++row) {
-					auto src = (uint64_t*) &patternSrc[row * 8];
-					auto roundedDownX = (x / 4) * 4;
-					auto dest = (uint64_t*) &mBlurredFog[(y + row) * mBlurredFogWidth + roundedDownX];
-					// Due to how the kernel is layed out, the individual bytes in this 8-byte addition will never carry
-					// over to the next higher byte, thus this is equivalent to 8 separate 1-byte additions
-					*dest += *src;
-				}
-			}
-			++fogCheckSubtile;
-		}
-
-		// Skips the last subtile of the row and the first of the next row
-		// fogCheckSubtile += 2;
-
+	// While the party stands still, neither the blurred fog nor the texture have to change
+	if (UpdateBlurredFog(fogCheckData)) {
+		mBlurredFogTexture->Update<uint8_t>(gsl::span(&mBlurredFog[0], mBlurredFog.size()));
 	}
 
 	static auto& fogMinX = temple::GetRef<uint64_t>(0x10824468);
@@ -127,8 +90,6 @@ void FogOfWarRenderer::Render() {
 	auto mFogOriginX = (uint32_t) fogMinX;
 	auto mFogOriginY = (uint32_t) fogMinY;
 
-	mBlurredFogTexture->Update<uint8_t>(gsl::span(&mBlurredFog[0], mBlurredFog.size()));
-
 	// Use only the relevant subportion of the texture
 	auto umin = 2.5f / (float)mBlurredFogWidth;
 	auto vmin = 2.5f / (float)mBlurredFogHeight;
@@ -168,6 +129,124 @@ void FogOfWarRenderer::Render() {
 
 }
 
+bool FogOfWarRenderer::UpdateBlurredFog(const uint8_t* fogCheckData) {
+
+	size_t numSubtilesX = mNumSubtilesX;
+	size_t numSubtilesY = mNumSubtilesY;
+	if (!fogCheckData || !numSubtilesX || !numSubtilesY) {
+		return false;
+	}
+
+	// Start over if the fog area has been resized (see MapFoggingSystem::InitScreenBuffers)
+	if (numSubtilesX != mBlurredSubtilesX || numSubtilesY != mBlurredSubtilesY) {
+		mBlurredSubtilesX = numSubtilesX;
+		mBlurredSubtilesY = numSubtilesY;
+		mBlurredFogCheckData.resize(numSubtilesX * numSubtilesY);
+		memcpy(&mBlurredFogCheckData[0], fogCheckData, numSubtilesX * numSubtilesY);
+
+		eastl::fill(mBlurredFog.begin(), mBlurredFog.end(), 0);
+		BlurFog(fogCheckData, 0, numSubtilesX - 1, 0, numSubtilesY - 1);
+		return true;
+	}
+
+	// Find the rect of subtiles that changed by comparing against the data that was blurred last time
+	auto x1 = numSubtilesX, y1 = numSubtilesY;
+	size_t x2 = 0, y2 = 0;
+	for (size_t y = 0; y < numSubtilesY; y++) {
+		auto row = &fogCheckData[y * numSubtilesX];
+		auto blurredRow = &mBlurredFogCheckData[y * numSubtilesX];
+		if (!memcmp(row, blurredRow, numSubtilesX)) {
+			continue;
+		}
+
+		size_t first = 0, last = numSubtilesX - 1;
+		while (row[first] == blurredRow[first]) {
+			first++;
+		}
+		while (row[last] == blurredRow[last]) {
+			last--;
+		}
+		memcpy(&blurredRow[first], &row[first], last - first + 1);
+
+		x1 = std::min(x1, first);
+		x2 = std::max(x2, last);
+		y1 = std::min(y1, y);
+		y2 = y;
+	}
+
+	if (y1 == numSubtilesY) {
+		return false;
+	}
+
+	BlurFog(fogCheckData, x1, x2, y1, y2);
+	return true;
+
+}
+
+void FogOfWarRenderer::BlurFog(const uint8_t* fogCheckData, size_t x1, size_t x2, size_t y1, size_t y2) {
+
+	static auto sOpaquePattern = FogBlurKernel::Create(0xFF);
+	static auto sHalfTransparentPattern = FogBlurKernel::Create(0xA0);
+
+	// Each subtile is spread over the 5x5 pixels starting at its own, so these are the pixels
+	// that change. They are rebuilt in groups of 4 pixels, which is how the kernels are aligned.
+	auto firstGroup = x1 / 4;
+	auto lastGroup = (x2 + 4) / 4;
+	auto firstRow = y1;
+	auto lastRow = y2 + 4;
+
+	for (auto row = firstRow; row <= lastRow; ++row) {
+		memset(&mBlurredFog[row * mBlurredFogWidth + firstGroup * 4], 0, (lastGroup - firstGroup + 1) * 4);
+	}
+
+	// All subtiles whose kernel reaches into those pixels have to be added again
+	auto fromX = firstGroup > 0 ? (firstGroup - 1) * 4 : 0;
+	auto toX = std::min<size_t>(lastGroup * 4 + 3, mBlurredSubtilesX - 1);
+	auto fromY = firstRow >= 4 ? firstRow - 4 : 0;
+	auto toY = std::min<size_t>(lastRow, mBlurredSubtilesY - 1);
+
+	for (auto y = fromY; y <= toY; y++) {
+		auto fogCheckSubtile = &fogCheckData[y * mBlurredSubtilesX + fromX];
+		for (auto x = fromX; x <= toX; x++, fogCheckSubtile++) {
+			auto fogState = *fogCheckSubtile;
+
+			// Bit 2 -> Currently in LoS of the party
+			if (fogState & 2) {
+				continue;
+			}
+
+			uint8_t* patternSrc;
+			// Bit 3 -> Explored
+			if (fogState & 4) {
+				patternSrc = &sHalfTransparentPattern.patterns[x & 3][0][0];
+			} else {
+				patternSrc = &sOpaquePattern.patterns[x & 3][0][0];
+			}
+
+			// Now we add 5 rows of 2 dwords each, to apply the filter-kernel to the blurred fog map,
+			// skipping the parts outside of the pixels being rebuilt
+			auto group = x / 4;
+			for (auto row = 0; row < 5; ++row) {
+				auto destRow = y + row;
+				if (destRow < firstRow || destRow > lastRow) {
+					continue;
+				}
+				auto src = (uint32_t*) &patternSrc[row * 8];
+				auto dest = (uint32_t*) &mBlurredFog[destRow * mBlurredFogWidth + group * 4];
+				// Due to how the kernel is layed out, the individual bytes in these 4-byte additions will never carry
+				// over to the next higher byte, thus this is equivalent to 4 separate 1-byte additions
+				if (group >= firstGroup) {
+					dest[0] += src[0];
+				}
+				if (group + 1 <= lastGroup) {
+					dest[1] += src[1];
+				}
+			}
+		}
+	}
+
+}
+
 FogBlurKernel FogBlurKernel::Create(uint8_t totalPatternValue) {
 
 	FogBlurKernel result;
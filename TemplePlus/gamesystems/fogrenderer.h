@@ -20,6 +20,15 @@ public:
 	void Render();
 
 private:
+	/*
+		Brings mBlurredFog up to date with the fog check data. Only the subtiles that changed since
+		the last call are blurred again. Returns false if nothing changed.
+	*/
+	bool UpdateBlurredFog(const uint8_t* fogCheckData);
+
+	// Re-blurs the pixels affected by the subtiles within the given rect (inclusive)
+	void BlurFog(const uint8_t* fogCheckData, size_t x1, size_t x2, size_t y1, size_t y2);
+
 	gfx::MdfMaterialFactory &mMdfFactory;
 	gfx::RenderingDevice &mDevice;
 
@@ -28,6 +37,11 @@ private:
 	eastl::vector<uint8_t> mBlurredFog;
 	size_t mBlurredFogWidth;
 	size_t mBlurredFogHeight;
+
+	// The fog check data mBlurredFog was made from
+	eastl::vector<uint8_t> mBlurredFogCheckData;
+	size_t mBlurredSubtilesX = 0;
+	size_t mBlurredSubtilesY = 0;
 	
 	gfx::DynamicTexturePtr mBlurredFogTexture;
 
@@ -206,6 +206,8 @@ void GameRenderer::Render() {
 
 	gfx::PerfGroup perfGroup(mRenderingDevice, "Game Renderer");
 
+	mAasRenderer->ResetBufferStats();
+
   /*
   Without this call, the ground JPGs will not be rendered.
   */
@@ -40,6 +40,10 @@ public:
 		return *mMapObjectRenderer;
 	}
 
+	aas::Renderer& GetAnimatedModelRenderer() const {
+		return *mAasRenderer;
+	}
+
 private:
 
 	void RenderWorld(RenderWorldInfo *info);
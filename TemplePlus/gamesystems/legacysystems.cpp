@@ -32,6 +32,9 @@
 #include "ai.h"
 #include "gameview.h"
 #include <hotkeys.h>
+#include "party.h"
+#include "critter.h"
+#include "mapsystem.h"
 
 
 //*****************************************************************************
@@ -1740,6 +1743,7 @@ void MapFoggingSystem::Reset() {
 	mEsdLoaded = 0;
 	memset(&mEsdSectorLocs[0], 0, 32 * sizeof(uint64_t));
 	mDoFullUpdate = false;
+	mLineOfSightValid = false;
 }
 
 const std::string &MapFoggingSystem::GetName() const {
@@ -1781,95 +1785,186 @@ void MapFoggingSystem::SaveEsd() {
 	map_flush_esd();
 }
 
-void MapFoggingSystem::PerformCheckForCritter(objHndl handle, int idx){
-	memset(&mFogBuffers[idx], 0, 4 * sFogBufferDim* sFogBufferDim);
-	auto obj = objSystem->GetObject(handle);
-	auto objLoc = obj->GetLocation();
+// The subtile the object is on, counted from the origin of the map
+static void GetObjectSubtile(objHndl handle, int &subtileXOut, int &subtileYOut) {
+	auto pos = objects.GetLocationFull(handle).ToInches2D();
+	subtileXOut = (int)(pos.x / INCH_PER_SUBTILE);
+	subtileYOut = (int)(pos.y / INCH_PER_SUBTILE);
+}
 
+void MapFoggingSystem::PerformCheckForCritter(objHndl handle, int idx){
+	auto mapId = gameSystems->GetMap().GetCurrentMapId();
+	if (mapId != mLineOfSightMapId) {
+		mLineOfSightMapId = mapId;
+		mLineOfSightValid = false;
+	}
+
+	// The vision blockers are built for the whole party at once, so they rarely have to be rebuilt
+	// when the party members are checked one after another
+	int subtileX, subtileY;
+	GetObjectSubtile(handle, subtileX, subtileY);
+	auto minX = subtileX, maxX = subtileX;
+	auto minY = subtileY, maxY = subtileY;
+	auto partyLen = std::min<uint32_t>(party.GroupListGetLen(), 8);
+	for (uint32_t i = 0; i < partyLen; i++) {
+		auto member = party.GroupListGetMemberN(i);
+		if (critterSys.IsDeadNullDestroyed(member)) {
+			continue;
+		}
+		int memberX, memberY;
+		GetObjectSubtile(member, memberX, memberY);
+		minX = std::min(minX, memberX);
+		maxX = std::max(maxX, memberX);
+		minY = std::min(minY, memberY);
+		maxY = std::max(maxY, memberY);
+	}
+	CoverWithVisionBlockers(minX, minY, maxX, maxY);
+
+	mPartyLineOfSight.SetViewer(idx, subtileX, subtileY, sLineOfSightRadius);
+	for (auto i = std::max<size_t>(partyLen, idx + 1); i < mLineOfSightViewers; i++) {
+		mPartyLineOfSight.RemoveViewer(i);
+	}
+	mLineOfSightViewers = std::max<size_t>(partyLen, idx + 1);
+	UpdateDoorBlockers();
+	mPartyLineOfSight.Update();
+
+	// Fill the critter's fog buffer the way the vanilla check does. PerformFogChecks combines the
+	// buffers into the fog check data and marks what is in sight as explored.
+	auto objLoc = objects.GetLocation(handle);
 	auto fogBufferDim_div3 = sFogBufferDim / 3;
 	int64_t (& objsRelX)[] = temple::GetRef<int64_t[]>(0x1080FB88);
 	int64_t (& objsRelY)[] = temple::GetRef<int64_t[]>(0x108EC550);
-
 	objsRelX[idx] = objLoc.locx - fogBufferDim_div3;
 	objsRelY[idx] = objLoc.locy - fogBufferDim_div3;
 
-	TileRect tiles;
-	tiles.x1 = objLoc.locx - fogBufferDim_div3;
-	tiles.x2 = objLoc.locx + fogBufferDim_div3;
-	tiles.y1 = objLoc.locy - fogBufferDim_div3;
-	tiles.y2 = objLoc.locy + fogBufferDim_div3;
-
-	auto sectorList = sectorSys.BuildSectorList(&tiles);
-	if (!sectorList)
-		return;
-
-	auto listNode = sectorList;
-
-	while (listNode){
-
-		Sector *sect;
-		if (!sectorSys.SectorLock(listNode->sector, &sect)){
-			listNode = listNode->next;
-			continue;
+	auto fogBuffer = (uint8_t*)mFogBuffers[idx];
+	memset(fogBuffer, 0, sFogBufferSubtiles * sFogBufferSubtiles);
+	auto bufferOriginX = (int)objsRelX[idx] * 3;
+	auto bufferOriginY = (int)objsRelY[idx] * 3;
+	auto &blockers = mPartyLineOfSight.GetBlockers();
+	for (auto cellIdx : mPartyLineOfSight.GetVisibleCells(idx)) {
+		auto x = blockers.GetOriginX() + (int)(cellIdx % blockers.GetWidth()) - bufferOriginX;
+		auto y = blockers.GetOriginY() + (int)(cellIdx / blockers.GetWidth()) - bufferOriginY;
+		if (x >= 0 && y >= 0 && x < sFogBufferSubtiles && y < sFogBufferSubtiles) {
+			fogBuffer[x + y * sFogBufferSubtiles] = FogBufferLineOfSight;
 		}
-		auto secLoc = listNode->sector;
-		auto baseTile=secLoc.GetBaseTile();
-
-		auto svb = gameSystems->GetSectorVB().GetSvb(secLoc);
-		auto relX = objsRelX[idx];
-		auto relY = objsRelY[idx];
+	}
+}
 
-		auto cornerX = listNode->cornerTile.locx;
-		auto cornerY = listNode->cornerTile.locy;
+void MapFoggingSystem::CoverWithVisionBlockers(int subtileX1, int subtileY1, int subtileX2, int subtileY2) {
+	constexpr int SubtilesPerSector = SECTOR_SIDE_SIZE * 3;
 
-		auto deltaX = cornerX - baseTile.locx;
-		auto deltaY = cornerY - baseTile.locy;
-		
+	auto secX1 = std::max(0, (subtileX1 - sLineOfSightRadius) / SubtilesPerSector);
+	auto secY1 = std::max(0, (subtileY1 - sLineOfSightRadius) / SubtilesPerSector);
+	auto secX2 = (subtileX2 + sLineOfSightRadius) / SubtilesPerSector;
+	auto secY2 = (subtileY2 + sLineOfSightRadius) / SubtilesPerSector;
 
-		auto &objNodes = sect->objects;
-		auto objNode = objNodes.tiles[deltaX + (deltaY << 6)];
+	if (mLineOfSightValid
+		&& secX1 >= mLineOfSightSecX1 && secX2 <= mLineOfSightSecX2
+		&& secY1 >= mLineOfSightSecY1 && secY2 <= mLineOfSightSecY2) {
+		return;
+	}
 
-		for (; objNode != nullptr; objNode = objNode->next) {
+	BuildVisionBlockers(secX1, secY1, secX2, secY2);
+}
 
-			auto objNodeItem = objNode->handle;
-			if (!objNodeItem){
-				continue;
-			}
+void MapFoggingSystem::BuildVisionBlockers(int secX1, int secY1, int secX2, int secY2) {
+	constexpr int SubtilesPerSector = SECTOR_SIDE_SIZE * 3;
 
-			auto objNodeObj = objSystem->GetObject(objNodeItem);
+	VisionBlockers blockers;
+	blockers.Reset(secX1 * SubtilesPerSector, secY1 * SubtilesPerSector,
+		(secX2 - secX1 + 1) * SubtilesPerSector, (secY2 - secY1 + 1) * SubtilesPerSector);
+	mLineOfSightDoors.clear();
 
-			if (objNodeObj->type != obj_t_portal)
+	for (auto secY = secY1; secY <= secY2; secY++) {
+		for (auto secX = secX1; secX <= secX2; secX++) {
+			SectorLoc secLoc(secX, secY);
+			Sector* sect;
+			if (!sectorSys.SectorFileExists(secLoc) || !sectorSys.SectorLock(secLoc, &sect)) {
 				continue;
+			}
 
-			auto aasParams = objects.GetAnimParams(objNodeItem);
-			auto model     = objects.GetAnimHandle(objNodeItem);
-			auto submeshes = model->GetSubmeshes();
-			
-			for (auto i_submesh=0u; i_submesh<submeshes.size(); i_submesh++){
-				auto doorSubmesh = model->GetSubmesh(aasParams, submeshes[i_submesh]);
-				auto vertPos   = doorSubmesh->GetPositions();
-				auto indices   = doorSubmesh->GetIndices();
-				auto primCount = doorSubmesh->GetPrimitiveCount();
-
-				for (auto i_prim = 0; i_prim < primCount; i_prim++){
-					// todo: fill triangle with value 8 
+			for (int ty = 0; ty < SECTOR_SIDE_SIZE; ty++) {
+				for (int tx = 0; tx < SECTOR_SIDE_SIZE; tx++) {
+					auto tileIdx = tx + SECTOR_SIDE_SIZE * ty;
+					auto flags = sect->tilePkt.tiles[tileIdx].flags;
+					for (int sy = 0; sy < 3; sy++) {
+						for (int sx = 0; sx < 3; sx++) {
+							if (flags & (TileFlags::BlockX0Y0 << (sx + 3 * sy))) {
+								blockers.SetBlocking(secX * SubtilesPerSector + tx * 3 + sx, secY * SubtilesPerSector + ty * 3 + sy);
+							}
+						}
+					}
+
+					for (auto objNode = sect->objects.tiles[tileIdx]; objNode != nullptr; objNode = objNode->next) {
+						if (objNode->handle && objSystem->GetObject(objNode->handle)->type == obj_t_portal) {
+							mLineOfSightDoors.push_back({ objNode->handle, true });
+						}
+					}
 				}
-
 			}
-			
 
+			sectorSys.SectorUnlock(secLoc);
 		}
+	}
 
+	// Doors block the subtiles within their radius (apart from the ones blocked by the tiles anyway)
+	for (auto &door : mLineOfSightDoors) {
+		auto pos = objects.GetLocationFull(door.handle).ToInches2D();
+		auto radius = std::max(objects.GetRadius(door.handle), INCH_PER_SUBTILE / 2);
+		auto subtileX1 = (int)((pos.x - radius) / INCH_PER_SUBTILE), subtileX2 = (int)((pos.x + radius) / INCH_PER_SUBTILE);
+		auto subtileY1 = (int)((pos.y - radius) / INCH_PER_SUBTILE), subtileY2 = (int)((pos.y + radius) / INCH_PER_SUBTILE);
+		for (auto y = subtileY1; y <= subtileY2; y++) {
+			for (auto x = subtileX1; x <= subtileX2; x++) {
+				auto centerX = (x + 0.5f) * INCH_PER_SUBTILE - pos.x;
+				auto centerY = (y + 0.5f) * INCH_PER_SUBTILE - pos.y;
+				if (centerX * centerX + centerY * centerY <= radius * radius
+					&& blockers.Contains(x, y) && !blockers.IsBlocking(x, y)) {
+					door.subtiles.push_back({ x, y });
+				}
+			}
+		}
 
+		door.open = CanSeeThroughPortal(door.handle);
+		if (!door.open) {
+			for (auto &subtile : door.subtiles) {
+				blockers.SetBlocking(subtile.first, subtile.second);
+			}
+		}
+	}
 
-		// unlock sector TODO svb
-		sectorSys.SectorUnlock(listNode->sector);
+	mPartyLineOfSight.SetBlockers(blockers);
+	mLineOfSightSecX1 = secX1;
+	mLineOfSightSecY1 = secY1;
+	mLineOfSightSecX2 = secX2;
+	mLineOfSightSecY2 = secY2;
+	mLineOfSightValid = true;
+}
 
-		listNode = listNode->next;
+void MapFoggingSystem::UpdateDoorBlockers() {
+	for (auto &door : mLineOfSightDoors) {
+		if (!objSystem->IsValidHandle(door.handle)) {
+			continue;
+		}
+		auto open = CanSeeThroughPortal(door.handle);
+		if (open == door.open) {
+			continue;
+		}
+		door.open = open;
+		for (auto &subtile : door.subtiles) {
+			mPartyLineOfSight.SetBlocking(subtile.first, subtile.second, !open);
+		}
 	}
+}
 
-	sectorSys.SectorListReturnToPool(sectorList);
-
+bool MapFoggingSystem::CanSeeThroughPortal(objHndl handle)
+{
+	if (!handle)
+		return true;
+	if (objects.GetFlags(handle) & OF_SEE_THROUGH) {
+		return true;
+	}
+	return objects.IsPortalOpen(handle);
 }
 
 int MapFoggingSystem::IsPosExplored(LocAndOffsets location)
@@ -11,6 +11,8 @@
 #include "map/sector.h"
 #include "secret_door.h"
 
+#include <infrastructure/lineofsight.h>
+
 namespace gfx {
 	class RenderingDevice;
 }
@@ -568,10 +570,20 @@ public:
 	void SaveExploredTileData(int mapId);
 	
 	void SaveEsd();
+
+	/*
+		Replaces the vanilla fog check for party member idx if nativeLineOfSight is enabled: computes what
+		it can see with the native line of sight (see LineOfSight) and fills its fog buffer with that.
+		The vanilla PerformFogChecks then turns the buffers into the fog check data and the explored
+		areas as usual. Only the party members that moved are computed again.
+	*/
 	void PerformCheckForCritter(objHndl handle, int idx);
 
 	int IsPosExplored(LocAndOffsets location);
 
+	// Whether the fog of war lets the party see past the portal: it is open or flagged OF_SEE_THROUGH
+	static bool CanSeeThroughPortal(objHndl handle);
+
 private:
 
 	gfx::RenderingDevice &mDevice;
@@ -580,6 +592,36 @@ private:
 
 	static constexpr size_t sFogBufferDim = 102;
 
+	// The fog buffers have a byte per subtile, for sFogBufferDim / 3 tiles around their party member
+	static constexpr int sFogBufferSubtiles = 2 * (int) sFogBufferDim;
+	static constexpr uint8_t FogBufferLineOfSight = 2;
+
+	// In subtiles, up to the edge of the fog buffers
+	static constexpr int sLineOfSightRadius = (int) sFogBufferDim;
+
+	/*
+		Subtiles of the sectors around the party are vision blockers if they block movement (subtiles that
+		can be flown over don't block vision). Closed doors block the subtiles within their radius,
+		unless they are see-through (see CanSeeThroughPortal).
+	*/
+	LineOfSight mPartyLineOfSight;
+	struct DoorBlocker {
+		objHndl handle;
+		bool open; // or see-through
+		std::vector<std::pair<int, int>> subtiles;
+	};
+	std::vector<DoorBlocker> mLineOfSightDoors;
+	bool mLineOfSightValid = false;
+	int mLineOfSightMapId = 0;
+	int mLineOfSightSecX1 = 0, mLineOfSightSecY1 = 0, mLineOfSightSecX2 = 0, mLineOfSightSecY2 = 0;
+	size_t mLineOfSightViewers = 0;
+
+	// Builds the vision blockers for the given sectors (inclusive)
+	void BuildVisionBlockers(int secX1, int secY1, int secX2, int secY2);
+	// Makes sure the vision blockers cover the given subtiles (inclusive) and the line of sight around them
+	void CoverWithVisionBlockers(int subtileX1, int subtileY1, int subtileX2, int subtileY2);
+	void UpdateDoorBlockers();
+
 	uint64_t& mFogMinX = temple::GetRef<uint64_t>(0x10824468);
 	uint64_t& mFogMinY = temple::GetRef<uint64_t>(0x108EC4C8);
 	uint64_t& mSubtilesX = temple::GetRef<uint64_t>(0x10820458);
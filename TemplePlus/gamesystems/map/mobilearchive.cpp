@@ -0,0 +1,153 @@
+#include "stdafx.h"
+#include "mobilearchive.h"
+
+#include <infrastructure/vfs.h>
+#include <infrastructure/exception.h>
+#include <infrastructure/stringutil.h>
+
+static constexpr uint32_t MobileArchiveMagic = 0x4B504D54; // TMPK
+static constexpr uint32_t MobileArchiveVersion = 1;
+
+// Every .mob file starts with the 0x77 header, the prototype id and the object id
+static constexpr size_t MobIdOffset = sizeof(uint32_t) + sizeof(ObjectId);
+
+bool MobileArchive::Load(const std::string& dataDir)
+{
+	mData.clear();
+	mCount = 0;
+	mByName.clear();
+
+	auto filename = fmt::format("{}\\{}", dataDir, FileName);
+	if (!vfs->FileExists(filename)) {
+		return false;
+	}
+
+	try {
+		mData = vfs->ReadAsBinary(filename);
+	} catch (TempleException& e) {
+		logger->warn("Unable to read mobile archive: {}", e.what());
+		return false;
+	}
+
+	Header header;
+	if (mData.size() < sizeof(header)) {
+		logger->warn("Mobile archive {} is truncated", filename);
+		return false;
+	}
+	memcpy(&header, &mData[0], sizeof(header));
+	if (header.magic != MobileArchiveMagic || header.version != MobileArchiveVersion) {
+		logger->warn("Unsupported mobile archive {}", filename);
+		return false;
+	}
+	if (mData.size() < sizeof(header) + (size_t)header.count * sizeof(Entry)) {
+		logger->warn("Mobile archive {} is truncated", filename);
+		return false;
+	}
+
+	auto entries = GetEntries();
+	mByName.reserve(header.count);
+	for (size_t i = 0; i < header.count; i++) {
+		auto& entry = entries[i];
+		if ((size_t)entry.offset + entry.size > mData.size() || entry.size < MobIdOffset + sizeof(ObjectId)
+			|| entry.nameOffset >= mData.size()) {
+			logger->warn("Mobile archive {} is damaged", filename);
+			mByName.clear();
+			return false;
+		}
+		auto name = (const char*)&mData[entry.nameOffset];
+		auto nameLen = strnlen(name, mData.size() - entry.nameOffset);
+		mByName[std::string_view(name, nameLen)] = i;
+	}
+
+	mCount = header.count;
+	return true;
+}
+
+const MobileArchive::Entry* MobileArchive::FindFile(const std::string& filename) const
+{
+	auto it = mByName.find(tolower(filename));
+	if (it == mByName.end()) {
+		return nullptr;
+	}
+	return &GetEntries()[it->second];
+}
+
+bool MobileArchive::IsCurrent(const Entry& entry, const VfsSearchResult& mobFile)
+{
+	return entry.sourceSize == mobFile.sizeInBytes && entry.sourceLastModified == mobFile.lastModified;
+}
+
+int MobileArchive::Pack(const std::string& dataDir)
+{
+	auto mobFiles = vfs->Search(dataDir + "\\*.mob");
+
+	struct PackedFile {
+		Entry entry;
+		std::string name;
+		std::vector<uint8_t> content;
+	};
+	std::vector<PackedFile> files;
+	files.reserve(mobFiles.size());
+
+	for (auto& mobFile : mobFiles) {
+		if (mobFile.dir) {
+			continue;
+		}
+		auto filename = fmt::format("{}\\{}", dataDir, mobFile.filename);
+
+		PackedFile file;
+		try {
+			file.content = vfs->ReadAsBinary(filename);
+		} catch (TempleException& e) {
+			logger->warn("Unable to pack mobile {}: {}", filename, e.what());
+			continue;
+		}
+
+		uint32_t header = 0;
+		if (file.content.size() >= MobIdOffset + sizeof(ObjectId)) {
+			memcpy(&header, &file.content[0], sizeof(header));
+		}
+		if (header != 0x77) {
+			logger->warn("Unable to pack mobile {}: not an object file", filename);
+			continue;
+		}
+
+		memcpy(&file.entry.id, &file.content[MobIdOffset], sizeof(ObjectId));
+		file.entry.size = (uint32_t)file.content.size();
+		file.entry.sourceSize = (uint32_t)mobFile.sizeInBytes;
+		file.entry.sourceLastModified = mobFile.lastModified;
+		file.name = tolower(mobFile.filename);
+		files.push_back(std::move(file));
+	}
+
+	// Lay out the names after the entries, then the contents
+	size_t size = sizeof(Header) + files.size() * sizeof(Entry);
+	for (auto& file : files) {
+		file.entry.nameOffset = (uint32_t)size;
+		size += file.name.size() + 1;
+	}
+	for (auto& file : files) {
+		file.entry.offset = (uint32_t)size;
+		size += file.content.size();
+	}
+
+	std::vector<uint8_t> data(size, 0);
+	Header header{ MobileArchiveMagic, MobileArchiveVersion, (uint32_t)files.size(), 0 };
+	memcpy(&data[0], &header, sizeof(header));
+	for (size_t i = 0; i < files.size(); i++) {
+		auto& file = files[i];
+		memcpy(&data[sizeof(Header) + i * sizeof(Entry)], &file.entry, sizeof(Entry));
+		memcpy(&data[file.entry.nameOffset], file.name.c_str(), file.name.size() + 1);
+		memcpy(&data[file.entry.offset], file.content.data(), file.content.size());
+	}
+
+	auto archiveName = fmt::format("{}\\{}", dataDir, FileName);
+	try {
+		vfs->WriteBinaryFile(archiveName, data);
+	} catch (TempleException& e) {
+		logger->error("Unable to write mobile archive: {}", e.what());
+		return -1;
+	}
+
+	return (int)files.size();
+}
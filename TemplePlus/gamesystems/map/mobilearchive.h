@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "obj_structs.h"
+
+struct VfsSearchResult;
+
+/*
+	The .mob files of a map packed into a single file (maps\<name>\mobiles.mpk), so loading a map
+	takes one read instead of opening each of its mobiles (thousands for the larger maps).
+
+	The archive is made with MobileArchive::Pack (debug.pack_mobs in the console). A map can ship the
+	archive without any .mob files, in which case ReadMapMobiles loads every mobile in it. Each entry
+	remembers the size and modification time of the file it was packed from; a loose .mob file that is
+	not in the archive, or has changed since, is loaded directly instead, and if the map has loose .mob
+	files at all, entries whose file was deleted are skipped. So modders can keep adding, editing and
+	removing loose .mob files without repacking.
+
+	Layout: Header, Entry[count], the file names (NUL terminated), then the contents of the .mob files
+	back to back. The entries are in the order the .mob files were found when packing, which is the
+	order they are loaded in (as with loose files).
+*/
+class MobileArchive
+{
+public:
+	static constexpr const char* FileName = "mobiles.mpk";
+
+	struct Entry
+	{
+		ObjectId id;
+		uint32_t offset; // of the object data, from the start of the archive
+		uint32_t size;
+		uint32_t nameOffset; // ditto, for the name of the .mob file
+		uint32_t sourceSize;
+		uint32_t sourceLastModified;
+	};
+
+	// Reads dataDir\mobiles.mpk; returns false if there is none or it is damaged
+	bool Load(const std::string& dataDir);
+
+	// Returns the entry packed from the .mob file with the given name (changed since or not), or nullptr
+	const Entry* FindFile(const std::string& filename) const;
+
+	// Whether the entry was packed from the given .mob file as it is now
+	static bool IsCurrent(const Entry& entry, const VfsSearchResult& mobFile);
+
+	const Entry& GetEntry(size_t idx) const {
+		return GetEntries()[idx];
+	}
+
+	// The name of the .mob file the entry was packed from
+	const char* GetFileName(const Entry& entry) const {
+		return (const char*)&mData[entry.nameOffset];
+	}
+
+	// The object data for ObjSystem::LoadFromBuffer
+	void* GetData(const Entry& entry) {
+		return &mData[entry.offset];
+	}
+
+	size_t GetCount() const {
+		return mCount;
+	}
+
+	/*
+		Packs the .mob files in dataDir into dataDir\mobiles.mpk. Returns the number of mobiles packed,
+		or -1 if the archive could not be written.
+	*/
+	static int Pack(const std::string& dataDir);
+
+private:
+	struct Header
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t count;
+		uint32_t reserved;
+	};
+
+	std::vector<uint8_t> mData;
+	size_t mCount = 0;
+	std::unordered_map<std::string_view, size_t> mByName; // views into mData
+
+	const Entry* GetEntries() const {
+		return reinterpret_cast<const Entry*>(mData.data() + sizeof(Header));
+	}
+};
@@ -5,11 +5,14 @@
 #include <maps.h>
 #include <temple/vfs.h>
 #include <tio/tio.h>
+#include <infrastructure/stopwatch.h>
 
 #include "gamesystems/gamesystems.h"
 #include "gamesystems/mapsystem.h"
 #include "gamesystems/timeevents.h"
 #include "gamesystems/objects/objsystem.h"
+#include "gameview.h"
+#include "party.h"
 
 static_assert(temple::validate_size<SectorTilePacket, 66052>::value, "SectorTilePacket has incorrect size");
 static_assert(temple::validate_size<TileListEntry, 112>::value, "TileListEntry has incorrect size");
@@ -93,6 +96,28 @@ struct LegacySectorAddresses : temple::AddressTable
 LegacySectorSystem  sectorSys;
 BOOL(__cdecl * LegacySectorSystem::orgSectorCacheFind)(SectorLoc secLoc, int * secCacheIdx);
 
+static MapSectorSystem::CacheStats sectorCacheStats;
+static bool sectorPrefetching = false; // the locks made by the SectorPrefetcher don't count as demand locks
+
+static void RecordSectorLock()
+{
+	if (!sectorPrefetching) {
+		sectorCacheStats.lockCount++;
+	}
+}
+
+static void RecordSectorLoad(int64_t timeUs)
+{
+	if (sectorPrefetching) {
+		sectorCacheStats.prefetchCount++;
+		sectorCacheStats.prefetchTimeUs += timeUs;
+	} else {
+		sectorCacheStats.loadCount++;
+		sectorCacheStats.loadTimeUs += timeUs;
+		sectorCacheStats.maxLoadTimeUs = std::max(sectorCacheStats.maxLoadTimeUs, timeUs);
+	}
+}
+
 
 class SectorHooks : TempleFix
 {
@@ -134,6 +159,21 @@ public:
 			return orgObjlistInsertInternal(objs, handle);
 			});
 
+		// Only to gather the sector cache statistics
+		static int(__cdecl * orgSectorLock)(SectorLoc, Sector**) =
+			replaceFunction<int(__cdecl)(SectorLoc, Sector**)>(0x10082700, [](SectorLoc secLoc, Sector** sectOut) {
+			RecordSectorLock();
+			return orgSectorLock(secLoc, sectOut);
+		});
+
+		static BOOL(__cdecl * orgSectorLoadGameMode)(SectorLoc, Sector*) =
+			replaceFunction<BOOL(__cdecl)(SectorLoc, Sector*)>(0x10083210, [](SectorLoc secLoc, Sector* sect) {
+			Stopwatch sw;
+			auto result = orgSectorLoadGameMode(secLoc, sect);
+			RecordSectorLoad(sw.GetElapsedUs());
+			return result;
+		});
+
 		static BOOL(__cdecl*orgSectorLoadObjs)(SectorObjects*, TioFile *, SectorLoc)
 		=replaceFunction<BOOL(__cdecl)(SectorObjects* , TioFile* , SectorLoc )>(0x100C1B20,
 			[](SectorObjects* secObjs, TioFile* file, SectorLoc sectorLoc) {
@@ -440,6 +480,7 @@ int LegacySectorSystem::SectorLock(SectorLoc secLoc, Sector** sectorOut)
 	if (secLoc.x() >= GetSectorLimitX() || secLoc.y() >= GetSectorLimitY())
 		return 0;
 
+	RecordSectorLock();
 	
 	int * secIndices = *addresses.sectorCacheIndices;
 	auto secCacheIdx = secIndices[sectorCacheIndicesCurIdx];
@@ -674,13 +715,18 @@ void MapSectorSystem::ResetBuffers(const RebuildBufferInfo& rebuildInfo) {
 	resetBuffers(&rebuildInfo);
 }
 void MapSectorSystem::Reset() {
+	mPrefetcher.Reset();
 	auto reset = temple::GetPointer<void()>(0x10084120);
 	reset();
 }
 void MapSectorSystem::CloseMap() {
+	mPrefetcher.Reset();
 	auto mapClose = temple::GetPointer<void()>(0x100842e0);
 	mapClose();
 }
+void MapSectorSystem::AdvanceTime(uint32_t time) {
+	mPrefetcher.Update(time);
+}
 const std::string &MapSectorSystem::GetName() const {
 	static std::string name("MapSector");
 	return name;
@@ -711,6 +757,138 @@ void MapSectorSystem::RemoveSectorLight(objHndl handle)
 	map_sector_reset_sectorlight(handle);
 }
 
+const MapSectorSystem::CacheStats& MapSectorSystem::GetCacheStats()
+{
+	return sectorCacheStats;
+}
+
+void MapSectorSystem::ResetCacheStats()
+{
+	sectorCacheStats = {};
+}
+
+//*****************************************************************************
+//* SectorPrefetcher
+//*****************************************************************************
+
+static constexpr float SectorSideInches = SECTOR_SIDE_SIZE * INCH_PER_TILE;
+
+// How far ahead the movement is extrapolated
+static constexpr float PrefetchLookaheadSecs = 2.0f;
+static constexpr float MaxPrefetchDistance = 2 * SectorSideInches;
+
+// Slower movement (e.g. the camera coming to a stop) isn't worth prefetching for
+static constexpr float MinPrefetchSpeed = 2 * INCH_PER_TILE;
+
+// Time spent on prefetching per frame. Loads aren't interrupted, so a big sector can take longer.
+static constexpr int64_t PrefetchBudgetUs = 2000;
+static constexpr size_t MaxPrefetchQueue = 16;
+
+void SectorPrefetcher::MotionTracker::Update(XMFLOAT2 newPos, float deltaSecs)
+{
+	if (valid && deltaSecs <= 0) {
+		return;
+	}
+
+	auto dx = newPos.x - pos.x, dy = newPos.y - pos.y;
+	if (!valid || fabs(dx) > SectorSideInches || fabs(dy) > SectorSideInches) {
+		// Teleports and the camera jumping to someone say nothing about where it's headed
+		velocity = { 0, 0 };
+	} else {
+		constexpr float Smoothing = 0.25f;
+		velocity.x += Smoothing * (dx / deltaSecs - velocity.x);
+		velocity.y += Smoothing * (dy / deltaSecs - velocity.y);
+	}
+	pos = newPos;
+	valid = true;
+}
+
+void SectorPrefetcher::Update(uint32_t time)
+{
+	if (!gameView || !gameSystems->GetMap().IsMapOpen()) {
+		Reset();
+		return;
+	}
+
+	auto deltaSecs = mLastUpdate ? (time - mLastUpdate) / 1000.0f : 0.0f;
+	mLastUpdate = time;
+
+	auto screenCenter = gameView->GetScreenCenterInWorld3d();
+	mCamera.Update({ screenCenter.x, screenCenter.z }, deltaSecs);
+
+	auto leader = party.GetLeader();
+	if (leader) {
+		mLeader.Update(objects.GetLocationFull(leader).ToInches2D(), deltaSecs);
+	} else {
+		mLeader.valid = false;
+	}
+
+	mQueue.clear();
+	EnqueueAlong(mCamera);
+	EnqueueAlong(mLeader);
+
+	sectorPrefetching = true;
+	Stopwatch sw;
+	for (auto secLoc : mQueue) {
+		if (sw.GetElapsedUs() >= PrefetchBudgetUs) {
+			break;
+		}
+		Sector* sector;
+		if (addresses.SectorLock(secLoc, &sector)) {
+			addresses.SectorUnlock(secLoc);
+		}
+	}
+	sectorPrefetching = false;
+}
+
+void SectorPrefetcher::Reset()
+{
+	mCamera = {};
+	mLeader = {};
+	mLastUpdate = 0;
+	mQueue.clear();
+}
+
+void SectorPrefetcher::EnqueueAlong(const MotionTracker& tracker)
+{
+	if (!tracker.valid) {
+		return;
+	}
+	auto speed = sqrtf(tracker.velocity.x * tracker.velocity.x + tracker.velocity.y * tracker.velocity.y);
+	if (speed < MinPrefetchSpeed) {
+		return;
+	}
+
+	// Samples the predicted path every half sector, along with the sectors around each sample, which
+	// covers what becomes visible when the view is centered there
+	auto distance = std::min(speed * PrefetchLookaheadSecs, MaxPrefetchDistance);
+	auto dirX = tracker.velocity.x / speed, dirY = tracker.velocity.y / speed;
+	for (auto d = SectorSideInches / 2; d <= distance; d += SectorSideInches / 2) {
+		auto secX = (int)floorf((tracker.pos.x + dirX * d) / SectorSideInches);
+		auto secY = (int)floorf((tracker.pos.y + dirY * d) / SectorSideInches);
+		Enqueue(secX, secY);
+		for (int dy = -1; dy <= 1; dy++) {
+			for (int dx = -1; dx <= 1; dx++) {
+				Enqueue(secX + dx, secY + dy);
+			}
+		}
+	}
+}
+
+void SectorPrefetcher::Enqueue(int secX, int secY)
+{
+	if (mQueue.size() >= MaxPrefetchQueue || secX < 0 || secY < 0
+		|| (uint64_t)secX >= LegacySectorSystem::GetSectorLimitX() || (uint64_t)secY >= LegacySectorSystem::GetSectorLimitY()) {
+		return;
+	}
+
+	SectorLoc secLoc(secX, secY);
+	if (std::find(mQueue.begin(), mQueue.end(), secLoc) != mQueue.end() || addresses.SectorCacheLocExists(secLoc)) {
+		return;
+	}
+	mQueue.push_back(secLoc);
+}
+
 int SectorHooks::SectorTileIsBlocking_OldVersion(locXY loc, int regardSinks){
 	// should always return 0 in ToEE...
 	auto tileFlags = sectorSys.GetTileFlags({ loc, 0,0 });
@@ -320,7 +320,39 @@ private:
 	Sector* mSector = nullptr;
 };
 
-class MapSectorSystem : public GameSystem, public BufferResettingGameSystem, public ResetAwareGameSystem, public MapCloseAwareGameSystem {
+/*
+	Loads the sectors the view is about to reach into the sector cache ahead of time, so scrolling
+	or following the party doesn't stall on sector loads once the sectors become visible.
+
+	Where the view is headed is predicted from the velocity of the camera and of the party leader.
+	Loading a sector runs the vanilla loader (tile data, lights, scripts and objects), which is only
+	safe on the main thread, so the sectors are loaded between frames within a small time budget.
+*/
+class SectorPrefetcher {
+public:
+	void Update(uint32_t time);
+	void Reset();
+
+private:
+	// Smoothed velocity of a point in world space (in inches)
+	struct MotionTracker {
+		XMFLOAT2 pos;
+		XMFLOAT2 velocity; // per second
+		bool valid = false;
+
+		void Update(XMFLOAT2 newPos, float deltaSecs);
+	};
+
+	MotionTracker mCamera;
+	MotionTracker mLeader;
+	uint32_t mLastUpdate = 0;
+	std::vector<SectorLoc> mQueue; // nearest first
+
+	void EnqueueAlong(const MotionTracker& tracker);
+	void Enqueue(int secX, int secY);
+};
+
+class MapSectorSystem : public GameSystem, public BufferResettingGameSystem, public ResetAwareGameSystem, public MapCloseAwareGameSystem, public TimeAwareGameSystem {
 public:
 	static constexpr auto Name = "MapSector";
 	MapSectorSystem(const GameSystemConf &config);
@@ -328,6 +360,7 @@ public:
 	void Reset() override;
 	void ResetBuffers(const RebuildBufferInfo& rebuildInfo) override;
 	void CloseMap() override;
+	void AdvanceTime(uint32_t time) override;
 	const std::string &GetName() const override;
 
 	void Clear();
@@ -337,7 +370,23 @@ public:
 
 	void RemoveSectorLight(objHndl handle);
 
+	/**
+	 * Sector cache statistics, shown in the debug UI.
+	 * Sectors locked for prefetching only count towards the prefetch numbers.
+	 */
+	struct CacheStats {
+		uint32_t lockCount = 0;
+		uint32_t loadCount = 0; // locks that missed the cache
+		int64_t loadTimeUs = 0;
+		int64_t maxLoadTimeUs = 0;
+		uint32_t prefetchCount = 0;
+		int64_t prefetchTimeUs = 0;
+	};
+	static const CacheStats& GetCacheStats();
+	static void ResetCacheStats();
 
+private:
+	SectorPrefetcher mPrefetcher;
 };
 
 struct PointAlongSegment;
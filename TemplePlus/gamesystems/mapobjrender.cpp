@@ -3,6 +3,8 @@
 #include <util/fixes.h>
 #include <obj.h>
 #include "gamesystems/map/sector.h"
+#include "gamesystems/objects/objsystem.h"
+#include "gamesystems/mapsystem.h"
 #include "gamesystems/particlesystems.h"
 #include <config/config.h>
 #include <temple/meshes.h>
@@ -115,18 +117,66 @@ void MapObjectRenderer::RenderMapObjects(int tileX1, int tileX2, int tileY1, int
 	mTotalLastFrame = 0;
 	mRenderedLastFrame = 0;
 
+	GatherVisibleObjects(tileX1, tileX2, tileY1, tileY2);
+	ResetLightGrid(tileX1, tileX2, tileY1, tileY2);
+
+	SkinMapObjects();
+
+	for (auto &visibleObj : mVisibleObjects) {
+		RenderObject(visibleObj.handle, true);
+	}
+
+}
+
+void MapObjectRenderer::GatherVisibleObjects(int tileX1, int tileX2, int tileY1, int tileY2) {
+
+	// Tall or wide objects can reach into the view from tiles outside of it. Moving a tile away
+	// moves an object by at least half a tile's length on screen.
+	UpdateMaxObjectReach();
+	auto tileMargin = 1 + (int)ceilf(mMaxObjectReach / INCH_PER_HALFTILE);
+
+	mVisibleObjects.clear();
+
 	for (auto secY = tileY1 / 64; secY <= tileY2 / 64; ++secY) {
 		for (auto secX = tileX1 / 64; secX <= tileX2 / 64; ++secX) {
 
 			LockedMapSector sector(secX, secY);
 
-			for (auto tx = 0; tx < 64; ++tx) {
-				for (auto ty = 0; ty < 64; ++ty) {
-
-					auto obj = sector.GetObjectsAt(tx, ty);
-					while (obj) {
-						RenderObject(obj->handle, true);
-						obj = obj->next;
+			// Only visit the part of the sector that is in view
+			auto txFrom = std::max(0, tileX1 - tileMargin - secX * 64);
+			auto txTo = std::min(63, tileX2 + tileMargin - secX * 64);
+			auto tyFrom = std::max(0, tileY1 - tileMargin - secY * 64);
+			auto tyTo = std::min(63, tileY2 + tileMargin - secY * 64);
+
+			for (auto tx = txFrom; tx <= txTo; ++tx) {
+				for (auto ty = tyFrom; ty <= tyTo; ++ty) {
+
+					for (auto obj = sector.GetObjectsAt(tx, ty); obj; obj = obj->next) {
+						auto handle = obj->handle;
+						if (objects.GetFlags(handle) & (OF_OFF | OF_DESTROYED | OF_DONTDRAW)) {
+							continue;
+						}
+
+						// Objects whose render height isn't known yet get it from their model in RenderObject
+						auto renderHeight = objects.GetRenderHeight(handle);
+						if (renderHeight >= 0) {
+							auto animParams(objects.GetAnimParams(handle));
+							LocAndOffsets worldPosFull;
+							worldPosFull.location = objects.GetLocation(handle);
+							worldPosFull.off_x = animParams.offsetX;
+							worldPosFull.off_y = animParams.offsetY;
+							auto radius = objects.GetRadius(handle);
+							IncludeInMaxObjectReach(animParams.offsetZ, radius, renderHeight);
+							if (!IsObjectOnScreen(worldPosFull, animParams.offsetZ, radius, renderHeight)) {
+								continue;
+							}
+						}
+
+						VisibleObject visibleObj;
+						visibleObj.handle = handle;
+						visibleObj.translucent = objects.GetAlpha(handle) < 255;
+						visibleObj.baseMesh = objects.getInt32(handle, obj_f_base_mesh);
+						mVisibleObjects.push_back(visibleObj);
 					}
 
 				}
@@ -134,6 +184,73 @@ void MapObjectRenderer::RenderMapObjects(int tileX1, int tileX2, int tileY1, int
 		}
 	}
 
+	// Translucent objects keep their order and are drawn after the opaque ones
+	std::stable_sort(mVisibleObjects.begin(), mVisibleObjects.end(), [](const VisibleObject &a, const VisibleObject &b) {
+		if (a.translucent != b.translucent) {
+			return b.translucent;
+		}
+		return !a.translucent && a.baseMesh < b.baseMesh;
+	});
+
+	mVisibleObjectsValid = true;
+	mVisibleTileX1 = tileX1;
+	mVisibleTileX2 = tileX2;
+	mVisibleTileY1 = tileY1;
+	mVisibleTileY2 = tileY2;
+
+}
+
+void MapObjectRenderer::UpdateMaxObjectReach() {
+
+	auto mapId = gameSystems->GetMap().GetCurrentMapId();
+	if (mapId == mMaxObjectReachMapId) {
+		return;
+	}
+	mMaxObjectReachMapId = mapId;
+	mMaxObjectReach = 0;
+
+	objSystem->ForEachObj([this](objHndl handle, GameObjectBody &obj) {
+		if (obj.GetFlags() & (OF_INVENTORY | OF_DESTROYED)) {
+			return;
+		}
+		IncludeInMaxObjectReach(obj.GetFloat(obj_f_offset_z), obj.GetFloat(obj_f_radius), obj.GetFloat(obj_f_3d_render_height));
+	});
+
+}
+
+void MapObjectRenderer::IncludeInMaxObjectReach(float offsetZ, float radius, float renderHeight) {
+
+	// Same limits as the render functions use for bugged sizes
+	if (renderHeight < 0 || renderHeight > 10000.0f || radius < 0 || radius >= 2000.0f) {
+		return;
+	}
+
+	// The extent of the screen bounding box used by IsObjectOnScreen
+	auto reach = std::max((std::max(offsetZ, 0.0f) + renderHeight + radius) * cos45, radius);
+	mMaxObjectReach = std::max(mMaxObjectReach, reach);
+
+}
+
+void MapObjectRenderer::SkinMapObjects() {
+
+	gfx::SkinningBatch batch;
+
+	for (auto &visibleObj : mVisibleObjects) {
+		auto handle = visibleObj.handle;
+
+		// RenderObject may still skip some of these, but skinning a few models too many doesn't hurt
+		if (objects.GetRenderHeight(handle) < 0) {
+			continue;
+		}
+
+		auto animatedModel = objects.GetAnimHandle(handle);
+		if (animatedModel) {
+			animatedModel->AddToSkinningBatch(objects.GetAnimParams(handle), batch);
+		}
+	}
+
+	batch.Run();
+
 }
 
 void MapObjectRenderer::RenderObject(objHndl handle, bool showInvisible) {
@@ -411,25 +528,20 @@ void MapObjectRenderer::RenderOccludedMapObjects(int tileX1, int tileX2, int til
 
 	gfx::PerfGroup perfGroup(mDevice, "Occluded Map Objects");
 
-	for (auto secY = tileY1 / 64; secY <= tileY2 / 64; ++secY) {
-		for (auto secX = tileX1 / 64; secX <= tileX2 / 64; ++secX) {
-
-			LockedMapSector sector(secX, secY);
-
-			for (auto tx = 0; tx < 64; ++tx) {
-				for (auto ty = 0; ty < 64; ++ty) {
-
-					auto obj = sector.GetObjectsAt(tx, ty);
-					while (obj) {
-						RenderOccludedObject(obj->handle);
-						obj = obj->next;
-					}
+	if (!mVisibleObjectsValid
+		|| tileX1 != mVisibleTileX1 || tileX2 != mVisibleTileX2
+		|| tileY1 != mVisibleTileY1 || tileY2 != mVisibleTileY2) {
+		GatherVisibleObjects(tileX1, tileX2, tileY1, tileY2);
+	}
 
-				}
-			}
-		}
+	for (auto &visibleObj : mVisibleObjects) {
+		RenderOccludedObject(visibleObj.handle);
 	}
 
+	// The objects and lights may have changed by the next frame
+	mVisibleObjectsValid = false;
+	mLightGridValid = false;
+
 }
 
 void MapObjectRenderer::RenderOccludedObject(objHndl handle) {
@@ -715,9 +827,9 @@ private:
 	std::unique_ptr<LockedMapSector> mLockedSector;
 };
 
-std::vector<Light3d> MapObjectRenderer::FindLights(LocAndOffsets atLocation, float radius) {
+ObjectLights MapObjectRenderer::FindLights(LocAndOffsets atLocation, float radius) {
 
-	std::vector<Light3d> lights;
+	ObjectLights lights;
 
 	if (*addresses.globalLightEnabled) {
 		Light3d light;
@@ -750,10 +862,40 @@ std::vector<Light3d> MapObjectRenderer::FindLights(LocAndOffsets atLocation, flo
 	auto tileY1 = atLocation.location.locy - 1 - boxDimensions;
 	auto tileY2 = atLocation.location.locy + 1 + boxDimensions;
 
-	SectorIterator sectorIterator(tileX1, tileX2, tileY1, tileY2);
-
 	auto atPos = atLocation.ToInches2D();
 
+	auto addIfInRange = [&](const Light3d &light3d, XMFLOAT2 lightPos, float lightRange) {
+		// Distance (Squared) between pos and light pos
+		auto acceptableDistance = (int)(radius + lightRange);
+		auto acceptableDistanceSquared = acceptableDistance * acceptableDistance;
+		auto diffX = static_cast<int>(atPos.x - lightPos.x);
+		auto diffY = static_cast<int>(atPos.y - lightPos.y);
+		auto distanceSquared = diffX * diffX + diffY * diffY;
+		if (distanceSquared <= acceptableDistanceSquared) {
+			lights.push_back(light3d);
+		}
+	};
+
+	// Use the lights gathered for this frame if the search box is covered by the grid
+	auto secX1 = tileX1 / 64, secX2 = tileX2 / 64;
+	auto secY1 = tileY1 / 64, secY2 = tileY2 / 64;
+	if (mLightGridValid
+		&& secX1 >= mLightGridSecX && secX2 < mLightGridSecX + mLightGridWidth
+		&& secY1 >= mLightGridSecY && secY2 < mLightGridSecY + mLightGridHeight) {
+		for (auto secY = secY1; secY <= secY2; ++secY) {
+			for (auto secX = secX1; secX <= secX2; ++secX) {
+				auto &bucket = GetLightBucket(secX, secY);
+				for (auto i = bucket.first; i < bucket.first + bucket.count; ++i) {
+					auto &gridLight = mGridLights[i];
+					addIfInRange(gridLight.light, gridLight.pos, gridLight.range);
+				}
+			}
+		}
+		return lights;
+	}
+
+	SectorIterator sectorIterator(tileX1, tileX2, tileY1, tileY2);
+
 	while (sectorIterator.HasNext()) {
 		auto& sector = sectorIterator.Next();
 
@@ -761,127 +903,168 @@ std::vector<Light3d> MapObjectRenderer::FindLights(LocAndOffsets atLocation, flo
 		while (lightIt.HasNext()) {
 			auto& light = lightIt.Next();
 
-			int type;
-			uint32_t color;
-			XMFLOAT3 direction;
-			float range, phi;
-			auto lightPos = light.position.ToInches2D();
-
-			if (light.flags & 0x40) {
-				if (*addresses.isNight) {
-					type = light.light2.type;
-					color = light.light2.color;
-					direction = light.light2.direction;
-					range = light.range; // Notice how it's using light 1's range
-					phi = light.light2.phi;
-
-					/*
-					Kill the daytime particle system if it's night and the
-					daytime particle system is still alive.
-					*/
-					if (light.partSys.handle) {
-						gameSystems->GetParticleSys().Remove(light.partSys.handle);
-						light.partSys.handle = 0;
-					}
+			Light3d light3d;
+			if (ConvertSectorLight(light, light3d)) {
+				addIfInRange(light3d, light.position.ToInches2D(), light.range);
+			}
+		}
+	}
 
-					/*
-					If the nighttime particle system has not yet been started,
-					do it here.
-					*/
-					auto& nightPartSys = light.light2.partSys;
-					if (!nightPartSys.handle && nightPartSys.hashCode) {
-						auto centerOfTile = light.position.ToInches3D(light.offsetZ);
-						nightPartSys.handle = gameSystems->GetParticleSys().CreateAt(
-							nightPartSys.hashCode, centerOfTile
-						);
-					}
-				} else {
-					type = light.type;
-					color = light.color;
-					direction = light.direction;
-					range = light.range;
-					phi = light.phi;
-
-					// This is just the inverse of what we're doing at night (see above)
-					auto& nightPartSys = light.light2.partSys;
-					if (nightPartSys.handle) {
-						gameSystems->GetParticleSys().Remove(nightPartSys.handle);
-						nightPartSys.handle = 0;
-					}
+	return lights;
 
-					auto& dayPartSys = light.partSys;
-					if (!dayPartSys.handle && dayPartSys.hashCode) {
-						auto centerOfTile = light.position.ToInches3D(light.offsetZ);
-						dayPartSys.handle = gameSystems->GetParticleSys().CreateAt(
-							dayPartSys.hashCode, centerOfTile
-						);
-					}
-				}
-			}
-			else {
-				type = light.type;
-				color = light.color;
-				direction = light.direction;
-				range = light.range;
-				phi = light.phi;
-			}
+}
 
-			if (!type) {
-				continue;
-			}
+bool MapObjectRenderer::ConvertSectorLight(SectorLight &light, Light3d &light3d) {
 
-			// Distance (Squared) between pos and light pos
-			auto acceptableDistance = (int)(radius + light.range);
-			auto acceptableDistanceSquared = acceptableDistance * acceptableDistance;
-			auto diffX = static_cast<int>(atPos.x - lightPos.x);
-			auto diffY = static_cast<int>(atPos.y - lightPos.y);
-			auto distanceSquared = diffX * diffX + diffY * diffY;
-			if (distanceSquared > acceptableDistanceSquared) {
-				continue;
-			}
+	int type;
+	uint32_t color;
+	XMFLOAT3 direction;
+	float range, phi;
+	auto lightPos = light.position.ToInches2D();
 
-			Light3d light3d;
-			if (type == 2) {
-				light3d.type = Light3dType::Directional;
-				auto normalizedDir = XMVector3Normalize(XMLoadFloat3(&direction));
-				XMStoreFloat4(&light3d.dir, normalizedDir);
-				light3d.dir.w = 0;
+	if (light.flags & 0x40) {
+		if (*addresses.isNight) {
+			type = light.light2.type;
+			color = light.light2.color;
+			direction = light.light2.direction;
+			range = light.range; // Notice how it's using light 1's range
+			phi = light.light2.phi;
+
+			/*
+			Kill the daytime particle system if it's night and the
+			daytime particle system is still alive.
+			*/
+			if (light.partSys.handle) {
+				gameSystems->GetParticleSys().Remove(light.partSys.handle);
+				light.partSys.handle = 0;
 			}
-			else if (type == 3) {
-				light3d.type = Light3dType::Spot;
-				auto normalizedDir = XMVector3Normalize(XMLoadFloat3(&direction));
-				XMStoreFloat4(&light3d.dir, normalizedDir);
-				light3d.dir.w = 0;
+
+			/*
+			If the nighttime particle system has not yet been started,
+			do it here.
+			*/
+			auto& nightPartSys = light.light2.partSys;
+			if (!nightPartSys.handle && nightPartSys.hashCode) {
+				auto centerOfTile = light.position.ToInches3D(light.offsetZ);
+				nightPartSys.handle = gameSystems->GetParticleSys().CreateAt(
+					nightPartSys.hashCode, centerOfTile
+				);
 			}
-			else if (type == 1) {
-				light3d.type = Light3dType::Point;
-				light3d.dir.x = direction.x;
-				light3d.dir.y = direction.y;
-				light3d.dir.z = direction.z;
+		} else {
+			type = light.type;
+			color = light.color;
+			direction = light.direction;
+			range = light.range;
+			phi = light.phi;
+
+			// This is just the inverse of what we're doing at night (see above)
+			auto& nightPartSys = light.light2.partSys;
+			if (nightPartSys.handle) {
+				gameSystems->GetParticleSys().Remove(nightPartSys.handle);
+				nightPartSys.handle = 0;
 			}
 
-			// Some vanilla lights are broken
-			if (light3d.dir.x == 0.0f && light3d.dir.y == 0.0f && light3d.dir.z == 0.0f) {
-				light3d.dir.x = 0.0f;
-				light3d.dir.y = 0.0f;
-				light3d.dir.z = 1.0f;
+			auto& dayPartSys = light.partSys;
+			if (!dayPartSys.handle && dayPartSys.hashCode) {
+				auto centerOfTile = light.position.ToInches3D(light.offsetZ);
+				dayPartSys.handle = gameSystems->GetParticleSys().CreateAt(
+					dayPartSys.hashCode, centerOfTile
+				);
 			}
+		}
+	}
+	else {
+		type = light.type;
+		color = light.color;
+		direction = light.direction;
+		range = light.range;
+		phi = light.phi;
+	}
 
-			light3d.pos.x = lightPos.x;
-			light3d.pos.y = light.offsetZ;
-			light3d.pos.z = lightPos.y;
+	if (!type) {
+		return false;
+	}
 
-			light3d.color.x = (color & 0xFF) / 255.0f;
-			light3d.color.y = ((color >> 16) & 0xFF) / 255.0f;
-			light3d.color.z = ((color >> 8) & 0xFF) / 255.0f;
+	if (type == 2) {
+		light3d.type = Light3dType::Directional;
+		auto normalizedDir = XMVector3Normalize(XMLoadFloat3(&direction));
+		XMStoreFloat4(&light3d.dir, normalizedDir);
+		light3d.dir.w = 0;
+	}
+	else if (type == 3) {
+		light3d.type = Light3dType::Spot;
+		auto normalizedDir = XMVector3Normalize(XMLoadFloat3(&direction));
+		XMStoreFloat4(&light3d.dir, normalizedDir);
+		light3d.dir.w = 0;
+	}
+	else if (type == 1) {
+		light3d.type = Light3dType::Point;
+		light3d.dir.x = direction.x;
+		light3d.dir.y = direction.y;
+		light3d.dir.z = direction.z;
+	}
 
-			light3d.range = range;
-			light3d.phi = phi;
-			lights.push_back(light3d);
+	// Some vanilla lights are broken
+	if (light3d.dir.x == 0.0f && light3d.dir.y == 0.0f && light3d.dir.z == 0.0f) {
+		light3d.dir.x = 0.0f;
+		light3d.dir.y = 0.0f;
+		light3d.dir.z = 1.0f;
+	}
+
+	light3d.pos.x = lightPos.x;
+	light3d.pos.y = light.offsetZ;
+	light3d.pos.z = lightPos.y;
+
+	light3d.color.x = (color & 0xFF) / 255.0f;
+	light3d.color.y = ((color >> 16) & 0xFF) / 255.0f;
+	light3d.color.z = ((color >> 8) & 0xFF) / 255.0f;
+
+	light3d.range = range;
+	light3d.phi = phi;
+	return true;
+
+}
+
+void MapObjectRenderer::ResetLightGrid(int tileX1, int tileX2, int tileY1, int tileY2) {
+
+	// Light searches reach a few dozen tiles past an object (see FindLights), so a sector
+	// around the view covers the objects in it. Searches reaching further use the sectors directly.
+	mLightGridSecX = tileX1 / 64 - 1;
+	mLightGridSecY = tileY1 / 64 - 1;
+	mLightGridWidth = tileX2 / 64 + 2 - mLightGridSecX;
+	mLightGridHeight = tileY2 / 64 + 2 - mLightGridSecY;
+
+	mLightGrid.assign(mLightGridWidth * mLightGridHeight, LightBucket());
+	mGridLights.clear();
+	mLightGridValid = true;
+
+}
+
+const MapObjectRenderer::LightBucket &MapObjectRenderer::GetLightBucket(int secX, int secY) {
+
+	auto &bucket = mLightGrid[(secY - mLightGridSecY) * mLightGridWidth + (secX - mLightGridSecX)];
+	if (bucket.filled) {
+		return bucket;
+	}
+
+	bucket.filled = true;
+	bucket.first = mGridLights.size();
+
+	LockedMapSector sector(secX, secY);
+	auto lightIt = sector.GetLights();
+	while (lightIt.HasNext()) {
+		auto& light = lightIt.Next();
+
+		GridLight gridLight;
+		if (ConvertSectorLight(light, gridLight.light)) {
+			gridLight.pos = light.position.ToInches2D();
+			gridLight.range = light.range;
+			mGridLights.push_back(gridLight);
 		}
 	}
 
-	return lights;
+	bucket.count = mGridLights.size() - bucket.first;
+	return bucket;
 
 }
 
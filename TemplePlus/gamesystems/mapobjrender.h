@@ -1,12 +1,12 @@
 ﻿#pragma once
 
 #include <obj.h>
+#include <graphics/materials.h>
 
 namespace gfx {
 	struct AnimatedModelParams;
 	class RenderingDevice;
 	class WorldCamera;
-	struct Light3d;
 	class AnimatedModel;
 	class MdfMaterialFactory;
 	using MdfRenderMaterialPtr = std::shared_ptr<class MdfRenderMaterial>;
@@ -17,6 +17,50 @@ namespace aas {
 }
 
 class GameSystems;
+struct SectorLight;
+
+/*
+	The lights affecting an object. Holds as many lights as the materials can use, the ones
+	found past that are dropped (the materials would ignore them anyway).
+*/
+class ObjectLights {
+public:
+	static constexpr size_t Capacity = 8;
+
+	using value_type = gfx::Light3d;
+	using pointer = gfx::Light3d*;
+
+	void push_back(const gfx::Light3d &light) {
+		if (mCount < Capacity) {
+			mLights[mCount++] = light;
+		}
+	}
+	void clear() {
+		mCount = 0;
+	}
+	bool empty() const {
+		return mCount == 0;
+	}
+	size_t size() const {
+		return mCount;
+	}
+	gfx::Light3d* data() {
+		return mLights.data();
+	}
+	gfx::Light3d& operator[](size_t idx) {
+		return mLights[idx];
+	}
+	gfx::Light3d* begin() {
+		return mLights.data();
+	}
+	gfx::Light3d* end() {
+		return mLights.data() + mCount;
+	}
+
+private:
+	std::array<gfx::Light3d, Capacity> mLights;
+	size_t mCount = 0;
+};
 
 enum class ShadowType {
 	ShadowMap,
@@ -63,7 +107,11 @@ public:
 		return mShowHighlights;
 	}
 
-	std::vector<gfx::Light3d> FindLights(LocAndOffsets atLocation, float radius);
+	/*
+		Finds the global light and the sector lights within reach of a location. During a frame,
+		the lights come from the light grid built for the visible sectors (see ResetLightGrid).
+	*/
+	ObjectLights FindLights(LocAndOffsets atLocation, float radius);
 
 private:
 	GameSystems& mGameSystems;
@@ -81,6 +129,59 @@ private:
 	size_t mRenderedLastFrame = 0;
 	size_t mTotalLastFrame = 0;
 
+	/*
+		The objects in view, gathered by RenderMapObjects and reused by RenderOccludedMapObjects
+		for the same tile rect, so the sectors only have to be walked once per frame.
+	*/
+	struct VisibleObject {
+		objHndl handle;
+		bool translucent;
+		int baseMesh;
+	};
+	std::vector<VisibleObject> mVisibleObjects;
+	bool mVisibleObjectsValid = false;
+	int mVisibleTileX1 = 0, mVisibleTileX2 = 0, mVisibleTileY1 = 0, mVisibleTileY2 = 0;
+
+	/*
+		How far (in screen pixels at zoom 1) the tallest or widest object on the current map reaches
+		out of its tile, which decides how many tiles around the view have to be visited.
+		Taken from all objects when the map changes, and raised by the objects gathered after that.
+	*/
+	float mMaxObjectReach = 0;
+	int mMaxObjectReachMapId = -1;
+	void UpdateMaxObjectReach();
+	void IncludeInMaxObjectReach(float offsetZ, float radius, float renderHeight);
+
+	/*
+		The sector lights around the view, converted once per frame and bucketed by sector,
+		so the objects in view don't each have to lock and walk the sectors around them.
+		Buckets are filled when first queried.
+	*/
+	struct GridLight {
+		gfx::Light3d light;
+		XMFLOAT2 pos; // in inches
+		float range;
+	};
+	struct LightBucket {
+		bool filled = false;
+		size_t first = 0;
+		size_t count = 0;
+	};
+	std::vector<GridLight> mGridLights;
+	std::vector<LightBucket> mLightGrid;
+	int mLightGridSecX = 0, mLightGridSecY = 0;
+	int mLightGridWidth = 0, mLightGridHeight = 0;
+	bool mLightGridValid = false;
+
+	void ResetLightGrid(int tileX1, int tileX2, int tileY1, int tileY2);
+	const LightBucket &GetLightBucket(int secX, int secY);
+
+	/*
+		Converts a sector light to a Light3d, choosing between its day and night version and
+		starting or stopping their particle systems. Returns false for disabled lights.
+	*/
+	static bool ConvertSectorLight(SectorLight &light, gfx::Light3d &light3d);
+
 	/*
 	Same as sin45 incidentally.
 	The idea seems to be that the vertical height of the model is scaled
@@ -89,6 +190,16 @@ private:
 	static constexpr float cos45 = 0.70709997f;
 
 	bool IsObjectOnScreen(LocAndOffsets &location, float offsetZ, float radius, float renderHeight);
+
+	/*
+		Collects the objects on the tiles within the given rect that aren't disabled or obviously off screen,
+		sorted so objects sharing a model (and so their materials) are drawn one after another.
+		The per-object checks of the render functions still apply.
+	*/
+	void GatherVisibleObjects(int tileX1, int tileX2, int tileY1, int tileY2);
+
+	// Skins the models of the visible objects up front, all at once, so it can be spread over multiple threads
+	void SkinMapObjects();
 	void RenderMirrorImages(objHndl handle,
 		const gfx::AnimatedModelParams &animParams,
 		gfx::AnimatedModel &model,
@@ -17,9 +17,11 @@
 
 #include "animgoals/anim.h"
 #include "map/sector.h"
+#include "map/mobilearchive.h"
 #include "obj.h"
 #include "gamesystems/legacysystems.h"
 #include "gamesystems/objects/objsystem.h"
+#include "gamesystems/objects/objmemory.h"
 #include "gamesystems/map/gmesh.h"
 #include "tig/tig_startup.h"
 #include "temple/soundsystem.h"
@@ -314,6 +316,22 @@ void MapSystem::LoadModule() {
 
 			
 		});
+
+	// Packs the .mob files of the given maps (all of them by default) into mobile archives, see MobileArchive
+	RegisterDebugFunctionWithArgs("pack_mobs",
+		[&](const std::vector<std::string>& args) {
+			for (auto& it : mMaps) {
+				auto& entry = it.second;
+				if (!args.empty() && std::find(args.begin(), args.end(), entry.name) == args.end()) {
+					continue;
+				}
+				auto dataDir = fmt::format("maps\\{}", entry.name);
+				auto packed = MobileArchive::Pack(dataDir);
+				if (packed >= 0) {
+					logger->info("Packed {} mobiles of map {} into {}\\{}", packed, entry.name, dataDir, MobileArchive::FileName);
+				}
+			}
+		});
 }
 
 void MapSystem::UnloadModule() {
@@ -1152,6 +1170,9 @@ void MapSystem::CloseMap()
 		ClearObjects();
 		gameSystems->GetParticleSys().RemoveAll();
 
+		// Give back the chunks the map's objects were using
+		objMemory.Trim();
+
 		mSectorSaveDir = "";
 		mSectorDataDir = "";
 	}
@@ -1380,27 +1401,79 @@ void MapSystem::ReadMapMobiles(const std::string &dataDir, const std::string &sa
 {
 	auto readObject = temple::GetPointer<BOOL(objHndl*, const char*)>(0x100DE690);
 	
-	// Read all mobiles that shipped with the game files
+	auto onMobileLoaded = [](objHndl handle) {
+		// Temple+: added check for OF_DYNAMIC (fixes "Jerkstop" issue)
+		auto obj = objSystem->GetObject(handle);
+		logger->trace("ReadMapMobiles: \t\tLoaded MOB obj {} ({})", handle, obj->id.ToString() );
+		auto flags = obj->GetFlags();
+		if (flags & OF_DYNAMIC) {
+			logger->error("ReadMapMobiles: \t\t\tMOB file flagged OF_DYNAMIC!!! Unsetting.");
+			obj->SetFlag(OF_DYNAMIC, false);
+		}
+	};
+
+	// Read all mobiles that shipped with the game files. The packed archive has most (or all) of them;
+	// loose .mob files are only read if they are missing from it or have changed since it was packed.
+	// If the map still has loose .mob files, archive entries whose file is gone are stale (the mobile
+	// was deleted after packing) and are skipped; a map that ships only the archive loads all of it.
+	MobileArchive archive;
+	auto hasArchive = archive.Load(dataDir);
+	std::vector<bool> archiveEntryReplaced(archive.GetCount(), false);
+	std::vector<bool> archiveEntryHasSource(archive.GetCount(), false);
+	auto hasMobFiles = false;
+
 	auto mobFiles = vfs->Search(dataDir + "\\*.mob");
+	std::vector<const VfsSearchResult*> looseFiles;
+	looseFiles.reserve(hasArchive ? 16 : mobFiles.size());
+	for (auto &mobFile : mobFiles) {
+		if (mobFile.dir) {
+			continue;
+		}
+		hasMobFiles = true;
+		auto packed = archive.FindFile(mobFile.filename);
+		if (packed) {
+			auto packedIdx = packed - &archive.GetEntry(0);
+			archiveEntryHasSource[packedIdx] = true;
+			if (MobileArchive::IsCurrent(*packed, mobFile)) {
+				continue;
+			}
+			archiveEntryReplaced[packedIdx] = true;
+		}
+		looseFiles.push_back(&mobFile);
+	}
 
-	logger->info("ReadMapMobiles: Loading {} map mobiles from {}", mobFiles.size(), dataDir);
+	logger->info("ReadMapMobiles: Loading map mobiles from {} ({} packed, {} loose files)", dataDir,
+		archive.GetCount(), looseFiles.size());
 
-	for (auto &mobFile : mobFiles) {
-		auto filename = fmt::format("{}\\{}", dataDir, mobFile.filename);
+	for (size_t i = 0; i < archive.GetCount(); i++) {
+		if (archiveEntryReplaced[i]) {
+			continue;
+		}
+		if (hasMobFiles && !archiveEntryHasSource[i]) {
+			logger->info("ReadMapMobiles: \t\tSkipping stale packed mobile {} ({}), its .mob file was removed",
+				archive.GetEntry(i).id.ToString(), archive.GetFileName(archive.GetEntry(i)));
+			continue;
+		}
+		objHndl handle;
+		try {
+			handle = objSystem->LoadFromBuffer(archive.GetData(archive.GetEntry(i)));
+		} catch (TempleException &e) {
+			logger->warn("Unable to load packed mobile object {} for level {}: {}",
+				archive.GetEntry(i).id.ToString(), dataDir, e.what());
+			continue;
+		}
+		onMobileLoaded(handle);
+	}
+
+	for (auto mobFile : looseFiles) {
+		auto filename = fmt::format("{}\\{}", dataDir, mobFile->filename);
 		objHndl handle;
 		if (!readObject(&handle, filename.c_str())) {
 			logger->warn("Unable to load mobile object {} for level {}",
 				filename, dataDir);
 		} else //if (config.debugMessageEnable)
 		{
-			// Temple+: added check for OF_DYNAMIC (fixes "Jerkstop" issue)
-			auto obj = objSystem->GetObject(handle);
-			logger->trace("ReadMapMobiles: \t\tLoaded MOB obj {} ({})", handle, obj->id.ToString() );
-			auto flags = obj->GetFlags();
-			if (flags & OF_DYNAMIC) {
-				logger->error("ReadMapMobiles: \t\t\tMOB file flagged OF_DYNAMIC!!! Unsetting.");
-				obj->SetFlag(OF_DYNAMIC, false);
-			}
+			onMobileLoaded(handle);
 		}
 	}
 
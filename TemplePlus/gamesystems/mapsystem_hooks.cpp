@@ -5,6 +5,7 @@
 #include "gamesystems.h"
 #include "mapsystem.h"
 #include "map/sector.h"
+#include "legacysystems.h"
 #include <config/config.h>
 #include "gamesystems\objects\objsystem.h"
 
@@ -153,20 +154,18 @@ static class MapSystemHooks : public TempleFix {
 
 			if (objSystem->IsValidHandle(handle))
 			{
-				orgCheckFogForCritter(handle, idx);
+				if (config.nativeLineOfSight) {
+					gameSystems->GetMapFogging().PerformCheckForCritter(handle, idx);
+				} else {
+					orgCheckFogForCritter(handle, idx);
+				}
 			} else
 				logger->info("orgCheckFogForCritter encountered null handle!!");
 		});
 
 		// Hooked call to IsPortalOpen inside FogPerformCheckForCritter to account for OF_SEE_THROUGH
 		redirectToLambda<BOOL(objHndl)>(0x10032A23, [](objHndl handle)->BOOL {
-			if (!handle)
-				return TRUE;
-			auto flags = objects.GetFlags(handle);
-			if (flags & OF_SEE_THROUGH) {
-				return TRUE;
-			}
-			return objects.IsPortalOpen(handle) ? TRUE : FALSE;
+			return MapFoggingSystem::CanSeeThroughPortal(handle) ? TRUE : FALSE;
 			});
 	}
 	
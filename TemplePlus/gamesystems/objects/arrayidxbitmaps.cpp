@@ -4,47 +4,12 @@
 
 #include <tio/tio.h>
 
-static uint8_t PopCntSlow(uint32_t value) {
-	uint8_t count = 0;
-	while (value != 0) {
-		if (value & 1) {
-			++count;
-		}
-		value >>= 1;
-	}
-	return count;
-}
-
 ArrayIndexBitmaps::ArrayIndexBitmaps()
 {
 	mBitmapBlocks.reserve(8192);
+	mBlockRanks.reserve(8192);
 	mArrays.reserve(4096);
 	mFreeIds.reserve(4096);
-
-	// Initialize the bitmasks
-	uint32_t bitmask = 0; // No bits set
-	mPartialBitmasks[0] = bitmask;
-	
-	for (auto i = 1; i < 32; ++i) {
-		// Set one more bit
-		bitmask = (bitmask << 1) | 1;
-		mPartialBitmasks[i] = bitmask;
-	}
-
-	// Initialize the bitcount lookup tables
-	// Do it for 0-xFF first, then use that to do the upper word as well
-	for (size_t i = 0; i <= UINT8_MAX; ++i) {
-		// Count bits set in i
-		mBitCountLut[i] = PopCntSlow(i);
-	}
-
-	// Now initialize the rest
-	for (size_t i = UINT8_MAX + 1; i <= UINT16_MAX; ++i) {
-		// Count bits set in i
-		uint8_t upper = (uint16_t)i >> 8;
-		uint8_t lower = i & 0xFF;
-		mBitCountLut[i] = mBitCountLut[upper] + mBitCountLut[lower];
-	}
 }
 
 ArrayIdxMapId ArrayIndexBitmaps::Allocate()
@@ -66,6 +31,8 @@ ArrayIdxMapId ArrayIndexBitmaps::Allocate()
 	indices.firstIdx = mBitmapBlocks.size();
 	mBitmapBlocks.push_back(0);
 	mBitmapBlocks.push_back(0);
+	mBlockRanks.push_back(0);
+	mBlockRanks.push_back(0);
 	mArrays.emplace_back(indices);
 
 	return id;
@@ -86,6 +53,7 @@ void ArrayIndexBitmaps::Free(ArrayIdxMapId id)
 	// Reset the bitmaps
 	for (size_t i = 0; i < arr.count; ++i) {
 		mBitmapBlocks[arr.firstIdx + i] = 0;
+		mBlockRanks[arr.firstIdx + i] = 0;
 	}
 
 	mFreeIds.push_back(id);
@@ -107,6 +75,7 @@ ArrayIdxMapId ArrayIndexBitmaps::Clone(ArrayIdxMapId id)
 	std::copy(mBitmapBlocks.begin() + src.firstIdx,
 		mBitmapBlocks.begin() + src.firstIdx + src.count,
 		mBitmapBlocks.begin() + dest.firstIdx);
+	RebuildRanks(result);
 
 	return result;
 }
@@ -128,7 +97,10 @@ void ArrayIndexBitmaps::RemoveIndex(ArrayIdxMapId id, size_t index)
 
 	// Clear the bit that represents the index
 	uint32_t bit = 1 << (index % 32);
-	bitmapBlock &= ~ bit;
+	if (bitmapBlock & bit) {
+		bitmapBlock &= ~ bit;
+		AdjustRanks(arr, blockIdx, -1);
+	}
 }
 
 void ArrayIndexBitmaps::AddIndex(ArrayIdxMapId id, size_t index)
@@ -149,7 +121,10 @@ void ArrayIndexBitmaps::AddIndex(ArrayIdxMapId id, size_t index)
 
 	// Set the bit that represents the index
 	uint32_t bit = 1 << (index % 32);
-	bitmapBlock |= bit;
+	if (!(bitmapBlock & bit)) {
+		bitmapBlock |= bit;
+		AdjustRanks(arr, blockIdx, 1);
+	}
 }
 
 bool ArrayIndexBitmaps::HasIndex(ArrayIdxMapId id, size_t index) const
@@ -172,23 +147,16 @@ size_t ArrayIndexBitmaps::GetPackedIndex(ArrayIdxMapId id, size_t index) const
 {
 	auto& arr = mArrays[id];
 	auto blockIdx = index / 32;
-	
-	size_t count = 0;
 
-	// The number of fully counted blocks
-	auto fullCounted = std::min(arr.count, blockIdx);
-	for (size_t i = 0; i < fullCounted; ++i) {
-		count += PopCnt(mBitmapBlocks[arr.firstIdx + i]);
-	}
-
-	// The block that contains the actual index bit is counted
-	// and and not including the index bit itself
-	if (blockIdx < arr.count) {
-		uint8_t bitIdx = index % 32;
-		count += PopCntConstrained(mBitmapBlocks[arr.firstIdx + blockIdx], bitIdx);
+	// Every index in the map comes before this one
+	if (blockIdx >= arr.count) {
+		return GetIndexCount(arr);
 	}
 
-	return count;
+	// The preceding blocks are covered by the rank, the block that contains
+	// the actual index bit is counted up to and not including the index bit itself
+	auto pos = arr.firstIdx + blockIdx;
+	return mBlockRanks[pos] + BitOps::PopCountBelow(mBitmapBlocks[pos], index % 32);
 }
 
 size_t ArrayIndexBitmaps::GetSerializedSize(ArrayIdxMapId id) const
@@ -218,6 +186,8 @@ ArrayIdxMapId ArrayIndexBitmaps::DeserializeFromMemory(uint8_t **buffer)
 		mBitmapBlocks[arr.firstIdx + i] = *dwords++;
 	}
 
+	RebuildRanks(result);
+
 	// Write the new deserialization pointer back to the caller
 	*buffer = reinterpret_cast<uint8_t*>(dwords);
 
@@ -266,43 +236,46 @@ ArrayIdxMapId ArrayIndexBitmaps::DeserializeFromFile(TioFile * file)
 	if (tio_fread(&mBitmapBlocks[arr.firstIdx], sizeof(uint32_t), count, file) != count) {
 		throw TempleException("Unable to read array index map data");
 	}
+	RebuildRanks(result);
 	
 	return result;
 }
 
-bool ArrayIndexBitmaps::ForEachIndex(ArrayIdxMapId id, std::function<bool(size_t)> callback) const
+uint8_t ArrayIndexBitmaps::PopCnt(uint32_t value) const
+{
+	return (uint8_t) BitOps::PopCount(value);
+}
+
+uint8_t ArrayIndexBitmaps::PopCntConstrained(uint32_t value, uint8_t upToExclusive) const
 {
-	auto &arr = mArrays[id];
+	return (uint8_t) BitOps::PopCountBelow(value, upToExclusive);
+}
 
-	size_t index = 0;
-	for (size_t i = 0; i < arr.count; ++i) {
-		auto block = mBitmapBlocks[arr.firstIdx + i];
-		
-		for (uint8_t bitIdx = 0; bitIdx < 32; ++bitIdx) {
-			// Index is present in the map
-			if (block & (1 << bitIdx)) {
-				if (!callback(index)) {
-					return false;
-				}
-			}
-			index++;
-		}
+size_t ArrayIndexBitmaps::GetIndexCount(const ArrayIndices &arr) const
+{
+	if (!arr.count) {
+		return 0;
 	}
-
-	return true;
+	auto last = arr.firstIdx + arr.count - 1;
+	return mBlockRanks[last] + BitOps::PopCount(mBitmapBlocks[last]);
 }
 
-uint8_t ArrayIndexBitmaps::PopCnt(uint32_t value) const
+void ArrayIndexBitmaps::AdjustRanks(const ArrayIndices &arr, size_t blockIdx, int delta)
 {
-	uint16_t lower = value & UINT16_MAX;
-	uint16_t upper = (value >> 16) & UINT16_MAX;
-	return mBitCountLut[lower] + mBitCountLut[upper];
+	for (size_t i = blockIdx + 1; i < arr.count; ++i) {
+		mBlockRanks[arr.firstIdx + i] += delta;
+	}
 }
 
-uint8_t ArrayIndexBitmaps::PopCntConstrained(uint32_t value, uint8_t upToExclusive) const
+void ArrayIndexBitmaps::RebuildRanks(ArrayIdxMapId id)
 {
-	// Use precomputed masks to unset the bits we don't want to count
-	return PopCnt(value & mPartialBitmasks[upToExclusive]);
+	auto &arr = mArrays[id];
+
+	uint32_t rank = 0;
+	for (size_t i = 0; i < arr.count; ++i) {
+		mBlockRanks[arr.firstIdx + i] = rank;
+		rank += BitOps::PopCount(mBitmapBlocks[arr.firstIdx + i]);
+	}
 }
 
 void ArrayIndexBitmaps::Shrink(ArrayIdxMapId id, size_t shrinkBy)
@@ -317,6 +290,9 @@ void ArrayIndexBitmaps::Shrink(ArrayIdxMapId id, size_t shrinkBy)
 	auto last = first + shrinkBy;
 	mBitmapBlocks.erase(first, last);
 
+	auto firstRank = mBlockRanks.begin() + arr.firstIdx + arr.count;
+	mBlockRanks.erase(firstRank, firstRank + shrinkBy);
+
 	// Now the "firstIdx" of all arrays after the one we modified have to be adjusted
 	for (size_t i = id + 1; i < mArrays.size(); ++i) {
 		mArrays[i].firstIdx -= shrinkBy;
@@ -326,10 +302,14 @@ void ArrayIndexBitmaps::Shrink(ArrayIdxMapId id, size_t shrinkBy)
 void ArrayIndexBitmaps::Extend(ArrayIdxMapId id, size_t extendBy)
 {
 	auto& arr = mArrays[id];
+
+	// The new blocks are empty, so all indices of the map precede them
+	uint32_t rank = GetIndexCount(arr);
 	
 	// Iterator to the position before which the new elements will be inserted
 	auto insertBefore = mBitmapBlocks.begin() + arr.firstIdx + arr.count;
 	mBitmapBlocks.insert(insertBefore, extendBy, 0);
+	mBlockRanks.insert(mBlockRanks.begin() + arr.firstIdx + arr.count, extendBy, rank);
 
 	arr.count += extendBy;
 
@@ -2,6 +2,7 @@
 #pragma once
 
 #include <EASTL/vector.h>
+#include <infrastructure/bitops.h>
 
 class OutputStream;
 struct TioFile;
@@ -62,7 +63,8 @@ public:
 	// Calls a callback for all indices that are present in the index map.
 	// Stops iterating when false is returned. Returns false if any call to
 	// callback returned false, true otherwise.
-	bool ForEachIndex(ArrayIdxMapId id, std::function<bool(size_t)> callback) const;
+	template<typename Callback>
+	bool ForEachIndex(ArrayIdxMapId id, Callback callback) const;
 
 	// Count of set bits in given 32-bit integer up to and not including the given bit (0-31)
 	uint8_t PopCntConstrained(uint32_t value, uint8_t upToExclusive) const;
@@ -80,14 +82,19 @@ private:
 	// IDs of free entries in mArrays
 	eastl::vector<ArrayIdxMapId> mFreeIds;
 
-	// Bitmask lookup table that contains bitmasks that have the lower 0 - 31
-	// bits set. This is used in counting the bits up and until position i in
-	// a DWORD
-	std::array<uint32_t, 32> mPartialBitmasks;
+	// Parallel to mBitmapBlocks: the number of indices set in the blocks of the
+	// same index map that precede a block. Makes GetPackedIndex O(1).
+	eastl::vector<uint32_t> mBlockRanks;
+
+	// Number of indices set in an index map
+	size_t GetIndexCount(const ArrayIndices &arr) const;
+
+	// Adds delta to the ranks of all blocks behind the given block
+	void AdjustRanks(const ArrayIndices &arr, size_t blockIdx, int delta);
+
+	// Recomputes the ranks of an index map from its bitmap blocks
+	void RebuildRanks(ArrayIdxMapId id);
 
-	// A bit count lookup table for all values of a 16-bit integer
-	std::array<uint8_t, UINT16_MAX + 1> mBitCountLut;
-	
 	// Shrinks an index map by the specified number of bitmap blocks
 	void Shrink(ArrayIdxMapId id, size_t shrinkBy);
 
@@ -95,4 +102,25 @@ private:
 	void Extend(ArrayIdxMapId id, size_t extendBy);
 };
 
+template<typename Callback>
+inline bool ArrayIndexBitmaps::ForEachIndex(ArrayIdxMapId id, Callback callback) const
+{
+	auto &arr = mArrays[id];
+
+	for (size_t i = 0; i < arr.count; ++i) {
+		auto block = mBitmapBlocks[arr.firstIdx + i];
+
+		// Visit the set bits from lowest to highest, clearing each one after it's visited
+		while (block) {
+			auto bitIdx = BitOps::CountTrailingZeros(block);
+			if (!callback(i * 32 + bitIdx)) {
+				return false;
+			}
+			block &= block - 1;
+		}
+	}
+
+	return true;
+}
+
 extern ArrayIndexBitmaps arrayIdxBitmaps;
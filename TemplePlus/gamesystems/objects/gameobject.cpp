@@ -5,9 +5,11 @@
 #include "objsystem.h"
 #include "objregistry.h"
 #include "arrayidxbitmaps.h"
+#include "objmemory.h"
 #include "tio/tio.h"
 #include "util/streams.h"
 #include <config/config.h>
+#include <infrastructure/bitops.h>
 
 GameObjectBody::~GameObjectBody()
 {
@@ -25,11 +27,11 @@ GameObjectBody::~GameObjectBody()
 
 	// This is the "old" way of doing it
 	if (IsProto()) {
-		free(difBitmap);
+		delete[] difBitmap;
 	} else {
-		free(propCollBitmap);
+		delete[] propCollBitmap;
 	}
-	delete[] propCollection;
+	FreePropCollection(propCollection, propCollectionItems);
 }
 
 bool GameObjectBody::IsProto() const
@@ -556,7 +558,7 @@ void GameObjectBody::SetInt64(obj_f field, int64_t value)
 	if (*storageLoc) {
 		**storageLoc = value;
 	} else {
-		*storageLoc = new int64_t(value);
+		*storageLoc = objMemory.New<int64_t>(value);
 	}
 	if (field == obj_f_location) {
 		objSystem->FindNodeMove(objSystem->GetHandleById(id));
@@ -597,7 +599,7 @@ void GameObjectBody::SetObjectId(obj_f field, const ObjectId &value)
 	if (*storageLoc) {
 		**storageLoc = value;
 	} else {
-		*storageLoc = new ObjectId(value);
+		*storageLoc = objMemory.New<ObjectId>(value);
 	}
 }
 
@@ -633,15 +635,12 @@ void GameObjectBody::ResetField(obj_f field)
 
 	auto &fieldDef = objectFields.GetFieldDef(field);
 	if (HasDataForField(fieldDef)) {
-		auto idx = GetPropCollIdx(fieldDef);
-		// Copy the property behind the one we remove
+		// Copies the properties behind the one we remove
+		BitmapRanks::Remove(propCollBitmap, GetPropCollRanks(), objectFields.GetBitmapBlockCount(type),
+			fieldDef.bitmapBlockIdx, fieldDef.bitmapBitIdx, propCollection, propCollectionItems);
 		--propCollectionItems;
-		for (size_t i = idx; i < propCollectionItems; ++i) {
-			propCollection[i] = propCollection[i + 1];
-		}
-		propCollection = (void**) realloc(propCollection, sizeof(void*) * propCollectionItems);
+		propCollection = ResizePropCollection(propCollection, propCollectionItems + 1, propCollectionItems);
 
-		propCollBitmap[fieldDef.bitmapBlockIdx] &= ~fieldDef.bitmapMask;
 		difBitmap[fieldDef.bitmapBlockIdx] &= ~fieldDef.bitmapMask;
 	}	
 }
@@ -859,12 +858,11 @@ std::unique_ptr<GameObjectBody> GameObjectBody::Clone() const {
 
 	obj->propCollectionItems = propCollectionItems;
 	obj->hasDifs = 0;
-	obj->propCollection = new void*[obj->propCollectionItems];
+	obj->propCollection = AllocatePropCollection(obj->propCollectionItems);
 
-	auto bitmapLen = objectFields.GetBitmapBlockCount(obj->type);
-	obj->propCollBitmap = new uint32_t[bitmapLen * 2];
-	obj->difBitmap = &obj->propCollBitmap[bitmapLen];
-	memcpy(&obj->propCollBitmap[0], &propCollBitmap[0], bitmapLen * sizeof(uint32_t));
+	obj->AllocateBitmaps();
+	memcpy(&obj->propCollBitmap[0], &propCollBitmap[0], objectFields.GetBitmapBlockCount(obj->type) * sizeof(uint32_t));
+	obj->UpdatePropCollRanks();
 
 	memset(&obj->transientProps, 0, sizeof(obj->transientProps));
 
@@ -880,7 +878,7 @@ std::unique_ptr<GameObjectBody> GameObjectBody::Clone() const {
 			break;
 		case ObjectFieldType::Int64: 
 			if (*src) {
-				*storage = new int64_t(**GetStorageLocation<int64_t*>(field));
+				*storage = objMemory.New<int64_t>(**GetStorageLocation<int64_t*>(field));
 			}
 			break;
 		case ObjectFieldType::String: 
@@ -890,7 +888,7 @@ std::unique_ptr<GameObjectBody> GameObjectBody::Clone() const {
 			break;
 		case ObjectFieldType::Obj: 
 			if (*src) {
-				*storage = new ObjectId(**GetStorageLocation<ObjectId*>(field));
+				*storage = objMemory.New<ObjectId>(**GetStorageLocation<ObjectId*>(field));
 			}
 			break;
 		case ObjectFieldType::AbilityArray:
@@ -902,11 +900,7 @@ std::unique_ptr<GameObjectBody> GameObjectBody::Clone() const {
 		case ObjectFieldType::ObjArray:
 		case ObjectFieldType::SpellArray:
 			if (*src) {
-				auto arr = (ArrayHeader*) *src;
-				auto dest = (ArrayHeader*) malloc(sizeof(ArrayHeader) + arr->elSize * arr->count);
-				memcpy(dest, arr, sizeof(ArrayHeader) + arr->elSize * arr->count);
-				dest->idxBitmapId = arrayIdxBitmaps.Clone(dest->idxBitmapId);
-				*storage = dest;
+				*storage = ArrayHeader::Clone((ArrayHeader*) *src);
 			}
 			break;
 		default: 
@@ -1121,16 +1115,28 @@ size_t GameObjectBody::GetPropCollIdx(const ObjectFieldDef & field) const
 {
 	Expects(!IsProto());
 
-	size_t count = 0;
-	for (int i = 0; i < field.bitmapBlockIdx; ++i) {
-		count += arrayIdxBitmaps.PopCnt(propCollBitmap[i]);
-	}
-	count += arrayIdxBitmaps.PopCntConstrained(
-		propCollBitmap[field.bitmapBlockIdx],
-		field.bitmapBitIdx
-	);
+	return BitmapRanks::Rank(propCollBitmap, GetPropCollRanks(), field.bitmapBlockIdx, field.bitmapBitIdx);
+}
+
+uint32_t* GameObjectBody::GetPropCollRanks() const
+{
+	return &difBitmap[objectFields.GetBitmapBlockCount(type)];
+}
+
+void GameObjectBody::AllocateBitmaps()
+{
+	Expects(!IsProto());
+
+	// One array for both bitmaps and the ranks
+	auto bitmapLen = objectFields.GetBitmapBlockCount(type);
+	propCollBitmap = new uint32_t[bitmapLen * 3];
+	difBitmap = &propCollBitmap[bitmapLen];
+	memset(propCollBitmap, 0, bitmapLen * 3 * sizeof(uint32_t));
+}
 
-	return count;
+void GameObjectBody::UpdatePropCollRanks()
+{
+	BitmapRanks::Build(propCollBitmap, GetPropCollRanks(), objectFields.GetBitmapBlockCount(type));
 }
 
 void GameObjectBody::MarkChanged(obj_f field)
@@ -1167,6 +1173,21 @@ const GameObjectBody * GameObjectBody::GetProtoObj() const
 	return objSystem->mObjRegistry->Get(protoHandle);
 }
 
+void** GameObjectBody::AllocatePropCollection(size_t count)
+{
+	return reinterpret_cast<void**>(objMemory.Allocate(count * sizeof(void*)));
+}
+
+void** GameObjectBody::ResizePropCollection(void** propCollection, size_t oldCount, size_t newCount)
+{
+	return reinterpret_cast<void**>(objMemory.Reallocate(propCollection, oldCount * sizeof(void*), newCount * sizeof(void*)));
+}
+
+void GameObjectBody::FreePropCollection(void** propCollection, size_t count)
+{
+	objMemory.Free(propCollection, count * sizeof(void*));
+}
+
 void GameObjectBody::FreeStorage(ObjectFieldType type, void * storage)
 {
 	if (!storage) {
@@ -1175,10 +1196,10 @@ void GameObjectBody::FreeStorage(ObjectFieldType type, void * storage)
 
 	switch (type) {
 	case ObjectFieldType::Int64:
-		delete reinterpret_cast<int64_t*>(storage);
+		objMemory.Delete(reinterpret_cast<int64_t*>(storage));
 		break;
 	case ObjectFieldType::Obj:
-		delete reinterpret_cast<objHndl*>(storage);
+		objMemory.Delete(reinterpret_cast<ObjectId*>(storage));
 		break;
 	case ObjectFieldType::String:
 		delete reinterpret_cast<char*>(storage);
@@ -1192,7 +1213,7 @@ void GameObjectBody::FreeStorage(ObjectFieldType type, void * storage)
 	case ObjectFieldType::ObjArray:
 	case ObjectFieldType::SpellArray:
 		arrayIdxBitmaps.Free(((ArrayHeader*)storage)->idxBitmapId);
-		free(storage);
+		ArrayHeader::Free((ArrayHeader*)storage);
 		break;
 	default:
 		break; // No allocated memory
@@ -1247,18 +1268,11 @@ T* GameObjectBody::GetMutableStorageLocation(obj_f field)
 		storageLocation = &propCollection[propCollIdx];
 	} else {
 		// Allocate the storage location
-		propCollBitmap[fieldDef.bitmapBlockIdx] |= fieldDef.bitmapMask;
-
-		// TODO: This should just be a vector or similar so we can use the STL's insert function
-		propCollection = (void**)realloc(propCollection, (propCollectionItems + 1) * sizeof(void*));
-		size_t desiredIdx = GetPropCollIdx(fieldDef);
+		propCollection = ResizePropCollection(propCollection, propCollectionItems, propCollectionItems + 1);
+		size_t desiredIdx = BitmapRanks::Insert(propCollBitmap, GetPropCollRanks(), objectFields.GetBitmapBlockCount(type),
+			fieldDef.bitmapBlockIdx, fieldDef.bitmapBitIdx, propCollection, propCollectionItems);
 		propCollectionItems++;
-				
-		for (size_t i = propCollectionItems - 1; i > desiredIdx; --i) {
-			propCollection[i] = propCollection[i - 1];
-		}
 
-		propCollection[desiredIdx] = nullptr;
 		storageLocation = &propCollection[desiredIdx];
 
 		// TODO For certain fields we need to copy the value from the prototype here
@@ -1266,11 +1280,7 @@ T* GameObjectBody::GetMutableStorageLocation(obj_f field)
 			auto proto = GetProtoObj();
 			auto arr = reinterpret_cast<ArrayHeader*>(proto->propCollection[fieldDef.protoPropIdx]);
 			if (arr) {
-				auto arrSize = sizeof(ArrayHeader) + arr->count * arr->elSize;
-				auto arrCopy = (ArrayHeader*) malloc(arrSize);
-				memcpy(arrCopy, arr, arrSize);
-				arrCopy->idxBitmapId = arrayIdxBitmaps.Clone(arr->idxBitmapId);
-				propCollection[desiredIdx] = arrCopy;
+				propCollection[desiredIdx] = ArrayHeader::Clone(arr);
 			}
 		}
 	}
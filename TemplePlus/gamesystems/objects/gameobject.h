@@ -184,6 +184,20 @@ struct GameObjectBody {
 
 	std::unique_ptr<GameObjectBody> Clone() const;
 
+	/**
+	 * Allocates propCollBitmap and difBitmap of an object instance (not a prototype)
+	 * with all bits cleared. Call UpdatePropCollRanks after writing to propCollBitmap
+	 * directly, e.g. when loading it.
+	 */
+	void AllocateBitmaps();
+	void UpdatePropCollRanks();
+
+	// The property collection is allocated from the object memory pool and has to
+	// be resized and freed with the item count it currently has
+	static void** AllocatePropCollection(size_t count);
+	static void** ResizePropCollection(void** propCollection, size_t oldCount, size_t newCount);
+	static void FreePropCollection(void** propCollection, size_t count);
+
 #pragma region Object Field Getters and Setters
 	ObjectFlag GetFlags() const {
 		return (ObjectFlag) GetInt32(obj_f_flags);
@@ -281,6 +295,10 @@ private:
 	// Determines the packed index in the prop coll for the given field
 	size_t GetPropCollIdx(const ObjectFieldDef &field) const;
 
+	// The number of properties stored for the bitmap blocks preceding each block,
+	// kept behind difBitmap. Makes GetPropCollIdx O(1).
+	uint32_t* GetPropCollRanks() const;
+
 	// Gets a readable storage location, possibly in the object_s prototype
 	// if this object doesnt have the requested field
 	template<typename T>
@@ -3,6 +3,7 @@
 
 #include "obj_structs.h"
 #include "arrayidxbitmaps.h"
+#include "objmemory.h"
 
 #pragma pack(push, 1)
 struct ArrayHeader {
@@ -18,6 +19,52 @@ struct ArrayHeader {
 	void* GetData(size_t packedIdx) {
 		return GetData() + packedIdx * elSize;
 	}
+
+	// Number of elements that fit into the storage block without reallocating.
+	// The block is sized from the count, so capacity grows geometrically with it.
+	size_t GetCapacity() const {
+		if (!elSize) {
+			return count;
+		}
+		return (ObjMemoryPool::GetBlockSize(GetStorageSize(elSize, count)) - sizeof(ArrayHeader)) / elSize;
+	}
+
+	static size_t GetStorageSize(size_t elSize, size_t count) {
+		return sizeof(ArrayHeader) + elSize * count;
+	}
+
+	// Allocates an array with room for count elements. The index bitmap is left to the caller.
+	static ArrayHeader* Allocate(uint32_t elSize, uint32_t count) {
+		auto result = reinterpret_cast<ArrayHeader*>(objMemory.Allocate(GetStorageSize(elSize, count)));
+		result->elSize = elSize;
+		result->count = count;
+		return result;
+	}
+
+	// Changes the element count, moving the array if it outgrows (or shrinks below) its block
+	static ArrayHeader* Resize(ArrayHeader* array, uint32_t newCount) {
+		auto result = reinterpret_cast<ArrayHeader*>(objMemory.Reallocate(array,
+			GetStorageSize(array->elSize, array->count),
+			GetStorageSize(array->elSize, newCount)));
+		result->count = newCount;
+		return result;
+	}
+
+	// Copies the array including its index bitmap
+	static ArrayHeader* Clone(const ArrayHeader* array) {
+		auto size = GetStorageSize(array->elSize, array->count);
+		auto result = reinterpret_cast<ArrayHeader*>(objMemory.Allocate(size));
+		memcpy(result, array, size);
+		result->idxBitmapId = arrayIdxBitmaps.Clone(array->idxBitmapId);
+		return result;
+	}
+
+	// Frees the array storage, but not the index bitmap
+	static void Free(ArrayHeader* array) {
+		if (array) {
+			objMemory.Free(array, GetStorageSize(array->elSize, array->count));
+		}
+	}
 };
 #pragma pack(pop)
 
@@ -74,9 +121,7 @@ public:
 
 		// Initialize the array storage if necessary
 		if (!*mStorageLocation) {
-			*mStorageLocation = (ArrayHeader*)malloc(sizeof(ArrayHeader));
-			(*mStorageLocation)->count = 0;
-			(*mStorageLocation)->elSize = sizeof(T);
+			*mStorageLocation = ArrayHeader::Allocate(sizeof(T), 0);
 			(*mStorageLocation)->idxBitmapId = arrayIdxBitmaps.Allocate();
 		}
 
@@ -87,18 +132,13 @@ public:
 			arrayIdxBitmaps.AddIndex((*mStorageLocation)->idxBitmapId, index);
 
 			// Resize the array storage
-			*mStorageLocation = (ArrayHeader*)realloc(*mStorageLocation, 
-				sizeof(ArrayHeader) 
-				+ (*mStorageLocation)->count * sizeof(T)
-				+ sizeof(T));
+			auto count = (*mStorageLocation)->count;
+			*mStorageLocation = ArrayHeader::Resize(*mStorageLocation, count + 1);
 
 			// Move back everything behind the packed Idx
-			for (size_t i = (*mStorageLocation)->count; i > packedIdx; --i) {
-				*reinterpret_cast<T*>((*mStorageLocation)->GetData(i)) 
-					= *reinterpret_cast<T*>((*mStorageLocation)->GetData(i - 1));
-			}
-
-			(*mStorageLocation)->count++;
+			memmove((*mStorageLocation)->GetData(packedIdx + 1),
+				(*mStorageLocation)->GetData(packedIdx),
+				(count - packedIdx) * sizeof(T));
 		}
 		
 		*reinterpret_cast<T*>((*mStorageLocation)->GetData(packedIdx)) = value;
@@ -127,15 +167,12 @@ public:
 		size_t storageIndex = GetPackedIndex(index);
 		arrayIdxBitmaps.RemoveIndex((*mStorageLocation)->idxBitmapId, index);
 
-		T* arr = reinterpret_cast<T*>((*mStorageLocation)->GetData());
 		// Copy all the data from the back one place forward
-		for (size_t i = storageIndex; i < (*mStorageLocation)->count - 1; ++i) {
-			arr[i] = arr[i + 1];
-		}		
-		(*mStorageLocation)->count--;
-		*mStorageLocation = reinterpret_cast<ArrayHeader*>(
-			realloc(*mStorageLocation, sizeof(ArrayHeader) + sizeof(T) * (*mStorageLocation)->count)
-		);
+		auto count = (*mStorageLocation)->count;
+		memmove((*mStorageLocation)->GetData(storageIndex),
+			(*mStorageLocation)->GetData(storageIndex + 1),
+			(count - storageIndex - 1) * sizeof(T));
+		*mStorageLocation = ArrayHeader::Resize(*mStorageLocation, count - 1);
 	}
 
 	void Clear() {
@@ -148,7 +185,7 @@ public:
 			return; // Already reset
 		}
 		arrayIdxBitmaps.Free((*mStorageLocation)->idxBitmapId);
-		free(*mStorageLocation);
+		ArrayHeader::Free(*mStorageLocation);
 		*mStorageLocation = nullptr;
 	}
 
@@ -156,7 +193,8 @@ public:
 	 * Calls the given callback for every stored index in the array.
 	 * Also passes a mutable data pointer.
 	 */
-	void ForEachIndex(std::function<void(size_t)> callback) {
+	template<typename Callback>
+	void ForEachIndex(Callback callback) {
 		if (!mStorageLocation) {
 			// The type of the object didn't support this field
 			return;
@@ -166,7 +204,7 @@ public:
 			return;
 		}
 
-		arrayIdxBitmaps.ForEachIndex((*mStorageLocation)->idxBitmapId, [=](size_t realIdx) {
+		arrayIdxBitmaps.ForEachIndex((*mStorageLocation)->idxBitmapId, [&](size_t realIdx) {
 			callback(realIdx);
 			return true;
 		});
@@ -605,9 +605,15 @@ ObjectFields::ObjectFields() {
 		mBitmapBlocksPerType[type] = highestIdx + 1;
 	}
 
+	for (uint32_t i = 0; i < ObjectTypeCount; ++i) {
+		for (size_t field = 0; field < mFieldDefs.size(); ++field) {
+			mSupportedFields[i][field] = TypeSupportsField((ObjectType)i, (obj_f)field);
+		}
+	}
+
 }
 
-bool ObjectFields::DoesTypeSupportField(ObjectType type, obj_f field)
+bool ObjectFields::TypeSupportsField(ObjectType type, obj_f field) const
 {
 	auto fieldType = mFieldDefs[field].type;
 
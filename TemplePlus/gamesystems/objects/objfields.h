@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <array>
+#include <bitset>
 #include <cstdint>
 #include <functional>
 
@@ -66,7 +68,9 @@ public:
 		return mFieldDefs;
 	}
 
-	bool DoesTypeSupportField(ObjectType type, obj_f field);
+	bool DoesTypeSupportField(ObjectType type, obj_f field) const {
+		return mSupportedFields[type][field];
+	}
 
 	const char *GetFieldName(obj_f field) const;
 
@@ -106,6 +110,11 @@ private:
 	// The number of possible property storage locations per type
 	std::array<size_t, ObjectTypeCount> mPropCollSizePerType;
 
+	// Whether a type supports a field, since this is checked on every field access
+	std::array<std::bitset<430>, ObjectTypeCount> mSupportedFields;
+
+	bool TypeSupportsField(ObjectType type, obj_f field) const;
+
 	const char *GetTypeName(ObjectFieldType type);
 
 	static size_t GetPropCollSize(obj_f field, ObjectFieldType type);
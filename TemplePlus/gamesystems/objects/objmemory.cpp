@@ -0,0 +1,155 @@
+#include "stdafx.h"
+#include "objmemory.h"
+
+ObjMemoryPool objMemory;
+
+ObjMemoryPool::~ObjMemoryPool()
+{
+	while (mChunks) {
+		auto next = mChunks->next;
+		_aligned_free(mChunks);
+		mChunks = next;
+	}
+}
+
+void* ObjMemoryPool::Allocate(size_t size)
+{
+	if (size > MaxClassSize) {
+		auto result = malloc(GetBlockSize(size));
+		if (!result) {
+			throw std::bad_alloc();
+		}
+		return result;
+	}
+
+	auto sizeClass = GetSizeClass(size);
+
+	// Prefer recycling a previously freed block
+	auto block = mFreeLists[sizeClass];
+	if (block) {
+		mFreeLists[sizeClass] = block->next;
+		GetChunk(block)->liveBlocks++;
+		return block;
+	}
+
+	auto blockSize = MinClassSize << sizeClass;
+	auto chunk = mBumpChunks[sizeClass];
+	if (!chunk || chunk->bumpOffset + blockSize > ChunkSize) {
+		chunk = reinterpret_cast<ChunkHeader*>(_aligned_malloc(ChunkSize, ChunkSize));
+		if (!chunk) {
+			throw std::bad_alloc();
+		}
+		chunk->next = mChunks;
+		chunk->sizeClass = sizeClass;
+		chunk->liveBlocks = 0;
+		chunk->bumpOffset = ChunkHeaderSize;
+		mChunks = chunk;
+		mChunkCount++;
+		mBumpChunks[sizeClass] = chunk;
+	}
+
+	auto result = reinterpret_cast<uint8_t*>(chunk) + chunk->bumpOffset;
+	chunk->bumpOffset += blockSize;
+	chunk->liveBlocks++;
+	return result;
+}
+
+void ObjMemoryPool::Free(void* ptr, size_t size)
+{
+	if (!ptr) {
+		return;
+	}
+
+	if (size > MaxClassSize) {
+		free(ptr);
+		return;
+	}
+
+	auto sizeClass = GetSizeClass(size);
+	auto chunk = GetChunk(ptr);
+	Expects(chunk->sizeClass == sizeClass);
+	chunk->liveBlocks--;
+
+	auto block = reinterpret_cast<FreeBlock*>(ptr);
+	block->next = mFreeLists[sizeClass];
+	mFreeLists[sizeClass] = block;
+}
+
+void* ObjMemoryPool::Reallocate(void* ptr, size_t oldSize, size_t newSize)
+{
+	if (!ptr) {
+		return Allocate(newSize);
+	}
+
+	if (GetBlockSize(oldSize) == GetBlockSize(newSize)) {
+		return ptr;
+	}
+
+	if (oldSize > MaxClassSize && newSize > MaxClassSize) {
+		auto result = realloc(ptr, GetBlockSize(newSize));
+		if (!result) {
+			throw std::bad_alloc();
+		}
+		return result;
+	}
+
+	auto result = Allocate(newSize);
+	memcpy(result, ptr, std::min(oldSize, newSize));
+	Free(ptr, oldSize);
+	return result;
+}
+
+size_t ObjMemoryPool::GetBlockSize(size_t size)
+{
+	size_t blockSize = MinClassSize;
+	while (blockSize < size) {
+		blockSize <<= 1;
+	}
+	return blockSize;
+}
+
+void ObjMemoryPool::Trim()
+{
+	// Unlink the free blocks that belong to empty chunks first
+	for (auto &freeList : mFreeLists) {
+		FreeBlock** link = &freeList;
+		while (*link) {
+			if (GetChunk(*link)->liveBlocks == 0) {
+				*link = (*link)->next;
+			} else {
+				link = &(*link)->next;
+			}
+		}
+	}
+
+	ChunkHeader** link = &mChunks;
+	while (*link) {
+		auto chunk = *link;
+		if (chunk->liveBlocks == 0) {
+			if (mBumpChunks[chunk->sizeClass] == chunk) {
+				mBumpChunks[chunk->sizeClass] = nullptr;
+			}
+			*link = chunk->next;
+			_aligned_free(chunk);
+			mChunkCount--;
+		} else {
+			link = &chunk->next;
+		}
+	}
+}
+
+size_t ObjMemoryPool::GetSizeClass(size_t size)
+{
+	size_t sizeClass = 0;
+	while ((MinClassSize << sizeClass) < size) {
+		++sizeClass;
+	}
+	Expects(sizeClass < ClassCount);
+	return sizeClass;
+}
+
+ObjMemoryPool::ChunkHeader* ObjMemoryPool::GetChunk(void* ptr)
+{
+	// Chunks are aligned to their size
+	return reinterpret_cast<ChunkHeader*>(reinterpret_cast<uintptr_t>(ptr) & ~(ChunkSize - 1));
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <array>
+#include <new>
+
+/**
+ * Storage for the variable sized data hanging off of game objects: the
+ * property collection, boxed Int64/Obj field values and the ArrayHeader
+ * based sparse arrays.
+ *
+ * Requests are rounded up to power-of-two size classes. Small classes are
+ * bump-allocated from 64KB chunks and recycled through per-class free lists,
+ * which keeps the thousands of tiny allocations made while loading a map out
+ * of the CRT heap. Requests above MaxClassSize go to the CRT heap, but are
+ * still rounded up so that growing arrays reallocate geometrically.
+ *
+ * No header is stored with a block, so callers must pass the same size to
+ * Free/Reallocate that was used to allocate the block.
+ */
+class ObjMemoryPool {
+public:
+	static constexpr size_t MinClassSize = 16;
+	static constexpr size_t MaxClassSize = 2048;
+	static constexpr size_t ChunkSize = 64 * 1024;
+
+	ObjMemoryPool() = default;
+	~ObjMemoryPool();
+
+	ObjMemoryPool(const ObjMemoryPool&) = delete;
+	ObjMemoryPool& operator=(const ObjMemoryPool&) = delete;
+
+	void* Allocate(size_t size);
+
+	void Free(void* ptr, size_t size);
+
+	// Resizes a block, keeping min(oldSize, newSize) bytes of content.
+	// Returns ptr unchanged if both sizes map to the same block size.
+	void* Reallocate(void* ptr, size_t oldSize, size_t newSize);
+
+	template<typename T>
+	T* New(const T& value) {
+		return new (Allocate(sizeof(T))) T(value);
+	}
+
+	template<typename T>
+	void Delete(T* ptr) {
+		if (ptr) {
+			ptr->~T();
+			Free(ptr, sizeof(T));
+		}
+	}
+
+	// The actual number of bytes reserved for a request of the given size
+	static size_t GetBlockSize(size_t size);
+
+	// Returns chunks without any live blocks to the CRT heap.
+	// Called on map close, once the map's objects have been freed.
+	void Trim();
+
+	size_t GetChunkCount() const {
+		return mChunkCount;
+	}
+
+private:
+	static constexpr size_t ClassCount = 8; // 16 to 2048 bytes
+
+	struct FreeBlock {
+		FreeBlock* next;
+	};
+
+	// Stored at the start of each chunk, blocks follow behind it
+	struct ChunkHeader {
+		ChunkHeader* next;
+		uint32_t sizeClass;
+		uint32_t liveBlocks;
+		uint32_t bumpOffset;
+	};
+	static_assert(sizeof(ChunkHeader) <= 32, "Chunk header has to fit in front of the first block");
+	static constexpr size_t ChunkHeaderSize = 32;
+
+	static size_t GetSizeClass(size_t size);
+	static ChunkHeader* GetChunk(void* ptr);
+
+	std::array<FreeBlock*, ClassCount> mFreeLists{};
+	// Chunk that fresh blocks are bump-allocated from for each class
+	std::array<ChunkHeader*, ClassCount> mBumpChunks{};
+	// All chunks, linked through ChunkHeader::next
+	ChunkHeader* mChunks = nullptr;
+	size_t mChunkCount = 0;
+};
+
+extern ObjMemoryPool objMemory;
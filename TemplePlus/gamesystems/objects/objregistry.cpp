@@ -33,7 +33,98 @@ size_t eastl::hash<ObjectId>::operator()(ObjectId const& id) const {
 	}
 }
 
-ObjRegistry::ObjRegistry() : mObjects(8192) {
+ObjectIdIndex::ObjectIdIndex() : mEntries(1024) {
+}
+
+objHndl ObjectIdIndex::Find(const ObjectId& id) const {
+	auto &entry = mEntries[FindSlot(id)];
+	return entry.used ? entry.handle : objHndl::null;
+}
+
+void ObjectIdIndex::Set(const ObjectId& id, objHndl handle) {
+	// Keep the load factor below 3/4
+	if ((mSize + 1) * 4 > mEntries.size() * 3) {
+		Grow();
+	}
+
+	auto &entry = mEntries[FindSlot(id)];
+	if (!entry.used) {
+		entry.used = true;
+		entry.id = id;
+		mSize++;
+	}
+	entry.handle = handle;
+}
+
+void ObjectIdIndex::Erase(const ObjectId& id) {
+	auto mask = mEntries.size() - 1;
+	auto slot = FindSlot(id);
+	if (!mEntries[slot].used) {
+		return;
+	}
+
+	// Shift back any following entries that would otherwise become unreachable
+	auto next = slot;
+	while (true) {
+		next = (next + 1) & mask;
+		auto &nextEntry = mEntries[next];
+		if (!nextEntry.used) {
+			break;
+		}
+		auto home = mHasher(nextEntry.id) & mask;
+		// Can the entry at next be moved to slot? Only if its home is not cyclically within (slot, next]
+		auto distToNext = (next - home) & mask;
+		auto distToSlot = (slot - home) & mask;
+		if (distToSlot < distToNext) {
+			mEntries[slot] = nextEntry;
+			slot = next;
+		}
+	}
+	mEntries[slot] = Entry();
+	mSize--;
+}
+
+void ObjectIdIndex::Clear() {
+	for (auto &entry : mEntries) {
+		entry = Entry();
+	}
+	mSize = 0;
+}
+
+void ObjectIdIndex::Retain(std::function<bool(const ObjectId&)> predicate) {
+	std::vector<Entry> oldEntries(mEntries.size());
+	oldEntries.swap(mEntries);
+	mSize = 0;
+	for (auto &entry : oldEntries) {
+		if (entry.used && predicate(entry.id)) {
+			Set(entry.id, entry.handle);
+		}
+	}
+}
+
+size_t ObjectIdIndex::FindSlot(const ObjectId& id) const {
+	auto mask = mEntries.size() - 1;
+	auto slot = mHasher(id) & mask;
+	while (mEntries[slot].used && !(mEntries[slot].id == id)) {
+		slot = (slot + 1) & mask;
+	}
+	return slot;
+}
+
+void ObjectIdIndex::Grow() {
+	std::vector<Entry> oldEntries(mEntries.size() * 2);
+	oldEntries.swap(mEntries);
+	mSize = 0;
+	for (auto &entry : oldEntries) {
+		if (entry.used) {
+			Set(entry.id, entry.handle);
+		}
+	}
+}
+
+ObjRegistry::ObjRegistry() {
+	mSlots.reserve(8192);
+	mSlotGenerations.reserve(8192);
 }
 
 ObjectId ObjRegistry::GetIdByHandle(objHndl handle) {
@@ -51,87 +142,76 @@ ObjectId ObjRegistry::GetIdByHandle(objHndl handle) {
 }
 
 objHndl ObjRegistry::GetHandleById(ObjectId id) {
-
-	auto it = mObjectIndex.find(id);
-
-	if (it == mObjectIndex.end()) {
-		return objHndl::null;
-	}
-
-	return it->second;
-
+	return mObjectIndex.Find(id);
 }
 
 void ObjRegistry::AddToIndex(objHndl handle, ObjectId objectId) {
-	mObjectIndex[objectId] = handle;
+	mObjectIndex.Set(objectId, handle);
 }
 
 void ObjRegistry::RemoveDynamicObjectsFromIndex() {
-	auto idIt = mObjectIndex.begin();
-	while (idIt != mObjectIndex.end()) {
-		if (!idIt->first.IsPrototype()) {
-			idIt = mObjectIndex.erase(idIt);
-		}
-		else {
-			++idIt;
-		}
-	}
+	mObjectIndex.Retain([](const ObjectId &id) {
+		return id.IsPrototype();
+	});
 }
 
 void ObjRegistry::Clear() {
 
-	lastObj = 0;
-	lastObjBody = nullptr;
-
-	// We will concurrently modify the object handle list when we remove them,
-	// so we make a copy here first
-	std::vector<objHndl> toRemove;
-	toRemove.reserve(mObjects.size());
-	for (auto& it : mObjects) {
-		toRemove.push_back(it.first);
-	}
-
-	logger->info("Letting {} leftover objects leak.", toRemove.size());
+	size_t leftoverCount = mSlots.size() - mFreeSlots.size() - mRetiredSlots;
+	logger->info("Letting {} leftover objects leak.", leftoverCount);
 
-	mObjectIndex.clear();
+	mObjectIndex.Clear();
 
 }
 
 ObjRegistry::It ObjRegistry::Remove(objHndl handle) {
 
-	if (lastObj == handle) {
-		lastObj = 0;
-		lastObjBody = nullptr;
+	auto slotIdx = handle.GetHandleLower() & SlotMask;
+	if (!Contains(handle)) {
+		return end();
 	}
 
-	auto it = mObjects.find(handle);
-	if (it != mObjects.end()) {
-		// Destroy index entries as well
-		mObjectIndex.erase(it->second->id);
+	auto &slot = mSlots[slotIdx];
+	// Destroy index entries as well
+	mObjectIndex.Erase(slot.second->id);
 
-		return mObjects.erase(it);
+	slot.first = objHndl::null;
+	slot.second.reset();
+	if (mSlotGenerations[slotIdx] < GenerationMask) {
+		mFreeSlots.push_back(slotIdx);
+	} else {
+		mRetiredSlots++;
 	}
-	return it;
-}
 
-bool ObjRegistry::Contains(objHndl handle) {
-	return mObjects.find(handle) != end();
+	return It(&mSlots, slotIdx + 1);
 }
 
 objHndl ObjRegistry::Add(std::unique_ptr<GameObjectBody>&& ptr) {
 
 	auto obj = ptr.get();
-	
-	objHndl id{ mNextId++ | ((uint64_t)obj) << 32 };
 
-	auto it = mObjects.find(id);
-	assert(mObjects.find(id) == mObjects.end());
+	uint32_t slotIdx;
+	// Prefer new slots while few are free, unless the registry can't grow anymore
+	if (mFreeSlots.size() >= MinFreeSlots || (!mFreeSlots.empty() && mSlots.size() > SlotMask)) {
+		slotIdx = mFreeSlots.front();
+		mFreeSlots.pop_front();
+	} else {
+		slotIdx = mSlots.size();
+		if (slotIdx > SlotMask) {
+			throw TempleException("Object registry is full ({} objects)", slotIdx);
+		}
+		mSlots.emplace_back();
+		mSlotGenerations.push_back(0);
+	}
+
+	// Generations start at 1 so that the lower half of a handle is never 0.
+	// They don't wrap, since Remove retires slots at the last generation.
+	auto generation = ++mSlotGenerations[slotIdx];
 
-	mObjects.emplace(eastl::make_pair(id, std::move(ptr)));
+	objHndl id{ (slotIdx | (generation << SlotBits)) | ((uint64_t)obj) << 32 };
 
-	// Cache for later use
-	lastObj = id;
-	lastObjBody = obj;
+	mSlots[slotIdx].first = id;
+	mSlots[slotIdx].second = std::move(ptr);
 
 	return id;
 
@@ -143,28 +223,14 @@ GameObjectBody* ObjRegistry::Get(objHndl handle) {
 		return nullptr;
 	}
 
-	uint32_t id = (uint32_t)(handle.handle & 0xFFffFFff);
-	if (id > mNextId) { // indicates invalid handle!
-		logger->error("Invalid handle {:x} caught by id: {}, objregistry mNextId was {}", handle.handle, id, mNextId);
+	auto slotIdx = handle.GetHandleLower() & SlotMask;
+	if (slotIdx >= mSlots.size()) { // indicates invalid handle!
+		logger->error("Invalid handle {:x} caught by slot: {}, objregistry slot count was {}", handle.handle, slotIdx, mSlots.size());
 		return nullptr;
 	}
 
+	// Stale handles are deliberately not rejected here (use Contains for that),
+	// the body pointer is part of the handle
 	return (GameObjectBody*)(handle.handle >> 32);
 
-	// This would be the traditional way and it does detect when handles
-	// are no longer valid
-	if (lastObj == handle) {
-		return lastObjBody;
-	}
-
-	auto it = mObjects.find(handle);
-	if (it == mObjects.end()) {
-		return nullptr;
-	}
-
-	lastObj = it->first;
-	lastObjBody = it->second.get();
-	return it->second.get();
-
 }
-
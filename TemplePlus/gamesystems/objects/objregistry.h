@@ -3,6 +3,7 @@
 
 #include <unordered_map>
 #include <memory>
+#include <deque>
 
 #include "../../obj_structs.h"
 
@@ -20,12 +21,95 @@ namespace eastl {
 	struct hash<objHndl> : std::hash<objHndl> {};
 }
 
+/*
+	Flat open-addressing (linear probing) index from object id to handle.
+	Erasing shifts the following entries back, so the table never accumulates tombstones.
+*/
+class ObjectIdIndex {
+public:
+	ObjectIdIndex();
+
+	// Returns the null handle if the id is not indexed
+	objHndl Find(const ObjectId& id) const;
+	void Set(const ObjectId& id, objHndl handle);
+	void Erase(const ObjectId& id);
+	void Clear();
+
+	// Removes all entries whose id does not satisfy the predicate
+	void Retain(std::function<bool(const ObjectId&)> predicate);
+
+	size_t size() const {
+		return mSize;
+	}
+
+private:
+	struct Entry {
+		ObjectId id;
+		objHndl handle;
+		bool used = false;
+	};
+
+	size_t FindSlot(const ObjectId& id) const;
+	void Grow();
+
+	std::vector<Entry> mEntries; // size is always a power of two
+	size_t mSize = 0;
+	eastl::hash<ObjectId> mHasher;
+};
+
+/*
+	Owns all object bodies, addressed by handle.
+	Handles are (body pointer << 32) | (slot generation << SlotBits) | slot index,
+	so resolving a handle to its body is a shift, and validating it is a single
+	compare against the handle stored in its slot. Slots are reused, with the
+	generation bumped each time, so stale handles are not mistaken for new objects.
+	Free slots are reused first-in first-out, and only once MinFreeSlots of them have
+	accumulated, to spread the generations over many slots. A slot whose generation is
+	used up is retired instead of wrapping around.
+*/
 class ObjRegistry {
 public:
-	ObjRegistry();
+	static constexpr uint32_t SlotBits = 20;
+	static constexpr uint32_t SlotMask = (1 << SlotBits) - 1;
+	static constexpr uint32_t GenerationMask = (1 << (32 - SlotBits)) - 1;
+	static constexpr size_t MinFreeSlots = 1024;
+
+	using Slot = std::pair<objHndl, std::unique_ptr<GameObjectBody>>;
+
+	// Iterates over the occupied slots
+	class It {
+	public:
+		It(std::vector<Slot>* slots, size_t idx) : mSlots(slots), mIdx(idx) {
+			SkipFree();
+		}
+		Slot& operator*() const {
+			return (*mSlots)[mIdx];
+		}
+		Slot* operator->() const {
+			return &(*mSlots)[mIdx];
+		}
+		It& operator++() {
+			++mIdx;
+			SkipFree();
+			return *this;
+		}
+		bool operator==(const It& other) const {
+			return mIdx == other.mIdx;
+		}
+		bool operator!=(const It& other) const {
+			return mIdx != other.mIdx;
+		}
+	private:
+		void SkipFree() {
+			while (mIdx < mSlots->size() && !(*mSlots)[mIdx].first) {
+				++mIdx;
+			}
+		}
+		std::vector<Slot>* mSlots;
+		size_t mIdx;
+	};
 
-	using Container = eastl::hash_map<objHndl, std::unique_ptr<GameObjectBody>>;
-	using It = Container::iterator;
+	ObjRegistry();
 
 	ObjectId GetIdByHandle(objHndl handle);
 	objHndl GetHandleById(ObjectId id);
@@ -36,25 +120,27 @@ public:
 
 	void Clear();
 	It Remove(objHndl handle);
-	bool Contains(objHndl handle);
+	bool Contains(objHndl handle) {
+		auto slotIdx = handle.GetHandleLower() & SlotMask;
+		return slotIdx < mSlots.size() && mSlots[slotIdx].first == handle;
+	}
 
 	objHndl Add(std::unique_ptr<GameObjectBody>&& ptr);
 
 	GameObjectBody* Get(objHndl handle);
 
 	It begin() {
-		return mObjects.begin();
+		return It(&mSlots, 0);
 	}
 
 	It end() {
-		return mObjects.end();
+		return It(&mSlots, mSlots.size());
 	}
 
 private:
-	Container mObjects;
-	eastl::hash_map<ObjectId, objHndl> mObjectIndex;
-	uint32_t mNextId = 1;
-
-	objHndl lastObj = objHndl::null;
-	GameObjectBody* lastObjBody = nullptr;
+	std::vector<Slot> mSlots;
+	std::vector<uint32_t> mSlotGenerations;
+	std::deque<uint32_t> mFreeSlots;
+	size_t mRetiredSlots = 0;
+	ObjectIdIndex mObjectIndex;
 };
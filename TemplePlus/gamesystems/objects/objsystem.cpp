@@ -12,6 +12,7 @@
 #include "objfields.h"
 #include "objfind.h"
 #include "arrayidxbitmaps.h"
+#include "objmemory.h"
 #include <gamesystems/objects/objevent.h>
 #include <config/config.h>
 
@@ -265,14 +266,7 @@ objHndl ObjSystem::CreateObject(objHndl protoHandle, locXY location)
 	obj->propCollectionItems = 0;
 	obj->propCollection = nullptr;
 	
-	// We allocate one array for both bitmaps
-	auto bitmapLen = objectFields.GetBitmapBlockCount(obj->type);
-	obj->propCollBitmap = new uint32_t[bitmapLen * 2];
-	obj->difBitmap = &obj->propCollBitmap[bitmapLen];
-	for (size_t i = 0; i < bitmapLen; ++i) {
-		obj->propCollBitmap[i] = 0;
-		obj->difBitmap[i] = 0;
-	}
+	obj->AllocateBitmaps();
 	
 	memset(&obj->transientProps, 0, sizeof(obj->transientProps));
 
@@ -348,10 +342,8 @@ objHndl ObjSystem::LoadFromFile(TioFile* file) {
 	
 	// Initialize and load bitmaps
 	auto propLen = objectFields.GetBitmapBlockCount(obj->type);
-	obj->propCollBitmap = new uint32_t[propLen * 2];
+	obj->AllocateBitmaps();
 	obj->hasDifs = 0;
-	obj->difBitmap = &obj->propCollBitmap[propLen];
-	memset(&obj->difBitmap[0], 0, propLen * sizeof(uint32_t));
 		
 	uint16_t propCount;
 	if (tio_fread(&propCount, sizeof(propCount), 1, file) != 1) {
@@ -361,9 +353,10 @@ objHndl ObjSystem::LoadFromFile(TioFile* file) {
 	if (tio_fread(&obj->propCollBitmap[0], sizeof(uint32_t) * propLen, 1, file) != 1) {
 		throw TempleException("Couldn't read the property bitmap");
 	}
+	obj->UpdatePropCollRanks();
 
 	obj->propCollectionItems = propCount;
-	obj->propCollection = new void*[propCount];
+	obj->propCollection = GameObjectBody::AllocatePropCollection(propCount);
 	
 	obj->ForEachField([&](obj_f field, void** storageLocation)  {
 		*storageLocation = nullptr;
@@ -425,9 +418,7 @@ public:
 		memcpy(&header, ptr, sizeof(header));
 		ptr += sizeof(header);
 
-		auto arr = (ArrayHeader*)malloc(sizeof(ArrayHeader) + header.elSize * header.count);
-		arr->elSize = header.elSize;
-		arr->count = header.count;
+		auto arr = ArrayHeader::Allocate(header.elSize, header.count);
 
 		memcpy(arr->GetData(), ptr, header.elSize * header.count);
 		ptr += header.elSize * header.count;
@@ -469,19 +460,18 @@ objHndl ObjSystem::LoadFromBuffer(void* bufferPtr) {
 
 	// Initialize and load bitmaps
 	auto propLen = objectFields.GetBitmapBlockCount(obj->type);
-	obj->propCollBitmap = new uint32_t[propLen * 2];
+	obj->AllocateBitmaps();
 	obj->hasDifs = 0;
-	obj->difBitmap = &obj->propCollBitmap[propLen];
-	memset(&obj->difBitmap[0], 0, propLen * sizeof(uint32_t));
 
 	uint16_t propCount = buffer.Read<uint16_t>();
 
 	for (size_t i = 0; i < propLen; ++i) {
 		obj->propCollBitmap[i] = buffer.Read<uint32_t>();
 	}
+	obj->UpdatePropCollRanks();
 
 	obj->propCollectionItems = propCount;
-	obj->propCollection = new void*[propCount];
+	obj->propCollection = GameObjectBody::AllocatePropCollection(propCount);
 
 	obj->ForEachField([&](obj_f field, void** storageLocation) {
 		*storageLocation = nullptr;
@@ -552,7 +542,7 @@ objHndl ObjSystem::CreateProto(ObjectType type) {
 
 	auto count = objectFields.GetSupportedFieldCount(type);
 	obj->propCollectionItems = (uint16_t) count;
-	obj->propCollection = new void*[count];
+	obj->propCollection = GameObjectBody::AllocatePropCollection(count);
 	for (size_t i = 0; i < count; ++i) {
 		obj->propCollection[i] = nullptr;
 	}
@@ -765,7 +755,7 @@ void ObjSystem::ReadFieldValue(obj_f field, void** storageLoc, TioFile *file) {
 			return;
 		}
 		if (tio_fread(&int64Value, sizeof(int64Value), 1, file) == 1) {
-			*storageLoc = new decltype(int64Value)(int64Value);
+			*storageLoc = objMemory.New(int64Value);
 			return;
 		}
 		break;
@@ -781,7 +771,7 @@ void ObjSystem::ReadFieldValue(obj_f field, void** storageLoc, TioFile *file) {
 				throw TempleException("Read an invalid object id {} for field {}", 
 					objIdValue, objectFields.GetFieldName(field));
 			}
-			*storageLoc = new decltype(objIdValue)(objIdValue);
+			*storageLoc = objMemory.New(objIdValue);
 			return;
 		}
 		break;
@@ -822,12 +812,10 @@ void ObjSystem::ReadFieldValue(obj_f field, void** storageLoc, TioFile *file) {
 			break;
 		}
 
-		auto arr = (ArrayHeader*) malloc(sizeof(ArrayHeader) + header.elSize * header.count);
-		arr->elSize = header.elSize;
-		arr->count = header.count;
+		auto arr = ArrayHeader::Allocate(header.elSize, header.count);
 
 		if (tio_fread(arr->GetData(), header.elSize, header.count, file) != header.count) {
-			free(arr);
+			ArrayHeader::Free(arr);
 			break;
 		}
 
@@ -856,13 +844,13 @@ void ObjSystem::ReadFieldValue(obj_f field, void** storageLoc, ObjBuffer& buffer
 		break;
 	case ObjectFieldType::Int64:
 		if (buffer.Read<int8_t>() == 1) {
-			*storageLoc = new int64_t(buffer.Read<int64_t>());
+			*storageLoc = objMemory.New(buffer.Read<int64_t>());
 		}
 		break;
 	case ObjectFieldType::Obj:
 		if (buffer.Read<int8_t>() == 1) {
 			auto objId = buffer.Read<ObjectId>();
-			*storageLoc = new int64_t(buffer.Read<int64_t>());
+			*storageLoc = objMemory.New(objId);
 
 			if (!objId.IsPersistable()) {
 				throw TempleException("Read an invalid object id {} for field {}",
@@ -19,6 +19,8 @@
 #include "objfade.h"
 #include "ui/ui_dialog.h"
 #include <tig/tig_timer.h>
+#include <infrastructure/stopwatch.h>
+#include <infrastructure/sortedlistindex.h>
 
 /*
 Internal system specification used by the time event system
@@ -269,7 +271,7 @@ static BOOL ExpirePythonRealtime(const TimeEvent* event) {
 #pragma endregion
 
 #pragma region System Specs
-static const TimeEventTypeSpec sTimeEventTypeSpecs[] = {
+static constexpr TimeEventTypeSpec sTimeEventTypeSpecs[] = {
 	// Debug
 	TimeEventTypeSpec(
 	GameClockType::RealTime,
@@ -629,11 +631,128 @@ static const TimeEventTypeSpec sTimeEventTypeSpecs[] = {
 		),
 
 };
+static_assert(sizeof(sTimeEventTypeSpecs) / sizeof(sTimeEventTypeSpecs[0]) == (size_t)TimeEventType::TimeEventSystemCount,
+	"A spec is required for every time event type");
+
+static constexpr const char* sTimeEventTypeNames[] = {
+	"Debug", "Anim", "BkgAnim", "FidgetAnim", "Script", "PythonScript", "Poison", "NormalHealing",
+	"SubdualHealing", "Aging", "AI", "AIDelay", "Combat", "TBCombat", "AmbientLighting", "WorldMap",
+	"Sleeping", "Clock", "NPCWaitHere", "MainMenu", "Light", "Lock", "NPCRespawn", "DecayDeadBodies",
+	"ItemDecay", "CombatFocusWipe", "Fade", "GFadeControl", "Teleported", "SceneryRespawn", "RandomEncounters", "ObjFade",
+	"ActionQueue", "Search", "IntgameTurnbased", "PythonDialog", "EncumberedComplain", "PythonRealtime"
+};
+static_assert(sizeof(sTimeEventTypeNames) / sizeof(sTimeEventTypeNames[0]) == (size_t)TimeEventType::TimeEventSystemCount,
+	"A name is required for every time event type");
 #pragma endregion
 const TimeEventTypeSpec& GetTimeEventTypeSpec(TimeEventType type) {
 	return sTimeEventTypeSpecs[(size_t)type];
 }
 
+const char* GetTimeEventTypeName(TimeEventType type) {
+	return sTimeEventTypeNames[(size_t)type];
+}
+
+#pragma endregion
+
+#pragma region List Index
+/*
+	Ordered index over the time event lists at 0x10AA73FC.
+	The lists themselves remain the canonical storage: they are what gets saved and a number
+	of vanilla functions still walk them. For each clock, the index maps every distinct trigger
+	time to the last list node with that time, so finding the insertion point of a new event
+	is a tree lookup instead of a walk over the whole list.
+	Vanilla code that modifies the lists behind our back runs inside a TimeEventLegacyListScope;
+	during that the index is bypassed, and it is rebuilt lazily on the next insertion.
+	Debug builds check the index against the list before every use, which catches vanilla
+	unlinks that happen outside of a scope.
+*/
+class TimeEventListIndex {
+public:
+	// Inserts the entry before any entries with an equal or later time (same order as the vanilla insertion)
+	void Insert(GameClockType clock, TimeEventListEntry* entry);
+	// Must be called after the list head is unlinked
+	void OnHeadRemoved(GameClockType clock, const TimeEventListEntry* entry);
+
+	void BeginLegacyModification();
+	void EndLegacyModification();
+
+	static void InsertLinear(TimeEventListEntry** evtList, TimeEventListEntry* entry);
+
+private:
+	static uint64_t TimeKey(const TimeEventListEntry& entry) {
+		return ((uint64_t)(uint32_t)entry.evt.time.timeInDays << 32) | (uint32_t)entry.evt.time.timeInMs;
+	}
+	static TimeEventListEntry** ListHead(GameClockType clock) {
+		return &temple::GetRef<TimeEventListEntry*[]>(0x10AA73FC)[(int)clock];
+	}
+
+	using ListIndex = SortedListIndex<TimeEventListEntry, TimeKey, &TimeEventListEntry::nextEvent>;
+	ListIndex mIndex[(int)GameClockType::ClockTypeCount];
+	int mLegacyDepth = 0;
+};
+
+static TimeEventListIndex sListIndex;
+
+void TimeEventListIndex::Insert(GameClockType clock, TimeEventListEntry* entry)
+{
+	auto evtList = ListHead(clock);
+	if (mLegacyDepth > 0) {
+		InsertLinear(evtList, entry);
+		return;
+	}
+
+	auto &index = mIndex[(int)clock];
+	assert(index.IsConsistent(*evtList));
+	index.Insert(evtList, entry);
+}
+
+void TimeEventListIndex::OnHeadRemoved(GameClockType clock, const TimeEventListEntry* entry)
+{
+	if (mLegacyDepth > 0)
+		return;
+
+	auto &index = mIndex[(int)clock];
+	index.OnHeadRemoved(entry);
+	assert(index.IsConsistent(*ListHead(clock)));
+}
+
+void TimeEventListIndex::BeginLegacyModification()
+{
+	mLegacyDepth++;
+}
+
+void TimeEventListIndex::EndLegacyModification()
+{
+	mLegacyDepth--;
+	for (auto &index : mIndex) {
+		index.Invalidate();
+	}
+}
+
+void TimeEventListIndex::InsertLinear(TimeEventListEntry** evtList, TimeEventListEntry* entry)
+{
+	while (*evtList) {
+		auto node = *evtList;
+		if (node->evt.time.timeInDays > entry->evt.time.timeInDays
+			|| (node->evt.time.timeInDays >= entry->evt.time.timeInDays)
+			&& node->evt.time.timeInMs >= entry->evt.time.timeInMs) {
+			break;
+		}
+		evtList = &node->nextEvent;
+	}
+	entry->nextEvent = *evtList;
+	*evtList = entry;
+}
+
+TimeEventLegacyListScope::TimeEventLegacyListScope()
+{
+	sListIndex.BeginLegacyModification();
+}
+
+TimeEventLegacyListScope::~TimeEventLegacyListScope()
+{
+	sListIndex.EndLegacyModification();
+}
 #pragma endregion
 
 
@@ -648,6 +767,25 @@ public:
 
 		replaceFunction(0x100607E0, TimeEventListEntryAdd);
 
+		// timeevent_add_ex (also used by timeevent_add_special); routed through our scheduling so that the list index sees the insertion
+		replaceFunction<BOOL(__cdecl)(TimeEvent*, const GameTime*, const GameTime*, GameTime*, const char*, int)>(0x10060720, [](TimeEvent* evt, const GameTime* delay, const GameTime* baseTime, GameTime* triggerTimeOut, const char* sourceFile, int sourceLine)->BOOL {
+			return gameSystems->GetTimeEvent().Schedule(evt, delay, baseTime, triggerTimeOut, sourceFile, sourceLine) ? TRUE : FALSE;
+		});
+
+		// vanilla functions that unlink / free list nodes directly
+		static BOOL(__cdecl*orgRemoveAll)(TimeEventType) = replaceFunction<BOOL(__cdecl)(TimeEventType)>(0x10060970, [](TimeEventType type)->BOOL {
+			TimeEventLegacyListScope legacyScope;
+			return orgRemoveAll(type);
+		});
+		static BOOL(__cdecl*orgRemove)(TimeEventType, void*) = replaceFunction<BOOL(__cdecl)(TimeEventType, void*)>(0x10060A40, [](TimeEventType type, void* predicate)->BOOL {
+			TimeEventLegacyListScope legacyScope;
+			return orgRemove(type, predicate);
+		});
+		static BOOL(__cdecl*orgRemoveWithCallback)(TimeEventType, void*) = replaceFunction<BOOL(__cdecl)(TimeEventType, void*)>(0x10060B20, [](TimeEventType type, void* callback)->BOOL {
+			TimeEventLegacyListScope legacyScope;
+			return orgRemoveWithCallback(type, callback);
+		});
+
 		static int (*orgTimeEventValidate)(TimeEventListEntry* evt, int flag) = 
 			replaceFunction<int (__cdecl)(TimeEventListEntry*, int)>(0x10060430, [](TimeEventListEntry* evt, int isLoadingMap){
 			
@@ -893,10 +1031,12 @@ TimeEventSystem::TimeEventSystem(const GameSystemConf &config) {
 }
 TimeEventSystem::~TimeEventSystem() {
 	auto shutdown = temple::GetPointer<void()>(0x10061820);
+	TimeEventLegacyListScope legacyScope;
 	shutdown();
 }
 void TimeEventSystem::Reset() {
 	auto reset = temple::GetPointer<void()>(0x100617a0);
+	TimeEventLegacyListScope legacyScope;
 	reset();
 }
 bool TimeEventSystem::SaveGame(TioFile *file) {
@@ -1082,8 +1222,6 @@ void TimeEventSystem::AdvanceTime(uint32_t newTimeMs) {
 
 	// expire events whose time has come (executing their expired callback)
 
-	
-	TimeEventListEntry lastValid;
 	expiredCount = 0;
 	for (auto clockType = 0; clockType < (int)GameClockType::ClockTypeCount; clockType++) {
 		GameTime * time;
@@ -1111,23 +1249,11 @@ void TimeEventSystem::AdvanceTime(uint32_t newTimeMs) {
 			auto nextNode = node->nextEvent;
 
 			*evtListEntry = nextNode;
+			sListIndex.OnHeadRemoved((GameClockType)clockType, node);
 
 			// Expire event
-			auto sysSpec = GetTimeEventTypeSpec(node->evt.system);
-			auto now = TigGetSystemTime();
-			if (node->IsValid(0)) {
-				lastValid = *node;
-				sysSpec.expiredCallback(&node->evt);
-			}
-
-			if (sysSpec.removedCallback) {
-				sysSpec.removedCallback(&node->evt);
-			}
-			/*if (TigElapsedSystemTime(now) > 100) {
-				logger->trace("Slow callback detected on system {}",(int) node->evt.system);
-			}*/
 			auto evtSystemId = node->evt.system;
-			free(node);
+			ExpireEvent(node);
 
 			expiredCount++;
 			if (expiredCount >= 500) {
@@ -1146,9 +1272,112 @@ void TimeEventSystem::AdvanceTime(uint32_t newTimeMs) {
 	// unmark isInAdvanceTime
 	isInAdvanceTime = FALSE;
 
+	// append events that were added during this function call
+	AddPendingEvents();
+
+}
 
+void TimeEventSystem::FastForward(const GameTime & span)
+{
+	if (span.timeInDays < 0 || span.timeInMs < 0 || (!span.timeInDays && !span.timeInMs))
+		return;
 
-	// append events that were added during this function call
+	auto &gameTimeElapsed = temple::GetRef<GameTime>(0x10AA83C0);
+	auto targetTime = gameTimeElapsed;
+	targetTime += span;
+
+	// this may be called from an expiring event (e.g. a script doing fade_and_teleport), in which case
+	// AdvanceTime is the one to append the pending events
+	auto &isInAdvanceTime = temple::GetRef<BOOL>(0x10AA83DC);
+	auto wasInAdvanceTime = isInAdvanceTime;
+	isInAdvanceTime = TRUE;
+
+	// Expire events in order of their time. While an event is handled, the clock reads its time, so
+	// that anything it schedules is relative to that. Events it schedules that are due within the skip
+	// are merged into the list right away, so periodic events (healing, aging, etc.) fire once per period
+	// just like they would if the time had passed normally.
+	auto clockType = GameClockType::GameTime;
+	auto evtList = &temple::GetRef<TimeEventListEntry*[]>(0x10AA73FC)[(int)clockType];
+	auto pendingList = &temple::GetRef<TimeEventListEntry*[]>(0x10AA73E8)[(int)clockType];
+	auto expiredCount = 0;
+	while (*evtList) {
+		auto node = *evtList;
+		auto &evtTime = node->evt.time;
+		if (evtTime.timeInDays > targetTime.timeInDays
+			|| (evtTime.timeInDays >= targetTime.timeInDays
+				&& evtTime.timeInMs > targetTime.timeInMs)) {
+			break;
+		}
+
+		*evtList = node->nextEvent;
+		sListIndex.OnHeadRemoved(clockType, node);
+
+		if (evtTime.timeInDays > gameTimeElapsed.timeInDays
+			|| (evtTime.timeInDays >= gameTimeElapsed.timeInDays
+				&& evtTime.timeInMs > gameTimeElapsed.timeInMs)) {
+			gameTimeElapsed = evtTime;
+		}
+
+		auto evtSystemId = node->evt.system;
+		ExpireEvent(node);
+
+		// the pending list is sorted by time as well, so the due events are at its front
+		while (*pendingList) {
+			auto pending = *pendingList;
+			auto &pendingTime = pending->evt.time;
+			if (pendingTime.timeInDays > targetTime.timeInDays
+				|| (pendingTime.timeInDays >= targetTime.timeInDays
+					&& pendingTime.timeInMs > targetTime.timeInMs)) {
+				break;
+			}
+			*pendingList = pending->nextEvent;
+			if (pending->ObjHandlesValid()) {
+				sListIndex.Insert(clockType, pending);
+			}
+			else {
+				free(pending);
+			}
+		}
+
+		// guard against events that keep re-arming themselves without advancing the clock
+		if (++expiredCount >= 100000) {
+			logger->error("TimeEvent::FastForward: Suspected Infinite Loop Caught: Last Type: {}", (int)evtSystemId);
+			break;
+		}
+	}
+	gameTimeElapsed = targetTime;
+
+	isInAdvanceTime = wasInAdvanceTime;
+	if (!wasInAdvanceTime) {
+		AddPendingEvents();
+	}
+
+	// daylight and terrain only need to catch up with the final time
+	auto updateDaylight = temple::GetRef<void(__cdecl)()>(0x100A75E0);
+	updateDaylight();
+	gameSystems->GetTerrain().UpdateDayNight();
+}
+
+void TimeEventSystem::ExpireEvent(TimeEventListEntry * node)
+{
+	auto evtSystemId = node->evt.system;
+	auto &sysSpec = sTimeEventTypeSpecs[(size_t)evtSystemId];
+	Stopwatch sw;
+	if (node->IsValid(0)) {
+		sysSpec.expiredCallback(&node->evt);
+	}
+
+	if (sysSpec.removedCallback) {
+		sysSpec.removedCallback(&node->evt);
+	}
+	auto &stats = mTypeStats[(size_t)evtSystemId];
+	stats.expiredCount++;
+	stats.callbackTimeUs += sw.GetElapsedUs();
+	free(node);
+}
+
+void TimeEventSystem::AddPendingEvents()
+{
 	for (auto clockType = 0; clockType < (int)GameClockType::ClockTypeCount; clockType++) {
 		TimeEventListEntry** evtListInAdvanceTime = &temple::GetRef<TimeEventListEntry*[]>(0x10AA73E8)[clockType];
 
@@ -1157,7 +1386,7 @@ void TimeEventSystem::AdvanceTime(uint32_t newTimeMs) {
 			auto nextNode = node->nextEvent;
 
 			if (node->ObjHandlesValid()) {
-				gameSystems->GetTimeEvent().TimeEventListEntryAdd(node);
+				TimeEventListEntryAdd(node);
 			}
 			else {
 				free(node);
@@ -1166,7 +1395,6 @@ void TimeEventSystem::AdvanceTime(uint32_t newTimeMs) {
 			*evtListInAdvanceTime = nextNode;
 		}
 	}
-
 }
 const std::string &TimeEventSystem::GetName() const {
 	static std::string name("TimeEvent");
@@ -1176,12 +1404,14 @@ const std::string &TimeEventSystem::GetName() const {
 void TimeEventSystem::LoadForCurrentMap()
 {
 	static auto loadForCurrentMap = temple::GetPointer<void()>(0x10061D10);
+	TimeEventLegacyListScope legacyScope;
 	loadForCurrentMap();
 }
 
 void TimeEventSystem::ClearForMapClose()
 {
 	static auto clearForMapClose = temple::GetPointer<void()>(0x10061A50);
+	TimeEventLegacyListScope legacyScope;
 	clearForMapClose();
 }
 
@@ -1232,6 +1462,14 @@ void TimeEventSystem::AddTime(int timeInMs) {
 	GameTime_Add(timeInMs);
 }
 
+void TimeEventSystem::SkipTime(int timeInMs) {
+	// AddTime advances the clock with the vanilla game time add, which checks this (see GameTimeSystem)
+	auto wasSkippingTime = mSkippingTime;
+	mSkippingTime = true;
+	AddTime(timeInMs);
+	mSkippingTime = wasSkippingTime;
+}
+
 std::string TimeEventSystem::FormatTime(const GameTime& time) {
 
 	static auto GameTime_Format = temple::GetPointer<void(const GameTime*, char *)>(0x10061310);
@@ -1251,6 +1489,16 @@ void TimeEventSystem::PushDisableAdvance(){
 	call();
 }
 
+const TimeEventSystem::TypeStats& TimeEventSystem::GetTypeStats(TimeEventType type) const
+{
+	return mTypeStats[(size_t)type];
+}
+
+void TimeEventSystem::ResetTypeStats()
+{
+	mTypeStats.fill(TypeStats());
+}
+
 void TimeEventSystem::Remove(TimeEventType type, Predicate predicate)
 {
 	static std::function<bool(const TimeEvent&)> sPredicate;
@@ -1344,28 +1592,16 @@ bool TimeEventSystem::ScheduleInternal(GameTime * time, TimeEvent * evt, GameTim
 		newEntry->objects[i] = FrozenObjRef::Freeze(evt->params[i].handle);
 	}
 	
-	TimeEventListEntry**  evtList = &temple::GetRef<TimeEventListEntry*[]>(0x10AA73FC)[(int)sysSpec.clock];
-	
+	// insert event to the list (sorting from earliest to latest)
 	auto isSpecialScheduling = temple::GetRef<BOOL>(0x10AA83E0);
 	if (IsInAdvanceTime() && !isSpecialScheduling){
-		evtList = &temple::GetRef<TimeEventListEntry*[]>(0x10AA73E8)[(int)sysSpec.clock];
+		TimeEventListIndex::InsertLinear(&temple::GetRef<TimeEventListEntry*[]>(0x10AA73E8)[(int)sysSpec.clock], newEntry);
 	}
-
-	// insert event to the list (sorting from earliest to latest)
-	while (*evtList){
-		auto node = *evtList;
-		if (node->evt.time.timeInDays > evt->time.timeInDays
-			|| (node->evt.time.timeInDays >= evt->time.timeInDays) 
-			&& node->evt.time.timeInMs >= evt->time.timeInMs){
-			break;
-		}
-		evtList = &node->nextEvent;
+	else {
+		sListIndex.Insert(sysSpec.clock, newEntry);
 	}
-	newEntry->nextEvent = *evtList;
-	*evtList = newEntry;
 
 	
-	
 	if (triggerTimeOut){
 		*triggerTimeOut = evt->time;
 	}
@@ -1383,26 +1619,6 @@ BOOL TimeEventSystem::TimeEventListEntryAdd(TimeEventListEntry * evt){
 
 
 
-	TimeEventListEntry ** evtList;
-	auto isAdvancingTime = temple::GetRef<int>(0x10AA83DC);
-	if (isAdvancingTime)
-		evtList = &temple::GetRef<TimeEventListEntry*[]>(0x10AA73E8)[(int)clockType];
-	else
-		evtList = &temple::GetRef<TimeEventListEntry*[]>(0x10AA73FC)[(int)clockType];
-
-	// find where to insert the event
-	auto listNode = *evtList;
-	while (listNode) {
-		if (listNode->evt.time.timeInDays > evt->evt.time.timeInDays
-			|| listNode->evt.time.timeInDays >= evt->evt.time.timeInDays
-			&& listNode->evt.time.timeInMs >= evt->evt.time.timeInMs)
-			break;
-		evtList = &listNode->nextEvent;
-		listNode = listNode->nextEvent;
-	}
-
-	evt->nextEvent = *evtList;
-
 	// convert obj handles to persistable references
 	for (auto i = 0; i < 4; i++) {
 		if (sysSpec.argTypes[i] == TimeEventArgType::Object) {
@@ -1412,7 +1628,11 @@ BOOL TimeEventSystem::TimeEventListEntryAdd(TimeEventListEntry * evt){
 		}
 	}
 
-	*evtList = evt;
+	auto isAdvancingTime = temple::GetRef<int>(0x10AA83DC);
+	if (isAdvancingTime)
+		TimeEventListIndex::InsertLinear(&temple::GetRef<TimeEventListEntry*[]>(0x10AA73E8)[(int)clockType], evt);
+	else
+		sListIndex.Insert(clockType, evt);
 
 	return TRUE;
 }
@@ -1525,7 +1745,7 @@ BOOL TimeEventHooks::TimeEventReadFromFile(TioFile * file, TimeEvent * evtOut){
 }
 
 bool TimeEventListEntry::ObjHandlesValid(){
-	auto sysSpec = sTimeEventTypeSpecs[(int)this->evt.system];
+	auto &sysSpec = sTimeEventTypeSpecs[(int)this->evt.system];
 
 	for (auto i=0; i < 4; i++){
 		if (sysSpec.argTypes[i] != TimeEventArgType::Object)
@@ -88,16 +88,17 @@ enum class TimeEventArgType {
  * Contains the specification of how a type of time event is to be handled.
  */
 struct TimeEvent;
+using TimeEventCallback = BOOL(*)(const TimeEvent* event);
 struct TimeEventTypeSpec {
 	GameClockType clock; // Which clock is used for events of this type
-	std::function<BOOL(const TimeEvent* event)> expiredCallback; // Called when an event of this type expires
-	std::function<BOOL(const TimeEvent* event)> removedCallback; // Called whenever an event is freed (even if not expired)
+	TimeEventCallback expiredCallback; // Called when an event of this type expires
+	TimeEventCallback removedCallback; // Called whenever an event is freed (even if not expired)
 	bool persistent; // Events of this type are saved to the savegame
 	std::array<TimeEventArgType, 4> argTypes; // The types of the arguments stored in the time event
 
-	TimeEventTypeSpec(GameClockType clock,
-		std::function<BOOL(const TimeEvent* event)> expiredCallback,
-		std::function<BOOL(const TimeEvent* event)> removedCallback,
+	constexpr TimeEventTypeSpec(GameClockType clock,
+		TimeEventCallback expiredCallback,
+		TimeEventCallback removedCallback,
 		bool persistent,
 		TimeEventArgType arg1 = TimeEventArgType::None,
 		TimeEventArgType arg2 = TimeEventArgType::None,
@@ -109,6 +110,7 @@ struct TimeEventTypeSpec {
 
 // Get the argument types for a specific type of time event
 const TimeEventTypeSpec& GetTimeEventTypeSpec(TimeEventType type);
+const char* GetTimeEventTypeName(TimeEventType type);
 
 union TimeEventArg {
 	int32_t int32;
@@ -138,6 +140,16 @@ struct TimeEventListEntry {
 
 #pragma pack(pop)
 
+/*
+	Scope guard for calling vanilla functions that modify the time event lists directly
+	(e.g. the original remove / map close / game time advance routines). While one is
+	active, the sorted-insertion index over the lists is bypassed; it is rebuilt afterwards.
+*/
+struct TimeEventLegacyListScope {
+	TimeEventLegacyListScope();
+	~TimeEventLegacyListScope();
+};
+
 class TimeEventSystem : public GameSystem, public SaveGameAwareGameSystem, public ResetAwareGameSystem, public TimeAwareGameSystem {
 friend class TimeEventHooks;
 public:
@@ -169,10 +181,23 @@ public:
 
 	void GameTimeAdd(const GameTime &advanceBy);
 
+	/**
+	 * Advances the game time clock by an arbitrary span in one pass (resting, time skips).
+	 * Events are expired strictly in time order, including the ones they schedule within the span
+	 * (so periodic events fire once per period); daylight and terrain are updated once at the end.
+	 */
+	void FastForward(const GameTime &span);
+
 	// It does the same as the previous, but if more than a day is passed
 	// additional dispatcher functions are called for the party (DK_NEWDAY_CALENDARICAL)
 	void AddTime(int timeInMs);
 
+	// AddTime for real time skips (resting, game.gametime_add), which advances the clock through FastForward
+	void SkipTime(int timeInMs);
+	bool IsSkippingTime() const {
+		return mSkippingTime;
+	}
+
 	string FormatTime(const GameTime &time);
 
 	/**
@@ -187,6 +212,16 @@ public:
 	using Predicate = std::function<bool(const TimeEvent&)>;
 	void Remove(TimeEventType type, Predicate predicate);
 
+	/**
+	 * Expiry statistics per time event type, shown in the debug UI.
+	 */
+	struct TypeStats {
+		uint32_t expiredCount = 0;
+		int64_t callbackTimeUs = 0; // time spent in the expired/removed callbacks
+	};
+	const TypeStats& GetTypeStats(TimeEventType type) const;
+	void ResetTypeStats();
+
 private:
 	/*
 	Adds a timed event to be executed later.
@@ -202,9 +237,16 @@ private:
 	BOOL TimeEventReadFromFile(TioFile * file, TimeEvent * evtOut);
 
 	BOOL TimeEventListEntryAdd(TimeEventListEntry * evt);
+
+	// Runs the callbacks of an event unlinked from its list and frees it
+	void ExpireEvent(TimeEventListEntry * node);
+	// Appends the events that were scheduled while expiring events
+	void AddPendingEvents();
 	
 	BOOL TimeEventParamSerializer(TioFile *file, const TimeEventTypeSpec &sysSpec, TimeEventListEntry *listNode);
 	
 	bool IsInAdvanceTime();
 
+	std::array<TypeStats, (size_t)TimeEventType::TimeEventSystemCount> mTypeStats;
+	bool mSkippingTime = false;
 };
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "gametime.h"
 #include <temple/dll.h>
+#include "gamesystems/timeevents.h"
+#include "gamesystems/gamesystems.h"
 
 constexpr int TIME_1DAY_IN_MSEC = 86400000;
 
@@ -33,6 +35,16 @@ GameTime GameTimeSystem::GetElapsed() {
 
 void(__cdecl*GameTimeSystem::orgGameTimeAdd)(GameTime* timeDelta);
 
+void GameTimeSystem::HookedGameTimeAdd(GameTime* timeDelta)
+{
+	auto &timeEvents = gameSystems->GetTimeEvent();
+	if (timeEvents.IsSkippingTime()) {
+		timeEvents.FastForward(*timeDelta);
+	} else {
+		orgGameTimeAdd(timeDelta);
+	}
+}
+
 void GameTime::operator+=(const GameTime& amt)
 {
 	timeInMs += amt.timeInMs;
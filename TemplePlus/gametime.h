@@ -59,9 +59,11 @@ public:
 
 	void apply() override
 	{
-		orgGameTimeAdd = replaceFunction(0x10060C90, GameTimeAdd);
+		orgGameTimeAdd = replaceFunction(0x10060C90, HookedGameTimeAdd);
 	};
 protected:
+	// Uses TimeEventSystem::FastForward during TimeEventSystem::SkipTime, and the original otherwise
+	static void HookedGameTimeAdd(GameTime* timeDelta);
 	static void(__cdecl*orgGameTimeAdd)(GameTime* timeDelta);
 
 };
@@ -0,0 +1,303 @@
+#include "stdafx.h"
+#include "path_cache.h"
+#include "pathfinding.h"
+#include "path_node.h"
+#include "location.h"
+#include "obj.h"
+#include "objlist.h"
+
+static constexpr uint32_t FailedPathExpirationMs = 5000;
+
+// Furthest an object's center can be from the path while still being in the way of the mover
+static constexpr float MaxBlockerRadius = MAX_OBJ_RADIUS_SUBTILES * INCH_PER_SUBTILE;
+
+bool PathCache::Key::operator==(const Key& other) const
+{
+	return flags == other.flags
+		&& critter == other.critter
+		&& fromSubtile == other.fromSubtile
+		&& toSubtile == other.toSubtile
+		&& targetObj == other.targetObj
+		&& tolRadius == other.tolRadius
+		&& distanceToTargetMin == other.distanceToTargetMin
+		&& maxShortPathFindLength == other.maxShortPathFindLength;
+}
+
+PathCache::PathCache()
+{
+	Clear();
+}
+
+bool PathCache::Get(PathQuery* pq, Path* pathOut)
+{
+	if (mIndex.empty()) {
+		return false;
+	}
+
+	auto key = MakeKey(pq);
+	auto hash = HashKey(key);
+	auto it = mIndex.find(hash);
+	if (it == mIndex.end() || !(mEntries[it->second].key == key)) {
+		return false;
+	}
+
+	auto idx = it->second;
+	auto& entry = mEntries[idx];
+	if (!(entry.flags & PF_COMPLETE)) {
+		if (timeGetTime() - entry.timeCached > FailedPathExpirationMs) {
+			Remove(idx);
+			return false;
+		}
+	} else {
+		GatherBlockers(entry, pq, mBlockersScratch);
+		if (mBlockersScratch != entry.blockers) {
+			Remove(idx);
+			return false;
+		}
+	}
+
+	LruUnlink(idx);
+	LruPushFront(idx);
+
+	pathOut->flags = entry.flags;
+	pathOut->field4 = entry.field4;
+	pathOut->from = entry.from;
+	pathOut->to = entry.to;
+	pathOut->mover = entry.mover;
+	std::copy(entry.directions.begin(), entry.directions.end(), pathOut->directions);
+	pathOut->nodeCount3 = entry.nodeCount3;
+	pathOut->initTo1 = entry.initTo1;
+	memset(pathOut->tempNodes, 0, sizeof(pathOut->tempNodes)); // filled in again on demand
+	pathOut->nodeCount2 = entry.nodeCount2;
+	pathOut->fieldd84 = entry.fieldd84;
+	std::copy(entry.nodes.begin(), entry.nodes.end(), pathOut->nodes);
+	pathOut->nodeCount = entry.nodeCount;
+	pathOut->currentNode = entry.currentNode;
+	pathOut->field_1a10 = entry.field_1a10;
+	pathOut->field_1a14 = entry.field_1a14;
+	return true;
+}
+
+void PathCache::Push(PathQuery* pq, Path* path)
+{
+	auto key = MakeKey(pq);
+	auto hash = HashKey(key);
+
+	// Replaces the previous result for the same query (or, very unlikely, one with the same hash)
+	auto it = mIndex.find(hash);
+	if (it != mIndex.end()) {
+		Remove(it->second);
+	}
+	if (mFree.empty()) {
+		Remove(mLruTail);
+	}
+	auto idx = mFree.back();
+	mFree.pop_back();
+
+	auto& entry = mEntries[idx];
+	entry.key = key;
+	entry.hash = hash;
+	entry.timeCached = timeGetTime();
+
+	entry.flags = path->flags;
+	entry.field4 = path->field4;
+	entry.from = path->from;
+	entry.to = path->to;
+	entry.mover = path->mover;
+	entry.nodeCount3 = path->nodeCount3;
+	entry.initTo1 = path->initTo1;
+	entry.nodeCount2 = path->nodeCount2;
+	entry.fieldd84 = path->fieldd84;
+	entry.nodeCount = path->nodeCount;
+	entry.currentNode = path->currentNode;
+	entry.field_1a10 = path->field_1a10;
+	entry.field_1a14 = path->field_1a14;
+
+	constexpr int MaxNodes = 200;
+	auto directionCount = std::clamp(std::max(path->nodeCount2, path->nodeCount3), 0, MaxNodes);
+	entry.directions.assign(path->directions, path->directions + directionCount);
+	auto nodeCount = std::clamp(path->nodeCount, 0, MaxNodes);
+	entry.nodes.assign(path->nodes, path->nodes + nodeCount);
+
+	entry.moverRadius = pq->critter ? objects.GetRadius(pq->critter) : 0.0f;
+	entry.blockers.clear();
+	if (entry.flags & PF_COMPLETE) {
+		GatherBlockers(entry, pq, entry.blockers);
+	}
+
+	mIndex[hash] = idx;
+	LruPushFront(idx);
+}
+
+void PathCache::Clear()
+{
+	mEntries.clear();
+	mEntries.resize(Capacity);
+	mIndex.clear();
+	mFree.clear();
+	for (int i = (int)Capacity - 1; i >= 0; i--) {
+		mFree.push_back(i);
+	}
+	mLruHead = mLruTail = -1;
+}
+
+PathCache::Key PathCache::MakeKey(PathQuery* pq)
+{
+	Key key;
+	key.flags = pq->flags;
+	key.critter = pq->critter;
+	key.fromSubtile = locSys.subtileFromLoc(&pq->from);
+	key.tolRadius = pq->tolRadius;
+	key.distanceToTargetMin = pq->distanceToTargetMin;
+	key.maxShortPathFindLength = pq->maxShortPathFindLength;
+
+	if (pq->flags & PQF_TARGET_OBJ) {
+		// Paths to a target that has moved since are of no use
+		key.targetObj = pq->targetObj;
+		auto targetLoc = pq->targetObj ? objects.GetLocationFull(pq->targetObj) : pq->to;
+		key.toSubtile = locSys.subtileFromLoc(&targetLoc);
+	} else {
+		key.targetObj = objHndl::null;
+		key.toSubtile = locSys.subtileFromLoc(&pq->to);
+	}
+	return key;
+}
+
+uint64_t PathCache::HashKey(const Key& key)
+{
+	// 64-bit FNV-1a over the fields (not the whole struct, which has padding)
+	uint64_t hash = 14695981039346656037ull;
+	auto add = [&](const void* data, size_t size) {
+		auto bytes = (const uint8_t*)data;
+		for (size_t i = 0; i < size; i++) {
+			hash ^= bytes[i];
+			hash *= 1099511628211ull;
+		}
+	};
+	add(&key.flags, sizeof(key.flags));
+	add(&key.critter.handle, sizeof(key.critter.handle));
+	add(&key.fromSubtile, sizeof(key.fromSubtile));
+	add(&key.toSubtile, sizeof(key.toSubtile));
+	add(&key.targetObj.handle, sizeof(key.targetObj.handle));
+	add(&key.tolRadius, sizeof(key.tolRadius));
+	add(&key.distanceToTargetMin, sizeof(key.distanceToTargetMin));
+	add(&key.maxShortPathFindLength, sizeof(key.maxShortPathFindLength));
+	return hash;
+}
+
+void PathCache::Remove(int idx)
+{
+	auto& entry = mEntries[idx];
+	mIndex.erase(entry.hash);
+	LruUnlink(idx);
+	entry.directions.clear();
+	entry.nodes.clear();
+	entry.blockers.clear();
+	mFree.push_back(idx);
+}
+
+void PathCache::LruUnlink(int idx)
+{
+	auto& entry = mEntries[idx];
+	if (entry.lruPrev != -1) {
+		mEntries[entry.lruPrev].lruNext = entry.lruNext;
+	} else {
+		mLruHead = entry.lruNext;
+	}
+	if (entry.lruNext != -1) {
+		mEntries[entry.lruNext].lruPrev = entry.lruPrev;
+	} else {
+		mLruTail = entry.lruPrev;
+	}
+	entry.lruPrev = entry.lruNext = -1;
+}
+
+void PathCache::LruPushFront(int idx)
+{
+	auto& entry = mEntries[idx];
+	entry.lruPrev = -1;
+	entry.lruNext = mLruHead;
+	if (mLruHead != -1) {
+		mEntries[mLruHead].lruPrev = idx;
+	}
+	mLruHead = idx;
+	if (mLruTail == -1) {
+		mLruTail = idx;
+	}
+}
+
+static float DistanceToSegmentSquared(XMFLOAT2 p, XMFLOAT2 a, XMFLOAT2 b)
+{
+	auto abX = b.x - a.x, abY = b.y - a.y;
+	auto lengthSquared = abX * abX + abY * abY;
+	auto t = 0.0f;
+	if (lengthSquared > 0) {
+		t = std::clamp(((p.x - a.x) * abX + (p.y - a.y) * abY) / lengthSquared, 0.0f, 1.0f);
+	}
+	auto dx = p.x - (a.x + t * abX), dy = p.y - (a.y + t * abY);
+	return dx * dx + dy * dy;
+}
+
+void PathCache::GatherBlockers(const Entry& entry, PathQuery* pq, std::vector<Blocker>& blockersOut)
+{
+	blockersOut.clear();
+
+	std::vector<XMFLOAT2> points;
+	points.reserve(entry.nodes.size() + 2);
+	points.push_back(entry.from.ToInches2D());
+	for (auto& node : entry.nodes) {
+		points.push_back(node.ToInches2D());
+	}
+	points.push_back(entry.to.ToInches2D());
+
+	auto distanceToPath = [&](XMFLOAT2 p) {
+		auto minDistSquared = std::numeric_limits<float>::max();
+		for (size_t i = 0; i + 1 < points.size(); i++) {
+			minDistSquared = std::min(minDistSquared, DistanceToSegmentSquared(p, points[i], points[i + 1]));
+		}
+		return sqrtf(minDistSquared);
+	};
+
+	// Circle around the path's bounding box, widened by how far a blocker can reach into it
+	auto minX = points[0].x, maxX = points[0].x, minY = points[0].y, maxY = points[0].y;
+	for (auto& point : points) {
+		minX = std::min(minX, point.x);
+		maxX = std::max(maxX, point.x);
+		minY = std::min(minY, point.y);
+		maxY = std::max(maxY, point.y);
+	}
+	auto reach = entry.moverRadius + MaxBlockerRadius + INCH_PER_TILE;
+	auto searchRadius = 0.5f * sqrtf((maxX - minX) * (maxX - minX) + (maxY - minY) * (maxY - minY)) + reach;
+	LocAndOffsets center = LocAndOffsets::FromInches(0.5f * (minX + maxX), 0.5f * (minY + maxY));
+
+	ObjList objList;
+	objList.ListRadius(center, searchRadius, OLC_PATH_BLOCKER);
+	for (auto obj : objList) {
+		if (obj == pq->critter || obj == pq->targetObj) {
+			continue;
+		}
+		if (objects.GetFlags(obj) & (OF_OFF | OF_DONTDRAW | OF_DESTROYED | OF_NO_BLOCK)) {
+			continue;
+		}
+
+		auto objLoc = objects.GetLocationFull(obj);
+		auto objRadius = objects.GetRadius(obj);
+		if (objects.GetType(obj) == obj_t_portal) {
+			// Doors don't move, but opening or closing one can affect the paths next to it
+			if (distanceToPath(objLoc.ToInches2D()) < entry.moverRadius + objRadius + INCH_PER_TILE) {
+				blockersOut.push_back({ obj.handle, objects.IsPortalOpen(obj) ? 1 : 0 });
+			}
+			continue;
+		}
+
+		// Only moving to another subtile counts, so blockers are placed at the center of theirs
+		auto subtile = locSys.subtileFromLoc(&objLoc);
+		LocAndOffsets subtileCenter;
+		locSys.SubtileToLocAndOff(subtile, &subtileCenter);
+		if (distanceToPath(subtileCenter.ToInches2D()) < entry.moverRadius + objRadius + INCH_PER_SUBTILE) {
+			blockersOut.push_back({ obj.handle, subtile });
+		}
+	}
+
+	std::sort(blockersOut.begin(), blockersOut.end());
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "common.h"
+
+struct PathQuery;
+struct Path;
+enum PathQueryFlags : uint32_t;
+
+/*
+	Results of past FindPath queries, so repeated queries (e.g. the AI evaluating the same moves
+	several times during a combat round) don't have to run the pathfinder again.
+
+	Entries are looked up by a hash of the query (flags, critter, start and destination subtiles, radii)
+	and evicted in least recently used order. Only the used parts of the path are stored.
+
+	Instead of expiring after a fixed time, a path is checked before it is reused: it is discarded if
+	a path blocker has moved into or out of the subtiles along it, or a door next to it has been opened
+	or closed since. Failed queries have no path to check, so they still expire after a while.
+*/
+class PathCache
+{
+public:
+	static constexpr size_t Capacity = 128;
+
+	PathCache();
+
+	// Copies the cached result for the query to pathOut; returns false if there is none (or it's no longer valid)
+	bool Get(PathQuery* pq, Path* pathOut);
+
+	void Push(PathQuery* pq, Path* path);
+
+	void Clear();
+
+private:
+	struct Key
+	{
+		PathQueryFlags flags;
+		objHndl critter;
+		int64_t fromSubtile;
+		int64_t toSubtile; // the target's subtile for PQF_TARGET_OBJ queries
+		objHndl targetObj;
+		float tolRadius;
+		float distanceToTargetMin;
+		int maxShortPathFindLength;
+
+		bool operator==(const Key& other) const;
+	};
+
+	// Identifies a path blocker that was next to the path (see GatherBlockers)
+	struct Blocker
+	{
+		uint64_t handle;
+		int64_t state; // the subtile of critters and other blockers, the open state of doors
+
+		bool operator<(const Blocker& other) const {
+			return handle < other.handle || (handle == other.handle && state < other.state);
+		}
+		bool operator==(const Blocker& other) const {
+			return handle == other.handle && state == other.state;
+		}
+	};
+
+	struct Entry
+	{
+		Key key;
+		uint64_t hash = 0;
+		uint32_t timeCached = 0;
+		int lruPrev = -1;
+		int lruNext = -1;
+
+		// The Path, minus the unused parts of its arrays
+		int flags;
+		int field4;
+		LocAndOffsets from;
+		LocAndOffsets to;
+		objHndl mover;
+		int nodeCount3;
+		int initTo1;
+		int nodeCount2;
+		int fieldd84;
+		int nodeCount;
+		int currentNode;
+		int field_1a10;
+		int field_1a14;
+		std::vector<ScreenDirections> directions;
+		std::vector<LocAndOffsets> nodes;
+
+		float moverRadius;
+		std::vector<Blocker> blockers; // sorted
+	};
+
+	std::vector<Entry> mEntries;
+	std::unordered_map<uint64_t, int> mIndex; // by key hash
+	std::vector<int> mFree;
+	int mLruHead = -1; // most recently used
+	int mLruTail = -1;
+	std::vector<Blocker> mBlockersScratch;
+
+	static Key MakeKey(PathQuery* pq);
+	static uint64_t HashKey(const Key& key);
+
+	void Remove(int idx);
+	void LruUnlink(int idx);
+	void LruPushFront(int idx);
+
+	// Lists the path blockers that are close enough to the path that moving them could affect it
+	static void GatherBlockers(const Entry& entry, PathQuery* pq, std::vector<Blocker>& blockersOut);
+};
@@ -0,0 +1,282 @@
+#include "stdafx.h"
+#include "path_clearance.h"
+#include "gamesystems/map/sector.h"
+
+#include <atomic>
+#include <thread>
+
+#include <infrastructure/vfs.h>
+#include <infrastructure/exception.h>
+
+static constexpr uint32_t ClearanceFileMagic = 0x4C435054; // TPCL
+static constexpr uint32_t ClearanceFileVersion = 1;
+
+/*
+	Precedes the ClearanceIndex in clearance.bin. Files written by older versions start with the
+	ClearanceIndex directly, which can't be mistaken for the magic since the sector indices are < 256.
+*/
+struct ClearanceFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numSectors;
+	uint32_t reserved;
+	uint64_t sectorHashes[ClearanceBuilder::SectorsPerSide][ClearanceBuilder::SectorsPerSide]; // 0 for sectors without clearance data
+};
+
+// Squared distance transform of a single row or column (Felzenszwalb & Huttenlocher).
+// v and z are scratch space for n and n + 1 entries.
+static void DistanceTransform1d(const float* f, float* d, int n, int* v, float* z)
+{
+	constexpr float Infinity = std::numeric_limits<float>::infinity();
+
+	int k = 0;
+	v[0] = 0;
+	z[0] = -Infinity;
+	z[1] = Infinity;
+	for (int q = 1; q < n; q++) {
+		auto intersect = [&](int p) {
+			return ((f[q] + q * q) - (f[p] + p * p)) / (2 * q - 2 * p);
+		};
+		auto s = intersect(v[k]);
+		while (s <= z[k]) {
+			k--;
+			s = intersect(v[k]);
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = Infinity;
+	}
+
+	k = 0;
+	for (int q = 0; q < n; q++) {
+		while (z[k + 1] < q)
+			k++;
+		auto p = v[k];
+		d[q] = (float)((q - p) * (q - p)) + f[p];
+	}
+}
+
+void ClearanceBuilder::ComputeSectorClearance(const uint8_t* paddedBlocked, SectorClearanceData& out)
+{
+	// Stands in for "no blocked subtile"; far beyond the cap, but small enough to keep the float math exact
+	constexpr float Unblocked = 2.0f * PaddedSize * PaddedSize;
+	constexpr float MaxClearance = MAX_OBJ_RADIUS_SUBTILES * (INCH_PER_TILE / 3);
+
+	std::vector<float> grid(PaddedSize * PaddedSize);
+	float f[PaddedSize], d[PaddedSize], z[PaddedSize + 1];
+	int v[PaddedSize];
+
+	// columns first
+	for (int x = 0; x < PaddedSize; x++) {
+		for (int y = 0; y < PaddedSize; y++) {
+			f[y] = paddedBlocked[y * PaddedSize + x] ? 0.0f : Unblocked;
+		}
+		DistanceTransform1d(f, d, PaddedSize, v, z);
+		for (int y = 0; y < PaddedSize; y++) {
+			grid[y * PaddedSize + x] = d[y];
+		}
+	}
+
+	// then the rows, but only the ones inside of the sector are needed
+	for (int y = 0; y < SubtilesPerSector; y++) {
+		auto row = &grid[(y + Border) * PaddedSize];
+		DistanceTransform1d(row, d, PaddedSize, v, z);
+		for (int x = 0; x < SubtilesPerSector; x++) {
+			auto distSquared = d[x + Border];
+			if (distSquared >= Border * Border) {
+				out.val[y][x] = MaxClearance;
+			} else {
+				out.val[y][x] = sqrtf(distSquared) * (INCH_PER_TILE / 3);
+			}
+		}
+	}
+}
+
+int ClearanceBuilder::Generate(const std::string& fileName, MapClearanceData& clearanceOut)
+{
+	constexpr int MapSubtiles = SectorsPerSide * SubtilesPerSector;
+	constexpr auto BlockingFlags = TileFlags::BlockX0Y0 | TileFlags::FlyOverX0Y0;
+
+	// Collect the blocked subtiles of the whole map up front, since the sector system can only be used from this thread
+	std::vector<uint8_t> blocked(MapSubtiles * MapSubtiles, 0);
+
+	struct SectorJob {
+		int secX;
+		int secY;
+		uint64_t hash;
+	};
+	std::vector<SectorJob> jobs;
+
+	ClearanceIndex clrIdx;
+	for (int secY = 0; secY < SectorsPerSide; secY++) {
+		for (int secX = 0; secX < SectorsPerSide; secX++) {
+			SectorLoc secLoc(secX, secY);
+			Sector* sect;
+			if (!sectorSys.SectorFileExists(secLoc) || !sectorSys.SectorLock(secLoc, &sect)) {
+				continue;
+			}
+
+			for (int ty = 0; ty < SECTOR_SIDE_SIZE; ty++) {
+				for (int tx = 0; tx < SECTOR_SIDE_SIZE; tx++) {
+					auto flags = sect->tilePkt.tiles[tx + SECTOR_SIDE_SIZE * ty].flags;
+					for (int sy = 0; sy < 3; sy++) {
+						for (int sx = 0; sx < 3; sx++) {
+							if (flags & (BlockingFlags << (sx + 3 * sy))) {
+								auto subtileX = secX * SubtilesPerSector + tx * 3 + sx;
+								auto subtileY = secY * SubtilesPerSector + ty * 3 + sy;
+								blocked[subtileY * MapSubtiles + subtileX] = 1;
+							}
+						}
+					}
+				}
+			}
+			sectorSys.SectorUnlock(secLoc);
+
+			clrIdx.clrAddr[secY][secX] = (uint16_t)jobs.size();
+			jobs.push_back({ secX, secY, 0 });
+		}
+	}
+
+	MapClearanceData previous;
+	uint64_t previousHashes[SectorsPerSide][SectorsPerSide] = {};
+	auto hasPrevious = ReadFile(fileName, previous, &previousHashes[0][0]);
+
+	auto secClr = (SectorClearanceData*)malloc(std::max<size_t>(1, jobs.size()) * sizeof(SectorClearanceData));
+	std::atomic<int> nextJob{ 0 };
+	std::atomic<int> recomputed{ 0 };
+
+	auto processJobs = [&]() {
+		std::vector<uint8_t> padded(PaddedSize * PaddedSize);
+		for (int jobIdx = nextJob++; jobIdx < (int)jobs.size(); jobIdx = nextJob++) {
+			auto& job = jobs[jobIdx];
+
+			// Subtiles outside of the map count as unblocked
+			auto originX = job.secX * SubtilesPerSector - Border;
+			auto originY = job.secY * SubtilesPerSector - Border;
+			for (int y = 0; y < PaddedSize; y++) {
+				for (int x = 0; x < PaddedSize; x++) {
+					auto mapX = originX + x, mapY = originY + y;
+					auto inMap = mapX >= 0 && mapY >= 0 && mapX < MapSubtiles && mapY < MapSubtiles;
+					padded[y * PaddedSize + x] = inMap ? blocked[mapY * MapSubtiles + mapX] : 0;
+				}
+			}
+
+			job.hash = HashSectorBlocking(padded.data());
+			if (hasPrevious && previousHashes[job.secY][job.secX] == job.hash) {
+				auto previousIdx = previous.clrIdx.clrAddr[job.secY][job.secX];
+				secClr[jobIdx] = previous.secClr[previousIdx];
+				continue;
+			}
+
+			ComputeSectorClearance(padded.data(), secClr[jobIdx]);
+			recomputed++;
+		}
+	};
+
+	std::vector<std::thread> threads;
+	auto threadCount = std::min<size_t>(jobs.size(), std::max(1u, std::thread::hardware_concurrency()));
+	for (size_t i = 1; i < threadCount; i++) {
+		threads.emplace_back(processJobs);
+	}
+	processJobs();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	previous.Reset();
+
+	clearanceOut.Reset();
+	clearanceOut.clrIdx = clrIdx;
+	clearanceOut.clrIdx.numSectors = (unsigned char)jobs.size();
+	clearanceOut.secClr = secClr;
+
+	ClearanceFileHeader header{};
+	header.magic = ClearanceFileMagic;
+	header.version = ClearanceFileVersion;
+	header.numSectors = (uint32_t)jobs.size();
+	for (auto& job : jobs) {
+		header.sectorHashes[job.secY][job.secX] = job.hash;
+	}
+
+	std::vector<uint8_t> data(sizeof(header) + sizeof(ClearanceIndex) + jobs.size() * sizeof(SectorClearanceData));
+	memcpy(&data[0], &header, sizeof(header));
+	memcpy(&data[sizeof(header)], &clearanceOut.clrIdx, sizeof(ClearanceIndex));
+	if (!jobs.empty()) {
+		memcpy(&data[sizeof(header) + sizeof(ClearanceIndex)], secClr, jobs.size() * sizeof(SectorClearanceData));
+	}
+
+	try {
+		vfs->WriteBinaryFile(fileName, data);
+	} catch (TempleException& e) {
+		logger->error("Unable to write clearance data: {}", e.what());
+		return -1;
+	}
+
+	return recomputed;
+}
+
+bool ClearanceBuilder::ReadFile(const std::string& fileName, MapClearanceData& clearanceOut, uint64_t* sectorHashesOut)
+{
+	if (!vfs->FileExists(fileName)) {
+		return false;
+	}
+
+	std::vector<uint8_t> data;
+	try {
+		data = vfs->ReadAsBinary(fileName);
+	} catch (TempleException& e) {
+		logger->warn("Unable to read clearance data: {}", e.what());
+		return false;
+	}
+
+	size_t offset = 0;
+	size_t numSectors;
+	ClearanceFileHeader header;
+	if (data.size() >= sizeof(header) && memcmp(&data[0], &ClearanceFileMagic, sizeof(ClearanceFileMagic)) == 0) {
+		memcpy(&header, &data[0], sizeof(header));
+		if (header.version != ClearanceFileVersion) {
+			logger->warn("Unsupported clearance data version {} in {}", header.version, fileName);
+			return false;
+		}
+		offset = sizeof(header);
+		numSectors = header.numSectors;
+	} else {
+		// The older format has no hashes, so all of its sectors will be recomputed on the next generation
+		if (data.size() < sizeof(ClearanceIndex)) {
+			return false;
+		}
+		numSectors = data[0]; // ClearanceIndex::numSectors
+		memset(&header.sectorHashes, 0, sizeof(header.sectorHashes));
+	}
+
+	if (data.size() < offset + sizeof(ClearanceIndex) + numSectors * sizeof(SectorClearanceData)) {
+		logger->warn("Clearance data in {} is truncated", fileName);
+		return false;
+	}
+
+	clearanceOut.Reset();
+	memcpy(&clearanceOut.clrIdx, &data[offset], sizeof(ClearanceIndex));
+	offset += sizeof(ClearanceIndex);
+	if (numSectors > 0) {
+		clearanceOut.secClr = (SectorClearanceData*)malloc(numSectors * sizeof(SectorClearanceData));
+		memcpy(clearanceOut.secClr, &data[offset], numSectors * sizeof(SectorClearanceData));
+	}
+
+	if (sectorHashesOut) {
+		memcpy(sectorHashesOut, header.sectorHashes, sizeof(header.sectorHashes));
+	}
+	return true;
+}
+
+uint64_t ClearanceBuilder::HashSectorBlocking(const uint8_t* paddedBlocked)
+{
+	// 64-bit FNV-1a, seeded with the version so a change in the computation invalidates old entries.
+	// Never 0, since that marks sectors without a hash.
+	uint64_t hash = 14695981039346656037ull ^ ClearanceFileVersion;
+	for (int i = 0; i < PaddedSize * PaddedSize; i++) {
+		hash ^= paddedBlocked[i];
+		hash *= 1099511628211ull;
+	}
+	return hash ? hash : 1;
+}
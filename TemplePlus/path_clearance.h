@@ -0,0 +1,40 @@
+#pragma once
+
+#include "path_node.h"
+
+/*
+	Builds the clearance data used by the pathfinder: for each subtile, the distance between its
+	center and the center of the closest blocked subtile, capped at MAX_OBJ_RADIUS_SUBTILES.
+	This is computed with a distance transform per sector, on multiple threads.
+
+	clearance.bin stores a hash of the blocked subtiles each sector's clearance was computed from,
+	so regenerating it only recomputes the sectors whose blocking has changed since.
+*/
+class ClearanceBuilder
+{
+public:
+	static constexpr int SectorsPerSide = 16;
+	static constexpr int SubtilesPerSector = 64 * 3;
+	// Subtiles taken from the surrounding sectors; nothing further away can affect the capped distance
+	static constexpr int Border = MAX_OBJ_RADIUS_SUBTILES;
+	static constexpr int PaddedSize = SubtilesPerSector + 2 * Border;
+
+	/*
+		Computes the clearance of a sector. paddedBlocked is a PaddedSize x PaddedSize map (row major, y first)
+		of the blocked subtiles around the sector, with the sector itself starting at (Border, Border).
+	*/
+	static void ComputeSectorClearance(const uint8_t* paddedBlocked, SectorClearanceData& out);
+
+	/*
+		Generates the clearance data for the currently loaded map and writes it to fileName.
+		Sectors are reused from the existing file if their blocked subtiles haven't changed.
+		Returns the number of sectors that were recomputed, or -1 if the file could not be written.
+	*/
+	static int Generate(const std::string& fileName, MapClearanceData& clearanceOut);
+
+	// Reads clearance.bin, either in the current format or the unversioned one written by older versions
+	static bool ReadFile(const std::string& fileName, MapClearanceData& clearanceOut, uint64_t* sectorHashesOut = nullptr);
+
+private:
+	static uint64_t HashSectorBlocking(const uint8_t* paddedBlocked);
+};
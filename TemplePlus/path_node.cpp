@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "common.h"
 #include "path_node.h"
+#include "path_clearance.h"
 #include "pathfinding.h"
 #include "location.h"
 #include "tio/tio.h"
@@ -22,6 +23,10 @@ char PathNodeSys::pathNodesSaveDir[260];
 MapPathNodeList * PathNodeSys::pathNodeList;
 MapClearanceData PathNodeSys::clearanceData;
 bool PathNodeSys::hasClearanceData = false;
+// Pathfinding::FindPathShortDistanceSansTarget only searches a 160x160 subtile grid around the from/to
+// locations, so it gives up on targets more than 80 subtiles away along either axis
+static constexpr float MaxNeighbourDistance = 81 * (INCH_PER_TILE / 3) * 1.4143f;
+
 struct PathNodeSysAddresses : temple::AddressTable
 {
 	
@@ -270,25 +275,8 @@ BOOL PathNodeSys::LoadNodesCurrent()
 			return 1;
 	}
 
-	auto clearanceFile = tio_fopen(clearanceFileName, "rb");
-	if (hasClearanceData)
-	{
-		free(clearanceData.secClr);
-	}
-	hasClearanceData = false;
-	if (clearanceFile)
-	{
-		int readStatus = tio_fread(&clearanceData.clrIdx, sizeof(clearanceData.clrIdx), 1, clearanceFile);
-		if (readStatus)
-		{	
-			clearanceData.secClr = new SectorClearanceData[clearanceData.clrIdx.numSectors];
-			readStatus = tio_fread(clearanceData.secClr, sizeof(SectorClearanceData), clearanceData.clrIdx.numSectors, clearanceFile);
-		}
-			
-		tio_fclose(clearanceFile);
-		if (readStatus)
-			hasClearanceData = true;
-	}
+	clearanceData.Reset();
+	hasClearanceData = ClearanceBuilder::ReadFile(clearanceFileName, clearanceData);
 
 
 	auto fileSupplem = tio_fopen(supplem, "rb");
@@ -339,6 +327,8 @@ BOOL PathNodeSys::LoadNodesCurrent()
 	}
 	tio_fclose(file);
 	if (fileSupplem) tio_fclose(fileSupplem);
+	pathNodeSys.mGraph.Build(pathNodeList);
+	pathNodeSys.mGrid.Build(pathNodeList);
 	return status;
 }
 
@@ -405,6 +395,9 @@ void PathNodeSys::Reset()
 	}
 	mActivePathNode = nullptr;
 	mPathnodeMoveRef = LocAndOffsets::null;
+	mGraph.Invalidate();
+	mGrid.Clear();
+	pathfindingSys.PathCacheInit(); // the cached paths belong to the map that is being unloaded
 }
 
 void PathNodeSys::SetDirs(char* loadDir, char* saveDir)
@@ -417,14 +410,22 @@ void PathNodeSys::RecalculateNeighbours(MapPathNodeList* node)
 {
 	if (!node)
 		return;
-	auto neighbor = pathNodeList;
+
+	// Nodes further away than the short distance pathfinder can reach can never become neighbours.
+	// Checking the closest candidates first also means the closest ones are kept if there are too many.
+	std::vector<MapPathNodeList*> candidates;
+	pathNodeSys.mGrid.FindInRadius(node->node.nodeLoc, MaxNeighbourDistance, candidates);
+	auto nodeLoc = node->node.nodeLoc;
+	std::sort(candidates.begin(), candidates.end(), [&](MapPathNodeList* a, MapPathNodeList* b) {
+		return locSys.distBtwnLocAndOffs(nodeLoc, a->node.nodeLoc) < locSys.distBtwnLocAndOffs(nodeLoc, b->node.nodeLoc);
+	});
+
 	PathQuery pathQ;
 	PathQueryResult path;
-	while (neighbor)
+	for (auto neighbor : candidates)
 	{
 		if (node->node.id == neighbor->node.id)
 		{
-			neighbor = neighbor->next;
 			continue;
 		}
 			
@@ -462,9 +463,9 @@ void PathNodeSys::RecalculateNeighbours(MapPathNodeList* node)
 				int aha = 0;
 			}
 		}
-		neighbor = neighbor->next;
 	}
 	*(int*)&node->node.flags |= PNF_NEIGHBOUR_DISTANCES_SET;
+	pathNodeSys.mGraph.Invalidate();
 }
 
 void PathNodeSys::RecalculateAllNeighbours()
@@ -586,103 +587,19 @@ BOOL PathNodeSys::FlushNodes(const char* saveDir)
 	return status;
 }
 
-void PathNodeSys::GenerateClearanceFile(const char * saveDir)
-{	
-
-	logger->info("Generating clearance data.");
-	int idx = -1;
-	auto secClrData = new SectorClearanceData();
-	clearanceData.Reset();
-
-	for (int secY = 0; secY < 16; secY++)
-	{
-		for (int secX = 0; secX < 16; secX++)
-		{
-			SectorLoc secLoc;
-			secLoc.raw = secX + (secY << 26);
-			Sector * sect;
-			int lockStatus = 0;
-			if (sectorSys.SectorFileExists(secLoc))
-			{
-				lockStatus = sectorSys.SectorLock(secLoc, &sect);
-				logger->info("Locking Sector:  X {} Y {}, status: {}", secX, secY, lockStatus);
-			}
-			
-			if (!lockStatus)
-			{
-				clearanceData.clrIdx.clrAddr[secY][secX] = -1;
-				continue;
-			}
-			clearanceData.clrIdx.clrAddr[secY][secX] = ++idx;
-			if (idx)
-				secClrData = (SectorClearanceData*)realloc(secClrData, (idx + 1)*sizeof(SectorClearanceData));
-			Subtile subtile;
-			for (int ny = 0; ny < 64 * 3; ny++)
-			{
-				subtile.y = secY * 64 * 3 + ny;
-				for (int nx = 0; nx < 64 * 3; nx++)
-				{
-					float clearancesInch = MAX_OBJ_RADIUS_SUBTILES * (INCH_PER_TILE / 3) ;
-					
-					subtile.x = secX*64*3 + nx;
-					LocAndOffsets loc;
-					locSys.SubtileToLocAndOff(subtile, &loc);
-					auto flags = sect->GetTileFlags(&loc);
-					if (flags)
-					{
-						//auto tileFlags = sectorSys.GetTileFlags(loc);
-						TileFlags flagsToCheck = (TileFlags)((TileFlags::BlockX0Y0 + TileFlags::FlyOverX0Y0) << (nx % 3 + 3 * (ny % 3)));
-						if (flagsToCheck & flags)
-						{
-							secClrData[idx].val[ny][nx] = 0;
-							continue;
-						}
-					}
-
-					RaycastPacket rayPkt;
-					rayPkt.flags = (RaycastFlags)(RaycastFlags::HasToBeCleared | RaycastFlags::ExcludeItemObjects | RaycastFlags::ExcludePortals | RaycastFlags::HasRadius);
-					rayPkt.radius = MAX_OBJ_RADIUS_TILES * INCH_PER_TILE;
-					rayPkt.targetLoc = rayPkt.origin = loc;
-					rayPkt.RaycastShortRange();
-					int numFound = rayPkt.resultCount;
-					for (int i = 0; i < numFound; i++)
-					{
-						auto res = &rayPkt.results[i];
-						if (!res->obj)
-						{
-
-							float clrRad = locSys.Distance3d(loc, res->loc) ;
-							if (clrRad < clearancesInch)
-								clearancesInch = clrRad;
-							if (clearancesInch == 0)
-								break;
-
-						}
-					}
-					secClrData[idx].val[ny][nx] = clearancesInch;
-				}// nx
-			} // ny
-			sectorSys.SectorUnlock(secLoc);
-			logger->info("Sector unlocked.");
-		}
-	}
-	
-	logger->info("Processing complete; saving to file clearance.bin");
-	clearanceData.clrIdx.numSectors = idx + 1;
-	clearanceData.secClr = secClrData;
-	hasClearanceData = true;
-
+int PathNodeSys::GenerateClearanceFile(const char * saveDir)
+{
 	char fileName[260];
 	if (!saveDir || !saveDir[0]) {
 		saveDir = pathNodesSaveDir;
 	}
 	_snprintf(fileName, 260, "%s\\%s", saveDir, "clearance.bin");
 
-	auto fil = tio_fopen(fileName, "wb" );
-	tio_fwrite(&clearanceData.clrIdx, sizeof(clearanceData.clrIdx), 1, fil);
-	tio_fwrite(clearanceData.secClr, sizeof(SectorClearanceData), clearanceData.clrIdx.numSectors, fil);
-	logger->info("Wrote to file. Closing.");
-	tio_fclose(fil);
+	logger->info("Generating clearance data.");
+	auto recomputed = ClearanceBuilder::Generate(fileName, clearanceData);
+	hasClearanceData = true;
+	logger->info("Recomputed clearance for {} sectors, saved to {}", recomputed, fileName);
+	return recomputed;
 }
 
 int PathNodeSys::CalcClearanceFromNearbyObjects(objHndl obj, float clearanceReq)
@@ -778,93 +695,11 @@ bool PathNodeSys::WriteNodeDistToFile(MapPathNodeList* node, TioFile* file)
 	return false;
 }
 
-void PathNodeSys::FindPathNodeAppend(const FindPathNodeData& node) {
-	fpbnData[fpbnCount++] = node;
-}
-
-int PathNodeSys::PopMinHeuristicNode(FindPathNodeData* fpndOut, bool useActualDist)
-{
-
-	if (!useActualDist)
-		return PopMinHeuristicNodeLegacy(fpndOut);
-
-	int idxMin;
-	// find a node with a positive actual distance
-	for (idxMin = 0; idxMin < fpbnCount; idxMin++)
-		if (fpbnData[idxMin].distActualTotal >= 0.0)
-			break;
-	if (idxMin == fpbnCount)
-		return 0;
-
-	// search for minimum cumulative distance
-	float minDistCumul = fpbnData[idxMin].distActualTotal + fpbnData[idxMin].distTo;
-	for (int i = idxMin + 1; i < fpbnCount; i++)
-	{
-		if (fpbnData[i].distActualTotal >= 0.0
-			&& ( fpbnData[i].distActualTotal + fpbnData[i].distTo ) < minDistCumul)
-{
-			idxMin = i;
-			minDistCumul = fpbnData[idxMin].distActualTotal + fpbnData[idxMin].distTo;
-		}
-	}
-
-	// copy it out
-	*fpndOut = fpbnData[idxMin];
-
-	// pop the found entry
-	fpbnData[idxMin] = fpbnData[fpbnCount - 1];
-	fpbnCount--;
-	return 1;
-}
-
-int PathNodeSys::PopMinHeuristicNodeLegacy(FindPathNodeData* fpndOut)
-{
-	int idxMinCumul;
-	// find a node with a positive cumulative distance
-	for (idxMinCumul = 0; idxMinCumul < fpbnCount; idxMinCumul++)
-		if (fpbnData[idxMinCumul].distCumul >= 0.0)
-			break;
-	if (idxMinCumul == fpbnCount)
-		return 0;
-
-	// search for minimum cumulative distance
-	float minDistCumul = fpbnData[idxMinCumul].distCumul;
-	for (int i = idxMinCumul + 1; i < fpbnCount; i++)
-	{
-		if (fpbnData[i].distCumul >= 0.0 
-			&& fpbnData[i].distCumul < minDistCumul)
-		{
-			idxMinCumul = i;
-			minDistCumul = fpbnData[idxMinCumul].distCumul;
-		}
-	}
-
-	// copy it out
-	*fpndOut = fpbnData[idxMinCumul];
-
-	// pop the found entry
-	fpbnData[idxMinCumul] = fpbnData[fpbnCount - 1];
-	fpbnCount--;
-	return 1;
-}
-
 BOOL PathNodeSys::FindClosestPathNode(LocAndOffsets* loc, int* nodeIdOut)
 {
-	float closestDist = 100000.0;
-	float dist;
-	auto node = pathNodeList;
-	MapPathNodeList * closestNode = nullptr;
-
-	while (node)
-	{
-		dist = locSys.distBtwnLocAndOffs(node->node.nodeLoc, *loc);
-		if (!closestNode || dist < closestDist)
-		{
-			closestNode = node;
-			closestDist = dist;
-		}
-		node = node->next;
-	}
+	std::vector<MapPathNodeList*> nearest;
+	mGrid.FindNearest(*loc, 1, nearest);
+	MapPathNodeList * closestNode = nearest.empty() ? nullptr : nearest[0];
 
 	if (closestNode )
 	{
@@ -878,206 +713,75 @@ BOOL PathNodeSys::FindClosestPathNode(LocAndOffsets* loc, int* nodeIdOut)
 
 int PathNodeSys::FindPathBetweenNodes(int fromNodeId, int toNodeId, int* nodeIds, int maxChainLength)
 {
-	MapPathNode fromNode, toNode;
-	int chainLength = 0;
-	int numNodes ;
-	auto pnIterator = pathNodeList;
-	for (numNodes = 0; pnIterator; ++numNodes)
-		pnIterator = pnIterator->next;
-
-	fpbnCount = 0;
+	if (!mGraph.valid)
+		mGraph.Build(pathNodeList);
 
 	// find the from/to nodes
-	pnIterator = pathNodeList;
-	if (!pathNodeSys.GetPathNode(fromNodeId, &fromNode))
+	auto fromIdx = mGraph.GetIndex(fromNodeId);
+	auto toIdx = mGraph.GetIndex(toNodeId);
+	if (fromIdx == -1 || toIdx == -1)
 		return 0;
-	if (!pathNodeSys.GetPathNode(toNodeId, &toNode))
-		return 0;
-	
-
 
 	// determine if the pathnodes are using the supplemental information of Actual Travel Distance (NEW! TemplePlus only)
 	// if so, the node distance evaluation algorithm will be quite different, taking into acconut the actual travel distance rather than the strange method employed by troika
 	bool useActualDistances = false;
-	if ((toNode.flags & PNF_NEIGHBOUR_DISTANCES_SET) && (fromNode.flags & PNF_NEIGHBOUR_DISTANCES_SET))
+	if ((mGraph.nodes[toIdx]->node.flags & PNF_NEIGHBOUR_DISTANCES_SET) && (mGraph.nodes[fromIdx]->node.flags & PNF_NEIGHBOUR_DISTANCES_SET))
 		useActualDistances = true;
-	
-
-	// testing neighbour IDs
-	//int neighboursTest[MAX_NEIGHBOURS];
-	//memcpy(neighboursTest, toNode.neighbours, toNode.neighboursCount * sizeof(int));
-	
-
 
 	// begin the A* algorithm
-	float distFromTo = locSys.distBtwnLocAndOffs(fromNode.nodeLoc, toNode.nodeLoc) / 12.0f;
-	
-	FindPathNodeData fpMinCumul;
-	fpMinCumul.nodeId = fromNodeId;
-	fpMinCumul.refererId = -1;
-	fpMinCumul.distFrom = 0;
-	fpMinCumul.distTo = distFromTo;
-	fpMinCumul.distCumul = distFromTo;
-	fpMinCumul.distActualTotal = 0;
-	fpMinCumul.heuristic = 0;
-	fpMinCumul.usingActualDistance = useActualDistances;
-
-	FindPathNodeAppend(fpMinCumul);
-
-	if (!PopMinHeuristicNode(&fpMinCumul, useActualDistances))
-	{
-	//	delete fpbnData;
-		return 0;
-	}
+	auto &fromLoc = mGraph.locs[fromIdx];
+	auto &toLoc = mGraph.locs[toIdx];
+	float distFromTo = locSys.distBtwnLocAndOffs(fromLoc, toLoc) / 12.0f;
 
-	MapPathNode minCumulNode, neighNode;
-	FindPathNodeData fpTemp;
+	mSearch.Reset(mGraph.GetNodeCount());
+	mSearch.Update(fromIdx, -1, useActualDistances ? 0.0f : distFromTo, distFromTo);
 
-	while(fpMinCumul.nodeId != toNodeId)
+	int current;
+	while ((current = mSearch.PopMin()) != -1 && current != toIdx)
 	{
-		// find the matching Path Node
-		pathNodeSys.GetPathNode(fpMinCumul.nodeId, &minCumulNode);
-
-		// loop thru its neighbours, searching 
-		for (int i = 0; i < minCumulNode.neighboursCount; i++)
+		// loop thru its neighbours
+		for (auto i = mGraph.neighStart[current]; i < mGraph.neighStart[current + 1]; i++)
 		{
-			fpTemp.refererId = fpMinCumul.nodeId;
-			fpTemp.nodeId = minCumulNode.neighbours[i];
-			
-			// find the neighbour node
-			int neighbourId = minCumulNode.neighbours[i];
-			pathNodeSys.GetPathNode(neighbourId, &neighNode);
+			auto neighbour = mGraph.neighIdx[i];
+			if (mSearch.IsClosed(neighbour))
+				continue;
 
 			// calculate its heuristic
-			fpTemp.distTo = locSys.distBtwnLocAndOffs(neighNode.nodeLoc, toNode.nodeLoc) / 12.0f;
-			fpTemp.distFrom = locSys.distBtwnLocAndOffs(fromNode.nodeLoc, neighNode.nodeLoc) / 12.0f;
-			fpTemp.distCumul = fpMinCumul.distCumul + fpTemp.distTo + fpTemp.distFrom;
+			auto distTo = locSys.distBtwnLocAndOffs(mGraph.locs[neighbour], toLoc) / 12.0f;
 			if (useActualDistances)
 			{
-				fpTemp.distActualTotal = fpMinCumul.distActualTotal + minCumulNode.neighDistances[i];
-				fpTemp.heuristic = fpTemp.distActualTotal + fpTemp.distTo;
-			}
-
-			bool foundNode = false;			
-			for (auto j = 0; j < fpbnCount; ++j) {
-				auto &node = fpbnData[j];
-				if (node.nodeId != fpTemp.nodeId) {
-					continue;
-				}
-
-				foundNode = true;
-
-				// Effectively the same path segment (TODO: Is getting here a bug already? Is it searching in cycles?)
-				if (node.refererId == fpTemp.refererId || true) {
-					if (useActualDistances) {
-						if (fpTemp.distActualTotal + fpTemp.distTo < node.distActualTotal + node.distTo) {
-							node = fpTemp;
-							break;
-						}
-					}
-					else {
-						if (fpTemp.distCumul < node.distCumul) {
-							node = fpTemp;
-							break;
-						}
-					}
-				}
-				/*
-				if (useActualDistances) {
-					if (fpTemp.distActualTotal + fpTemp.distTo < node.distActualTotal + node.distTo) {
-						FindPathNodeAppend(fpTemp);
-						break;
-					}
-				} else {
-					if (fpTemp.distCumul < node.distCumul) {
-						FindPathNodeAppend(fpTemp);
-						break;
-					}
-				}
-				*/
+				auto distActualTotal = mSearch.cost[current] + mGraph.neighDist[i];
+				mSearch.Update(neighbour, current, distActualTotal, distActualTotal + distTo);
 			}
-
-			// append node if it's not in the list yet
-			if (!foundNode) {
-				FindPathNodeAppend(fpTemp);
+			else
+			{
+				auto distFrom = locSys.distBtwnLocAndOffs(fromLoc, mGraph.locs[neighbour]) / 12.0f;
+				auto distCumul = mSearch.cost[current] + distTo + distFrom;
+				mSearch.Update(neighbour, current, distCumul, distCumul);
 			}
-
-		}
-
-		fpMinCumul.distCumul = -1.0;
-		fpMinCumul.distActualTotal = -1.0;
-		FindPathNodeAppend(fpMinCumul);
-
-		if (!PopMinHeuristicNode(&fpMinCumul, useActualDistances))
-		{
-		//	delete fpbnData;
-			return 0;
 		}
 	}
 
-	fpTemp = fpMinCumul;
-
-	int refId0 = fpMinCumul.refererId; // the node leading up to the last node
-	chainLength = 1;
+	if (current != toIdx)
+		return 0;
 
 	// get the chain length
-	int refererId = fpTemp.refererId;
-	while (refererId != -1) {
-		int refererFound = 0;
-		for (int i = 0; i < fpbnCount; i++) {
-			if (fpbnData[i].nodeId == refererId) {
-				fpTemp = fpbnData[i];
-				refererFound = 1;
-				break;
-			}
-				
-		}
-		if (!refererFound) {
-			break;
-			//shit
-		}
+	int chainLength = 0;
+	for (auto idx = toIdx; idx != -1; idx = mSearch.parent[idx])
 		chainLength++;
-		refererId = fpTemp.refererId;
-	}
 
 	if (chainLength >= maxChainLength)
-	{
-	//	delete fpbnData;
 		return 0;
-		
-	}
 
 	// dump node chain into nodeIds
-	fpTemp = fpMinCumul;
-	refererId = fpMinCumul.refererId;
-	for (int i = chainLength -1 ; i >= 0 ; i--)
+	auto idx = toIdx;
+	for (int i = chainLength - 1; i >= 0; i--)
 	{
-		nodeIds[i] = fpTemp.nodeId;
-		int refererFound = 0;
-		for (int refIdx = 0; refIdx < fpbnCount; refIdx++)
-		{
-			if (fpbnData[refIdx].nodeId == refererId)
-			{
-				fpTemp = fpbnData[refIdx];
-				refererId = fpTemp.refererId;
-				refererFound = 1;
-				break;
-			}
-
-		}
-		if (i == 0 && refererId != -1)
-		{
-			int breakPointDummy = 1;
-		}
-
+		nodeIds[i] = mGraph.ids[idx];
+		idx = mSearch.parent[idx];
 	}
 
-//	delete fpbnData;
 	return chainLength;
-	
-
-
-	// return _FindPathBetweenNodes(fromNodeId, toNodeId, nodeIds, maxChainLength);
 }
 
 void PathNodeSys::AddPathNode(LocAndOffsets& loc, bool recalcNeighbours)
@@ -1109,6 +813,8 @@ void PathNodeSys::AddPathNode(LocAndOffsets& loc, bool recalcNeighbours)
 	// prepend to list (should not affect neighbour search since it does SANS_PATHNODE pathfinding)
 	newNode->next = pathNodeList;
 	pathNodeList = newNode;
+	mGraph.Invalidate();
+	mGrid.Add(newNode);
 	
 	mNeedsRecalcNeighbours = true;
 }
@@ -1237,8 +943,10 @@ void PathNodeSys::DeleteActiveNode(){
 		return;
 
 	PopNode(mActivePathNode);
+	mGrid.Remove(mActivePathNode);
 	FreeNode(mActivePathNode);
 	mActivePathNode = nullptr;
+	mGraph.Invalidate();
 }
 
 bool PathNodeSys::MoveActiveNode(LocAndOffsets* newLoc)
@@ -1251,7 +959,10 @@ bool PathNodeSys::MoveActiveNode(LocAndOffsets* newLoc)
 
 		auto pickedNodeToMove = mPathnodeMoveRef != LocAndOffsets::null;
 		if (pickedNodeToMove) {
+			auto oldLoc = mActivePathNode->node.nodeLoc;
 			mActivePathNode->node.nodeLoc = *newLoc;
+			mGraph.Invalidate();
+			mGrid.Move(mActivePathNode, oldLoc);
 			return false;
 		}
 		else {
@@ -1281,7 +992,10 @@ void PathNodeSys::CancelMoveActiveNode(){
 	if (mPathnodeMoveRef == LocAndOffsets::null) {
 		return;
 	}
+	auto oldLoc = mActivePathNode->node.nodeLoc;
 	mActivePathNode->node.nodeLoc = mPathnodeMoveRef;
+	mGraph.Invalidate();
+	mGrid.Move(mActivePathNode, oldLoc);
 	mPathnodeMoveRef = LocAndOffsets::null;
 }
 
@@ -1299,6 +1013,295 @@ int PathNodeSys::GetNewId(){
 	return nextId++;
 }
 
+void PathNodeGraph::Build(MapPathNodeList* list)
+{
+	nodes.clear();
+	ids.clear();
+	locs.clear();
+	idToIndex.clear();
+	for (auto node = list; node; node = node->next) {
+		auto id = node->node.id;
+		if (id < 0)
+			continue;
+		if (id >= (int)idToIndex.size())
+			idToIndex.resize(id + 1, -1);
+		if (idToIndex[id] != -1)
+			continue; // same as GetPathNode, the first node with an id wins
+		idToIndex[id] = (int)nodes.size();
+		nodes.push_back(node);
+		ids.push_back(id);
+		locs.push_back(node->node.nodeLoc);
+	}
+
+	neighStart.clear();
+	neighIdx.clear();
+	neighDist.clear();
+	neighStart.reserve(nodes.size() + 1);
+	for (auto node : nodes) {
+		neighStart.push_back((int)neighIdx.size());
+		for (int i = 0; i < node->node.neighboursCount; i++) {
+			auto neighbour = GetIndex(node->node.neighbours[i]);
+			if (neighbour == -1)
+				continue;
+			neighIdx.push_back(neighbour);
+			// taken as is, like the search always did: links that can be walked in a straight line are stored negated
+			neighDist.push_back(node->node.neighDistances ? node->node.neighDistances[i] : 0.0f);
+		}
+	}
+	neighStart.push_back((int)neighIdx.size());
+
+	valid = true;
+}
+
+void PathNodeGraph::Invalidate()
+{
+	valid = false;
+}
+
+int PathNodeGraph::GetIndex(int id) const
+{
+	if (id < 0 || id >= (int)idToIndex.size())
+		return -1;
+	return idToIndex[id];
+}
+
+void PathNodeSearch::Reset(int nodeCount)
+{
+	if ((int)cost.size() < nodeCount) {
+		heapPos.resize(nodeCount);
+		cost.resize(nodeCount);
+		priority.resize(nodeCount);
+		parent.resize(nodeCount);
+	}
+	seenBits.assign((nodeCount + 31) / 32, 0);
+	closedBits.assign((nodeCount + 31) / 32, 0);
+	heap.clear();
+}
+
+void PathNodeSearch::Update(int idx, int parentIdx, float nodeCost, float nodePriority)
+{
+	if (IsSeen(idx)) {
+		if (IsClosed(idx) || nodePriority >= priority[idx])
+			return;
+		cost[idx] = nodeCost;
+		priority[idx] = nodePriority;
+		parent[idx] = parentIdx;
+		SiftUp(heapPos[idx]);
+		return;
+	}
+
+	seenBits[idx >> 5] |= 1u << (idx & 31);
+	cost[idx] = nodeCost;
+	priority[idx] = nodePriority;
+	parent[idx] = parentIdx;
+	heap.push_back(idx);
+	heapPos[idx] = (int)heap.size() - 1;
+	SiftUp(heapPos[idx]);
+}
+
+int PathNodeSearch::PopMin()
+{
+	if (heap.empty())
+		return -1;
+
+	auto result = heap[0];
+	closedBits[result >> 5] |= 1u << (result & 31);
+
+	heap[0] = heap.back();
+	heapPos[heap[0]] = 0;
+	heap.pop_back();
+	if (!heap.empty())
+		SiftDown(0);
+	return result;
+}
+
+void PathNodeSearch::SiftUp(int pos)
+{
+	auto idx = heap[pos];
+	while (pos > 0) {
+		auto parentPos = (pos - 1) / 2;
+		if (priority[heap[parentPos]] <= priority[idx])
+			break;
+		heap[pos] = heap[parentPos];
+		heapPos[heap[pos]] = pos;
+		pos = parentPos;
+	}
+	heap[pos] = idx;
+	heapPos[idx] = pos;
+}
+
+void PathNodeSearch::SiftDown(int pos)
+{
+	auto idx = heap[pos];
+	auto count = (int)heap.size();
+	for (;;) {
+		auto child = 2 * pos + 1;
+		if (child >= count)
+			break;
+		if (child + 1 < count && priority[heap[child + 1]] < priority[heap[child]])
+			child++;
+		if (priority[idx] <= priority[heap[child]])
+			break;
+		heap[pos] = heap[child];
+		heapPos[heap[pos]] = pos;
+		pos = child;
+	}
+	heap[pos] = idx;
+	heapPos[idx] = pos;
+}
+
+void PathNodeGrid::Build(MapPathNodeList* list)
+{
+	Clear();
+	for (auto node = list; node; node = node->next) {
+		Add(node);
+	}
+}
+
+void PathNodeGrid::Clear()
+{
+	mCells.clear();
+	mCount = 0;
+	mMinCellX = mMinCellY = 0;
+	mMaxCellX = mMaxCellY = -1;
+}
+
+void PathNodeGrid::Add(MapPathNodeList* node)
+{
+	auto cellX = GetCellCoord(node->node.nodeLoc.location.locx);
+	auto cellY = GetCellCoord(node->node.nodeLoc.location.locy);
+	mCells[GetCellKey(cellX, cellY)].push_back(node);
+
+	if (mMaxCellX < mMinCellX) {
+		mMinCellX = mMaxCellX = cellX;
+		mMinCellY = mMaxCellY = cellY;
+	} else {
+		mMinCellX = std::min(mMinCellX, cellX);
+		mMaxCellX = std::max(mMaxCellX, cellX);
+		mMinCellY = std::min(mMinCellY, cellY);
+		mMaxCellY = std::max(mMaxCellY, cellY);
+	}
+	mCount++;
+}
+
+void PathNodeGrid::Remove(MapPathNodeList* node)
+{
+	auto cellX = GetCellCoord(node->node.nodeLoc.location.locx);
+	auto cellY = GetCellCoord(node->node.nodeLoc.location.locy);
+	auto it = mCells.find(GetCellKey(cellX, cellY));
+	if (it == mCells.end())
+		return;
+
+	auto& cell = it->second;
+	auto nodeIt = std::find(cell.begin(), cell.end(), node);
+	if (nodeIt == cell.end())
+		return;
+	*nodeIt = cell.back();
+	cell.pop_back();
+	mCount--;
+}
+
+void PathNodeGrid::Move(MapPathNodeList* node, const LocAndOffsets& oldLoc)
+{
+	auto newLoc = node->node.nodeLoc;
+	if (GetCellCoord(oldLoc.location.locx) == GetCellCoord(newLoc.location.locx)
+		&& GetCellCoord(oldLoc.location.locy) == GetCellCoord(newLoc.location.locy))
+		return;
+
+	node->node.nodeLoc = oldLoc;
+	Remove(node);
+	node->node.nodeLoc = newLoc;
+	Add(node);
+}
+
+void PathNodeGrid::FindNearest(const LocAndOffsets& loc, size_t count, std::vector<MapPathNodeList*>& result) const
+{
+	if (!count || !mCount)
+		return;
+
+	std::vector<std::pair<float, MapPathNodeList*>> best;
+	auto centerX = GetCellCoord(loc.location.locx);
+	auto centerY = GetCellCoord(loc.location.locy);
+	auto maxRing = std::max(
+		std::max(std::abs(centerX - mMinCellX), std::abs(centerX - mMaxCellX)),
+		std::max(std::abs(centerY - mMinCellY), std::abs(centerY - mMaxCellY)));
+
+	// Visit the cells in rings around the query location, until no node in the next ring can be closer
+	// than the ones found so far. Anything in ring r is at least r-1 cells away, minus the tile offsets.
+	for (auto ring = 0; ring <= maxRing; ring++) {
+		if (best.size() >= count) {
+			auto ringDist = std::max(0, (ring - 1) * CellSizeTiles - 1) * INCH_PER_TILE;
+			if (ringDist > best.back().first)
+				break;
+		}
+
+		for (auto cellY = centerY - ring; cellY <= centerY + ring; cellY++) {
+			auto onEdgeY = cellY == centerY - ring || cellY == centerY + ring;
+			for (auto cellX = centerX - ring; cellX <= centerX + ring; cellX += (onEdgeY || ring == 0) ? 1 : 2 * ring) {
+				auto cell = GetCell(cellX, cellY);
+				if (!cell)
+					continue;
+				for (auto node : *cell) {
+					auto dist = locSys.distBtwnLocAndOffs(node->node.nodeLoc, loc);
+					if (best.size() >= count && dist >= best.back().first)
+						continue;
+					auto pos = std::upper_bound(best.begin(), best.end(), dist, [](float d, const std::pair<float, MapPathNodeList*>& entry) {
+						return d < entry.first;
+					});
+					best.insert(pos, { dist, node });
+					if (best.size() > count)
+						best.pop_back();
+				}
+			}
+		}
+	}
+
+	for (auto& entry : best) {
+		result.push_back(entry.second);
+	}
+}
+
+void PathNodeGrid::FindInRadius(const LocAndOffsets& loc, float radius, std::vector<MapPathNodeList*>& result) const
+{
+	// one extra tile to account for the offsets within the tiles
+	auto radiusTiles = (int)(radius / INCH_PER_TILE) + 1;
+	auto minCellX = std::max(mMinCellX, GetCellCoord((int)loc.location.locx - radiusTiles));
+	auto maxCellX = std::min(mMaxCellX, GetCellCoord((int)loc.location.locx + radiusTiles));
+	auto minCellY = std::max(mMinCellY, GetCellCoord((int)loc.location.locy - radiusTiles));
+	auto maxCellY = std::min(mMaxCellY, GetCellCoord((int)loc.location.locy + radiusTiles));
+
+	for (auto cellY = minCellY; cellY <= maxCellY; cellY++) {
+		for (auto cellX = minCellX; cellX <= maxCellX; cellX++) {
+			auto cell = GetCell(cellX, cellY);
+			if (!cell)
+				continue;
+			for (auto node : *cell) {
+				if (locSys.distBtwnLocAndOffs(node->node.nodeLoc, loc) <= radius)
+					result.push_back(node);
+			}
+		}
+	}
+}
+
+int PathNodeGrid::GetCellCoord(int tile)
+{
+	// round towards negative infinity, so negative tiles don't share cell 0
+	return tile >= 0 ? tile / CellSizeTiles : (tile - CellSizeTiles + 1) / CellSizeTiles;
+}
+
+uint64_t PathNodeGrid::GetCellKey(int cellX, int cellY)
+{
+	return ((uint64_t)(uint32_t)cellY << 32) | (uint32_t)cellX;
+}
+
+const std::vector<MapPathNodeList*>* PathNodeGrid::GetCell(int cellX, int cellY) const
+{
+	auto it = mCells.find(GetCellKey(cellX, cellY));
+	if (it == mCells.end() || it->second.empty())
+		return nullptr;
+	return &it->second;
+}
+
 MapPathNodeList::MapPathNodeList()
 {
 	memset(this, 0, sizeof(MapPathNodeList));
@@ -62,16 +62,95 @@ struct MapPathNodeList
 
 const int TestSizeMapPathNodeList = sizeof(MapPathNodeList); //  should be 48 (0x30)
 
-struct FindPathNodeData
+/*
+	Read-only copy of the path node network used for searching. Nodes are addressed by their
+	position in the list rather than by id, and the neighbours of all nodes are stored back to back
+	(compressed sparse rows), so the search doesn't have to walk the node list.
+	The per-node neighbour arrays remain the editable (and persisted) version of the network.
+*/
+struct PathNodeGraph
 {
-	int nodeId;
-	int refererId; // for the From node is -1; together with the "distCumul = -1" nodes will form a chain leading From -> To
-	float distFrom; // distance to the From node; is set to 0 for the from node naturally :)
-	float distTo; // distance to the To node;
-	float distCumul; // can be set to -1
-	float distActualTotal;
-	float heuristic;
-	bool usingActualDistance;
+	bool valid = false;
+	std::vector<MapPathNodeList*> nodes;
+	std::vector<int> ids;
+	std::vector<LocAndOffsets> locs;
+	std::vector<int> idToIndex; // -1 for unused ids
+	std::vector<int> neighStart; // index of the first neighbour of each node in neighIdx/neighDist, followed by the total count
+	std::vector<int> neighIdx;
+	std::vector<float> neighDist; // actual travel distance, as stored in the node (negative if walkable in a straight line)
+
+	void Build(MapPathNodeList* list);
+	void Invalidate();
+	int GetIndex(int id) const;
+	int GetNodeCount() const {
+		return (int)ids.size();
+	}
+};
+
+/*
+	Open/closed set state of FindPathBetweenNodes. The open set is a binary heap with decrease-key.
+	Sized to the node count and kept between searches; only the bitmaps need clearing per search.
+*/
+struct PathNodeSearch
+{
+	std::vector<int> heap;
+	std::vector<int> heapPos; // position in the heap for nodes in the open set
+	std::vector<float> cost; // accumulated cost from the From node
+	std::vector<float> priority;
+	std::vector<int> parent; // -1 for the From node; following it leads To -> From
+	std::vector<uint32_t> seenBits; // set once a node has been added to the open set
+	std::vector<uint32_t> closedBits;
+
+	void Reset(int nodeCount);
+	bool IsSeen(int idx) const {
+		return (seenBits[idx >> 5] & (1u << (idx & 31))) != 0;
+	}
+	bool IsClosed(int idx) const {
+		return (closedBits[idx >> 5] & (1u << (idx & 31))) != 0;
+	}
+	// Adds the node to the open set, or lowers its priority if it is already in it and the new one is better
+	void Update(int idx, int parentIdx, float nodeCost, float nodePriority);
+	// Removes the node with the lowest priority from the open set and closes it; -1 if the open set is empty
+	int PopMin();
+
+private:
+	void SiftUp(int pos);
+	void SiftDown(int pos);
+};
+
+/*
+	Uniform grid over the path node locations for nearest node and radius queries.
+	Built when the nodes are loaded and updated by the node editor.
+*/
+class PathNodeGrid
+{
+public:
+	void Build(MapPathNodeList* list);
+	void Clear();
+	void Add(MapPathNodeList* node);
+	void Remove(MapPathNodeList* node);
+	void Move(MapPathNodeList* node, const LocAndOffsets& oldLoc); // call after changing the node's location
+
+	// Appends up to count nodes closest to loc, ordered by distance
+	void FindNearest(const LocAndOffsets& loc, size_t count, std::vector<MapPathNodeList*>& result) const;
+	// Appends the nodes within radius (in inches) of loc, in no particular order
+	void FindInRadius(const LocAndOffsets& loc, float radius, std::vector<MapPathNodeList*>& result) const;
+
+	size_t GetCount() const {
+		return mCount;
+	}
+
+private:
+	static constexpr int CellSizeTiles = 16;
+
+	static int GetCellCoord(int tile);
+	static uint64_t GetCellKey(int cellX, int cellY);
+	const std::vector<MapPathNodeList*>* GetCell(int cellX, int cellY) const;
+
+	std::unordered_map<uint64_t, std::vector<MapPathNodeList*>> mCells;
+	size_t mCount = 0;
+	// bounds of all cells that were ever used, limits how far the nearest node search expands
+	int mMinCellX = 0, mMinCellY = 0, mMaxCellX = -1, mMaxCellY = -1;
 };
 
 class PathNodeSys: public TempleFix
@@ -88,9 +167,6 @@ public:
 	static MapPathNodeList * pathNodeList;
 	MapPathNodeList _pathNodeList[MaxPathNodes]; //  will replace the referenced list once we're done
 
-	int fpbnCount; // Current number of used nodes in fpbnData
-	std::array<FindPathNodeData, MaxPathNodes> fpbnData;
-
 
 
 	static BOOL LoadNodeFromFile(TioFile* file, MapPathNodeList ** listOut );
@@ -107,12 +183,9 @@ public:
 	static bool WriteNodeDistToFile(MapPathNodeList* node, TioFile* tioFile);
 	BOOL FlushNodes(const char* saveDir = nullptr);
 
-	static void GenerateClearanceFile(const char* saveDir = nullptr);
+	static int GenerateClearanceFile(const char* saveDir = nullptr); // returns the number of sectors that had to be recomputed, -1 on failure
 	static int CalcClearanceFromNearbyObjects(objHndl obj, float clearanceReq);
 
-	void FindPathNodeAppend(const FindPathNodeData &);
-	int PopMinHeuristicNode(FindPathNodeData* fpndOut, bool useActualDistances); // output is 1 on success 0 on fail (if all nodes are negative distance)
-	int PopMinHeuristicNodeLegacy(FindPathNodeData* fpndOut); // output is 1 on success 0 on fail (if all nodes are negative distance)
 	BOOL FindClosestPathNode(LocAndOffsets * loc, int * nodeIdOut);
 	int FindPathBetweenNodes(int fromNodeId, int toNodeId, int *nodeIds, int maxChainLength);
 	void AddPathNode(LocAndOffsets& loc, bool recalcNeighbours=false);
@@ -137,6 +210,9 @@ private:
 	bool mRenderPathNodesEn = false;
 	MapPathNodeList* mActivePathNode = nullptr;
 	LocAndOffsets mPathnodeMoveRef = LocAndOffsets::null;
+	PathNodeGraph mGraph;
+	PathNodeGrid mGrid;
+	PathNodeSearch mSearch;
 	static MapPathNodeList* GetPathNodeListEntry(int id);
 };
 
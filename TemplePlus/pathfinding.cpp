@@ -14,8 +14,14 @@
 #include "python/python_integration_obj.h"
 #include "python/python_object.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <infrastructure/workerpool.h>
+
 static constexpr int DontUseLength = std::numeric_limits<int>::min();
-#define PATH_CACHE_EXPIRATION_TIME 5000 // miliseconds
 
 Pathfinding pathfindingSys;
 
@@ -136,12 +142,278 @@ struct ProximityList
 };
 
 
-struct PathFindAddresses : temple::AddressTable
+/*
+	Scratch space of the short distance searches (see SearchShortPath) that is kept between queries.
+	Cells remember the query they were last written in, so a new query doesn't have to clear the grid.
+	The open set is a bucket queue keyed by the A* estimate (length + 10 * distance to the target).
+*/
+struct ShortPathWorkspace
+{
+	static constexpr int GridSize = 160; // number of subtiles spanned in the grid (vanilla: 128)
+	/*
+		A step adds at most 14 to the length and 10 to the heuristic, and since the heuristic is consistent
+		nothing is ever added below the current minimum. So the open set always fits into 25 consecutive buckets.
+	*/
+	static constexpr int BucketCount = 32;
+
+	enum CellFlags : uint8_t {
+		CF_CLEARANCE_CHECKED = 1,
+		CF_STRAIGHT_CLEAR = 2, // enough clearance to enter the subtile with a straight step
+		CF_DIAGONAL_CLEAR = 4 // ditto for diagonal steps
+	};
+
+	struct Cell
+	{
+		uint32_t query; // the rest of the cell is only valid if this is curQuery
+		int length; // 0 = unvisited, negative once closed, DontUseLength if the estimate exceeds the max length
+		int refererIdx;
+		uint32_t openSeq; // order in which the cell was added to the open set; ties are broken in favor of the earliest
+		uint8_t flags; // see CellFlags
+	};
+
+	struct OpenEntry
+	{
+		uint32_t openSeq;
+		int idx;
+		int length; // the entry is outdated if the cell's length has changed since
+
+		bool operator<(const OpenEntry& other) const {
+			return openSeq > other.openSeq; // the std heap functions put the largest element first
+		}
+	};
+
+	std::vector<Cell> cells;
+	std::vector<OpenEntry> buckets[BucketCount];
+	uint32_t curQuery = 0;
+	uint32_t nextOpenSeq = 0;
+	int openCount = 0; // entries in the buckets, including outdated ones
+	int curEstimate = 0;
+
+	void BeginQuery()
+	{
+		if (cells.empty()) {
+			cells.resize(GridSize * GridSize);
+		}
+		if (++curQuery == 0) {
+			for (auto& cell : cells) {
+				cell.query = 0;
+			}
+			curQuery = 1;
+		}
+		for (auto& bucket : buckets) {
+			bucket.clear();
+		}
+		openCount = 0;
+		nextOpenSeq = 0;
+		curEstimate = std::numeric_limits<int>::max();
+	}
+
+	Cell& Get(int idx)
+	{
+		auto& cell = cells[idx];
+		if (cell.query != curQuery) {
+			cell.query = curQuery;
+			cell.length = 0;
+			cell.refererIdx = -1;
+			cell.openSeq = 0;
+			cell.flags = 0;
+		}
+		return cell;
+	}
+
+	// Adds the cell to the open set, or moves it if it's already in there. The length has to be set already.
+	void Push(int idx, int estimate, bool alreadyOpen)
+	{
+		auto& cell = cells[idx];
+		if (!alreadyOpen) {
+			cell.openSeq = nextOpenSeq++;
+		}
+		if (estimate < curEstimate) { // only the case for the first cell, see BucketCount
+			curEstimate = estimate;
+		}
+		auto& bucket = buckets[estimate % BucketCount];
+		bucket.push_back({ cell.openSeq, idx, cell.length });
+		std::push_heap(bucket.begin(), bucket.end());
+		openCount++;
+	}
+
+	// Returns the open cell with the lowest estimate (the earliest added one on ties), or -1 if there is none
+	int PopMin()
+	{
+		while (openCount > 0) {
+			auto& bucket = buckets[curEstimate % BucketCount];
+			if (bucket.empty()) {
+				curEstimate++;
+				continue;
+			}
+			std::pop_heap(bucket.begin(), bucket.end());
+			auto entry = bucket.back();
+			bucket.pop_back();
+			openCount--;
+
+			auto& cell = cells[entry.idx];
+			if (cell.length == entry.length && cell.openSeq == entry.openSeq) {
+				return entry.idx;
+			}
+		}
+		return -1;
+	}
+};
+
+static thread_local ShortPathWorkspace shortPathWorkspace;
+
+/*
+	The grid and the game state a short distance search depends on, gathered up front (see PrepareShortPath).
+	With clearance data, SearchShortPath only reads this and the clearance data, so it can run on a worker thread.
+*/
+struct ShortPathSetup
+{
+	int cornerX;
+	int cornerY;
+	int idxFrom;
+	int idxTarget;
+	Subtile toSubtile;
+	float requisiteClearance;
+	float diagonalClearance;
+	float requisiteClearanceCritters;
+	ProximityList proxList;
+};
+
+/*
+	Limits how many short distance searches NPCs get within a second (and how long they may take in total),
+	so crowds of them can't stall the game.
+*/
+struct NpcPathThrottle
+{
+	int refTime = 0;
+	int attemptCount = 0;
+	int timeCumulative = 0;
+
+	// Counts an attempt, or returns false if there are none left. referenceTime is set to the start time for NPCs, and 0 otherwise.
+	bool Begin(objHndl critter, int maxAttempts, int& referenceTime)
+	{
+		referenceTime = 0;
+		if (!critter || objects.GetType(critter) != obj_t_npc)
+			return true;
+
+		int attempts = 0;
+		if (refTime && (timeGetTime() - refTime) < 1000)
+		{
+			attempts = attemptCount;
+			if (attemptCount > maxAttempts || timeCumulative > 250)
+				return false;
+		}
+		else
+		{
+			refTime = timeGetTime();
+			timeCumulative = 0;
+		}
+		attemptCount = attempts + 1;
+		referenceTime = timeGetTime();
+		return true;
+	}
+};
+
+static NpcPathThrottle sansTargetThrottle;
+static NpcPathThrottle adjRadiusThrottle;
+
+/*
+	A short distance search of FindPathSansNodes that has been prepared by BeginShortPath
+*/
+struct ShortPathSearch
+{
+	bool adjRadius; // FindPathShortDistanceAdjRadius rather than FindPathShortDistanceSansTarget
+	int npcReferenceTime; // see NpcPathThrottle::Begin
+	ShortPathSetup setup;
+
+	NpcPathThrottle& Throttle() const {
+		return adjRadius ? adjRadiusThrottle : sansTargetThrottle;
+	}
+};
+
+// The part of the halt condition of FindPathShortDistanceAdjRadius that needs raycasts
+static bool AdjRadiusDestIsClear(PathQuery* pq, Path* pqr, LocAndOffsets subPathFrom, LocAndOffsets subPathTo)
 {
-	PathResultCache * pathCache; // 40 entries, used as a ring buffer
-	int * pathCacheIdx;
-	int * pathCacheCleared;
+	if ((pq->flags & PQF_ADJ_RADIUS_REQUIRE_LOS) && !pathfindingSys.PathAdjRadiusLosClear(pqr, pq, subPathFrom, subPathTo))
+		return false;
+	return (pq->flags & (PQF_20 | PQF_10)) || pathfindingSys.PathDestIsClear(pq, pqr->mover, subPathFrom);
+}
+
+/*
+	Raycasts can only be done on the main thread, so the worker threads of FindPaths have the main thread
+	check the destinations their adjusted radius searches come across.
+*/
+class MainThreadDestChecks
+{
+public:
+	explicit MainThreadDestChecks(int workerCount) : mWorkersRunning(workerCount) {}
+
+	// Called by the workers; blocks until the main thread has done the check
+	bool Check(PathQuery* pq, Path* pqr, LocAndOffsets subPathFrom, LocAndOffsets subPathTo)
+	{
+		Request request{ pq, pqr, subPathFrom, subPathTo };
+		std::unique_lock<std::mutex> lock(mMutex);
+		mPending.push_back(&request);
+		mRequestPosted.notify_one();
+		mAnswered.wait(lock, [&] { return request.answered; });
+		return request.result;
+	}
+
+	void WorkerDone()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mWorkersRunning--;
+		mRequestPosted.notify_one();
+	}
+
+	// Called by the main thread; does the checks until all workers are done
+	void Serve()
+	{
+		std::vector<Request*> requests;
+		std::unique_lock<std::mutex> lock(mMutex);
+		while (true)
+		{
+			mRequestPosted.wait(lock, [&] { return !mPending.empty() || mWorkersRunning == 0; });
+			if (mPending.empty())
+				return;
+
+			requests.swap(mPending);
+			lock.unlock();
+			for (auto request : requests)
+				request->result = AdjRadiusDestIsClear(request->pq, request->pqr, request->subPathFrom, request->subPathTo);
+			lock.lock();
+
+			for (auto request : requests)
+				request->answered = true;
+			requests.clear();
+			mAnswered.notify_all();
+		}
+	}
+
+private:
+	struct Request
+	{
+		PathQuery* pq;
+		Path* pqr;
+		LocAndOffsets subPathFrom;
+		LocAndOffsets subPathTo;
+		bool answered = false;
+		bool result = false;
+	};
+
+	std::mutex mMutex;
+	std::condition_variable mRequestPosted;
+	std::condition_variable mAnswered;
+	std::vector<Request*> mPending;
+	int mWorkersRunning;
+};
 
+// The worker threads of FindPaths, kept between batches so each keeps its shortPathWorkspace
+static WorkerPool shortPathWorkers;
+
+
+struct PathFindAddresses : temple::AddressTable
+{
 	int * aStarMaxTimeMs;
 	int * aStarMaxWindowMs;
 	int * aStarTimeIdx;
@@ -187,9 +459,6 @@ struct PathFindAddresses : temple::AddressTable
 		rebase(aStarTimeElapsed, 0x1095B180);
 		rebase(aStarTimeEnded, 0x1095B1D0);
 
-		rebase(pathCache, 0x1099B220);
-		rebase(pathCacheIdx, 0x109DD260);
-		rebase(pathCacheCleared, 0x109DD264);
 
 
 		rebase(pathFindRefTime, 0x109DD270);
@@ -249,10 +518,6 @@ Pathfinding::Pathfinding() {
 	aStarMaxWindowMs = 5000;
 	aStarTimeIdx = -1;
 
-	memset(pathCache, 0, sizeof(pathCache));
-	pathCacheIdx = 0;
-	pathCacheCleared = 1;
-
 
 	// these two are still used a lot in other places outside the pathfinding system so I'm keeping them here for the time being
 	rebase(rollbackSequenceFlag,0x10B3D5C8); 
@@ -269,62 +534,12 @@ Pathfinding::Pathfinding() {
 
 int Pathfinding::PathCacheGet(PathQuery* pq, Path* pathOut)
 {
-	if (pathCacheCleared)
-		return 0;
-
-	for (int i = 0; i < PATH_RESULT_CACHE_SIZE; i++ )
-	{
-		
-
-		auto pathCacheQ = &pathCache[i];
-
-		if (!pathCacheQ->timeCached || pathCacheQ->timeCached < timeGetTime() - PATH_CACHE_EXPIRATION_TIME){
-			continue;
-		}
-
-		if (pq->flags != pathCacheQ->flags || pq->critter != pathCacheQ->critter)
-			continue;
-		auto fromSubtileCache = locSys.subtileFromLoc(&pathCacheQ->from);
-		auto fromSubtile = locSys.subtileFromLoc(&pq->from);
-		if (fromSubtileCache != fromSubtile)
-			continue;
-		
-		if (pq->flags & PQF_TARGET_OBJ)
-		{
-			if ( pq->targetObj != pathCacheQ->targetObj)
-				continue;
-		}
-		else
-		{
-			auto toSubtileCache = locSys.subtileFromLoc(&pathCacheQ->to);
-			auto toSubtile = locSys.subtileFromLoc(&pq->to);
-			if (toSubtileCache != toSubtile)
-				continue;
-		}
-
-		if (abs(pq->tolRadius - pathCacheQ->tolRadius) > 0.0001
-			|| abs(pq->distanceToTargetMin - pathCacheQ->distanceToTargetMin) > 0.0001
-			|| pq->maxShortPathFindLength != pathCacheQ->maxShortPathFindLength
-			)
-			continue;
-		
-		memcpy(pathOut, &pathCache[i].path, sizeof(Path));
-		return 1;
-		
-	}
-	return 0;
+	return pathCache.Get(pq, pathOut) ? 1 : 0;
 }
 
 void Pathfinding::PathCachePush(PathQuery* pq, Path* pqr)
 {
-	pathCache[pathCacheIdx].path = *pqr;
-	pathCache[pathCacheIdx].timeCached = timeGetTime();
-	memcpy(&pathCache[pathCacheIdx++], pq, sizeof(PathQuery));
-	
-
-	pathCacheCleared = 0;
-	if (pathCacheIdx >= PATH_RESULT_CACHE_SIZE)
-		pathCacheIdx = 0;
+	pathCache.Push(pq, pqr);
 }
 
 int Pathfinding::PathSumTime()
@@ -373,9 +588,7 @@ void Pathfinding::AStarSettingChanged()
 
 void Pathfinding::PathCacheInit()
 {
-	if (!pathCacheCleared)
-		memset(pathCache, 0, sizeof(pathCache));
-	pathCacheCleared = 1;
+	pathCache.Clear();
 }
 
 int Pathfinding::PathDestIsClear(PathQuery* pq, objHndl mover, LocAndOffsets destLoc)
@@ -1131,448 +1344,155 @@ void Pathfinding::PathNodesAddByDirections(Path* pqr, PathQuery* pq)
 
 int Pathfinding::FindPathShortDistanceAdjRadius(PathQuery* pq, Path* pqr)
 {
+	ShortPathSearch search;
+	search.adjRadius = true;
+	if (!BeginShortPath(pq, pqr, search))
+		return 0;
 
-#pragma region Preamble
-	const unsigned int gridSize = 160; // number of subtiles spanned in the grid (vanilla: 128)
-	int referenceTime = 0;
-	Subtile fromSubtile, toSubtile, _fromSubtile, shiftedSubtile;
+	AdjRadiusDestCheck destCheck = [pq, pqr](LocAndOffsets subPathFrom, LocAndOffsets subPathTo) {
+		return AdjRadiusDestIsClear(pq, pqr, subPathFrom, subPathTo);
+	};
+	auto directionsCount = SearchShortPath(pq, pqr, search.setup, &destCheck);
+	if (search.npcReferenceTime)
+		adjRadiusThrottle.timeCumulative += timeGetTime() - search.npcReferenceTime;
+	return directionsCount;
 
-	fromSubtile = fromSubtile.fromField(locSys.subtileFromLoc(&pqr->from));	toSubtile = toSubtile.fromField(locSys.subtileFromLoc(&pqr->to));
+	// return addresses.FindPathShortDistanceAdjRadius(pq, pqr);
+}
 
-	static int npcPathFindRefTime = 0;	static int npcPathFindAttemptCount = 0; 	static int npcPathTimeCumulative = 0;
+int Pathfinding::FindPathForcecdStraightLine(Path* pqr, PathQuery* pq)
+{
+	static int npcPathTimeRef = 0;
+	static int npcPathAttemps = 0;
+	static int npcPathCumulativeTime = 0;
 
-	if (pq->critter)
+	auto critter = pq->critter;
+	if (critter)
 	{
-		int attemptCount;
-		if (objects.GetType(pq->critter) == obj_t_npc)
+		// auto critterRadius = objects.GetRadius(pq->critter); //wtf? looks like they commented something out here
+		if (objects.GetType(critter) == obj_t_npc)
 		{
-			if (npcPathFindRefTime && (timeGetTime() - npcPathFindRefTime) < 1000)
+			if (npcPathTimeRef 
+				&& (timeGetTime() - npcPathTimeRef) < 1000)
 			{
-				attemptCount = npcPathFindAttemptCount;
-				if (npcPathFindAttemptCount > 10 || npcPathTimeCumulative > 250)
-				{
+				
+				if (npcPathAttemps > 10	|| npcPathCumulativeTime > 250)
 					return 0;
-				}
-			}
-			else
+				(npcPathAttemps)++;
+			} else
 			{
-				npcPathFindRefTime = timeGetTime();
-				attemptCount = 0;
-				npcPathTimeCumulative = 0;
+				npcPathAttemps = 1;
+				npcPathCumulativeTime = 0;
+				npcPathTimeRef = timeGetTime();
 			}
-			npcPathFindAttemptCount = attemptCount + 1;
-			referenceTime = timeGetTime();
 		}
 	}
+	return 0;
+}
 
-	int fromSubtileX = fromSubtile.x;	int fromSubtileY = fromSubtile.y;
-	int toSubtileX = toSubtile.x;	int toSubtileY = toSubtile.y;
-
-	int deltaSubtileX = abs(toSubtileX - fromSubtileX);	int deltaSubtileY = abs(toSubtileY - fromSubtileY);
-	if (deltaSubtileX > gridSize / 2 || deltaSubtileY > gridSize / 2)
-		return 0;
-
-	int lowerSubtileX = min(fromSubtileX, toSubtileX);	int lowerSubtileY = min(fromSubtileY, toSubtileY);
+int Pathfinding::FindPathSansNodes(PathQuery* pq, Path* pqr)
+{
+	auto pqFlags = pq->flags;
+	int result = 0;
+	if (!(pqFlags & PQF_DONT_USE_STRAIGHT_LINE) && FindPathSansNodesStraightLine(pq, pqr))
+	{
+		return pqr->nodeCount;
+	}
+	pqFlags = pq->flags;
 
-	int cornerX = lowerSubtileX + deltaSubtileX / 2 - gridSize / 2;	int cornerY = lowerSubtileY + deltaSubtileY / 2 - gridSize / 2;
+	if (!(pqFlags&PQF_STRAIGHT_LINE_ONLY_FOR_SANS_NODE)) {
+		if (pqFlags &PQF_100)
+			result = FindPathShortDistanceSansTarget(pq, pqr);
+		else if (pqFlags & PQF_ADJUST_RADIUS)
+			result = FindPathShortDistanceAdjRadius(pq, pqr);
+		else if (!(pqFlags & PQF_FORCED_STRAIGHT_LINE))
+		{
+				result = FindPathShortDistanceSansTarget(pq, pqr);
+		}
+			
+		else
+			result = FindPathForcecdStraightLine(pqr, pq); // does nothing - looks like some WIP
 
-	int curIdx = fromSubtileX - cornerX + ((fromSubtileY - cornerY) * gridSize);
-	int idxTarget = toSubtileX - cornerX + ((toSubtileY - cornerY) * gridSize);
+		SetShortPathDirections(pq, pqr, result);
+	}
+	return pqr->nodeCount;
+}
 
-	int idxTgtX = idxTarget % gridSize;
-	int idxTgtY = idxTarget / gridSize;
+bool Pathfinding::FindPathSansNodesStraightLine(PathQuery* pq, Path* pqr)
+{
+	auto result = FindPathStraightLine(pqr, pq);
+	pqr->nodeCount = 0;
+	pqr->nodeCount2 = 0;
+	pqr->nodeCount3 = 0;
+	if (!result)
+		return false;
 
-	struct PathSubtile
+	if (config.pathfindingDebugMode)
 	{
-		int length;
-		int refererIdx;
-		int idxPreviousChain; // is actually +1 (0 means none); i.e. subtract 1 to get the actual idx
-		int idxNextChain; // same as above
-	};
-	PathSubtile pathFindAstar[gridSize * gridSize];
-	memset(pathFindAstar, 0, sizeof(pathFindAstar));
+		logger->info("Straight line succeeded.");
+	}
+	PathNodesAddByDirections(pqr, pq);
+	return true;
+}
 
-	pathFindAstar[curIdx].length = 1;
-	pathFindAstar[curIdx].refererIdx = -1;
+void Pathfinding::SetShortPathDirections(PathQuery* pq, Path* pqr, int directionsCount)
+{
+	pqr->nodeCount = directionsCount;
+	pqr->nodeCount2 = directionsCount;
+	pqr->nodeCount3 = directionsCount;
+	if (directionsCount)
+		PathNodesAddByDirections(pqr, pq);
+}
 
+int Pathfinding::FindPath(PathQuery* pq, PathQueryResult* pqr)
+{
+	
+	int gotPath = 0;
 
-	int lastChainIdx = curIdx, firstChainIdx = curIdx;
-	int newIdx, shiftedXidx, shiftedYidx, deltaIdxX, distanceMetric, refererIdx, heuristic, idxPrevChain, idxNextChain;
-	int minHeuristic = 0x7FFFffff;
+	if (!FindPathPrepare(pq, pqr, gotPath))
+		return gotPath;
 
-	float requisiteClearance = objects.GetRadius(pq->critter);
-	float diagonalClearance = requisiteClearance * 0.7f; // diagonals need to be more restrictive to avoid jaggy paths
-	float requisiteClearanceCritters = requisiteClearance * 0.7f;
-	if (requisiteClearance > 12)
-		requisiteClearance *= 0.85f;
+	int refTime = timeGetTime();
+	bool useNodes = ShouldUsePathnodes(pqr, pq) != 0;
+	gotPath = FindPathSearch(pq, pqr, useNodes);
+	return FindPathFinish(pq, pqr, gotPath, useNodes, refTime);
 
-	if (curIdx == -1)
-	{
-		if (referenceTime)
-			npcPathTimeCumulative += timeGetTime() - referenceTime;
-		return 0;
-	}
+}
 
-	ProximityList proxList;
-	proxList.Populate(pq, pqr, INCH_PER_TILE * 40);
+bool Pathfinding::FindPathPrepare(PathQuery* pq, PathQueryResult* pqr, int& gotPath)
+{
+	gotPath = 0;
 
-	LocAndOffsets subPathFrom;
-	LocAndOffsets subPathTo;
-#pragma endregion
-	if (config.pathfindingDebugMode)
+	PathInit(pqr, pq);
+	if (config.pathfindingDebugMode || !combatSys.isCombatActive())
 	{
-		logger->info("*** START OF PF ATTEMPT ADJ RADIUS - DESTINATION {} ***", pqr->to);
+		
+		pdbgUsingNodes = false;
+		pdbgAbortedSansNodes = false;
+		pdbgNodeNum = 0;
+		pdbgGotPath = 0;
+		if (pq->critter)
+		{
+			pdbgMover = pq->critter;
+			logger->info("Starting path attempt for {}", pdbgMover);
+		}
+		pdbgFrom = pq->from;
+		if ((pq->flags & PQF_TARGET_OBJ) && pq->targetObj )
+		{
+			pdbgTargetObj = pq->targetObj;
+			pdbgTo = objects.GetLocationFull(pdbgTargetObj);
+		}
+			
+		else
+		{
+			pdbgTargetObj = 0i64;
+			pdbgTo = pqr->to;
+		}
 	}
-
-	while(1)
+	auto toSubtile = locSys.subtileFromLoc(&pqr->to);
+	if (locSys.subtileFromLoc(&pqr->from) == toSubtile || !GetAlternativeTargetLocation(pqr, pq))
 	{
-		curIdx = firstChainIdx;
-		refererIdx = -1;
-
-		do // loop over the Open Set chain to find the node with minimal valid heuristic; initially the chain is just the "from" node
-		{
-			deltaIdxX = abs((int)(curIdx % gridSize - idxTgtX));
-			distanceMetric = abs((int)(curIdx / gridSize - idxTgtY)); // deltaIdxY
-			if (deltaIdxX > distanceMetric)
-				distanceMetric = deltaIdxX;
-
-			heuristic = pathFindAstar[curIdx].length + 10 * distanceMetric;
-			if ((heuristic / 10) <= pq->maxShortPathFindLength)
-			{
-				if (refererIdx == -1 || heuristic < minHeuristic)
-				{
-					minHeuristic = pathFindAstar[curIdx].length + 10 * distanceMetric;
-					refererIdx = curIdx;
-				}
-				idxNextChain = pathFindAstar[curIdx].idxNextChain;
-			}
-			else
-			{	// node has exceeded max length, dump it
-				idxPrevChain = pathFindAstar[curIdx].idxPreviousChain;
-				pathFindAstar[curIdx].length = DontUseLength;
-				if (idxPrevChain)
-					pathFindAstar[idxPrevChain - 1].idxNextChain = pathFindAstar[curIdx].idxNextChain;
-				else
-					firstChainIdx = pathFindAstar[curIdx].idxNextChain - 1;
-				idxNextChain = pathFindAstar[curIdx].idxNextChain;
-				if (idxNextChain)
-					pathFindAstar[idxNextChain - 1].idxPreviousChain = pathFindAstar[curIdx].idxPreviousChain;
-				else
-					lastChainIdx = pathFindAstar[curIdx].idxPreviousChain - 1;
-				pathFindAstar[curIdx].idxPreviousChain = 0;
-				pathFindAstar[curIdx].idxNextChain = 0;
-			}
-			curIdx = idxNextChain - 1;
-		} while (curIdx >= 0);
-
-		if (refererIdx == -1) 
-		{ // none found, return 0
-			if (referenceTime)
-				npcPathTimeCumulative += timeGetTime() - referenceTime;
-			return 0;
-		}
-			
-		// Halt condition - within reach of the target
-		_fromSubtile.x = cornerX + (refererIdx % gridSize);
-		_fromSubtile.y = cornerY + (refererIdx / gridSize);
-
-		locSys.SubtileToLocAndOff(_fromSubtile, &subPathFrom);
-		locSys.SubtileToLocAndOff(toSubtile, &subPathTo);
-		float distToTgt = locSys.distBtwnLocAndOffs(subPathFrom, pqr->to);
-
-		if (distToTgt >= pq->distanceToTargetMin && distToTgt <= pq->tolRadius)
-		{
-			if (!(pq->flags & PQF_ADJ_RADIUS_REQUIRE_LOS) || PathAdjRadiusLosClear(pqr, pq, subPathFrom, subPathTo))
-			{
-				if ( pq->flags & (PQF_20 | PQF_10) || PathDestIsClear(pq, pqr->mover, subPathFrom ))
-				{
-					break;
-				}
-			}
-		}
-
-
-		/* 
-			find the best adjacent node
-		*/
-		_fromSubtile.x = cornerX + (refererIdx % gridSize);
-		_fromSubtile.y = cornerY + (refererIdx / gridSize);
-
-		// loop over all possible directions for better path
-		for (auto direction = 0; direction < 8; direction++)
-		{
-			if (!locSys.ShiftSubtileOnceByDirection(_fromSubtile, direction, &shiftedSubtile))
-				continue;
-			shiftedXidx = shiftedSubtile.x - cornerX;
-			shiftedYidx = shiftedSubtile.y - cornerY;
-			if (shiftedXidx >= 0 && shiftedXidx < gridSize && shiftedYidx >= 0 && shiftedYidx < gridSize)
-			{
-				newIdx = shiftedXidx + (shiftedYidx * gridSize);
-			}
-			else
-				continue;
-
-			if (pathFindAstar[newIdx].length == DontUseLength)
-				continue;
-
-			locSys.SubtileToLocAndOff(_fromSubtile, &subPathFrom);
-			locSys.SubtileToLocAndOff(shiftedSubtile, &subPathTo);
-			
-			int oldLength = pathFindAstar[newIdx].length;
-			int newLength = pathFindAstar[refererIdx].length + 14 - 4 * (direction % 2); // +14 for diagonal, +10 for straight
-
-			if (oldLength == 0 || abs(oldLength) > newLength)
-			{
-				// Check whether the shorter path would be valid
-				if (PathNodeSys::hasClearanceData)
-				{
-					SectorLoc secLoc(subPathTo.location);
-					//secLoc.GetFromLoc(subPathTo.location);
-					int secX = (int)secLoc.x(), secY = (int)secLoc.y();
-					int secClrIdx = PathNodeSys::clearanceData.clrIdx.clrAddr[secLoc.y()][secLoc.x()];
-					auto secBaseTile = secLoc.GetBaseTile();
-					int ssty = shiftedSubtile.y % 192;
-					int sstx = shiftedSubtile.x % 192;
-					if (direction % 2) // 
-					{
-						if (PathNodeSys::clearanceData.secClr[secClrIdx].val[shiftedSubtile.y % 192][shiftedSubtile.x % 192] < requisiteClearance)
-						{
-							/*if (config.pathfindingDebugMode)
-							{
-								logger->info("Pathfinding clearance too small:  {},  clearance value {}", subPathTo, PathNodeSys::clearanceData.secClr[secClrIdx].val[shiftedSubtile.y % 192][shiftedSubtile.x % 192]);
-							}*/
-							continue;
-						}
-
-					}
-					else
-					{
-						if (PathNodeSys::clearanceData.secClr[secClrIdx].val[shiftedSubtile.y % 192][shiftedSubtile.x % 192] < diagonalClearance)
-						{
-							/*if (config.pathfindingDebugMode)
-							{
-								logger->info("Pathfinding clearance too small:  {},  clearance value {}", subPathTo, PathNodeSys::clearanceData.secClr[secClrIdx].val[shiftedSubtile.y % 192][shiftedSubtile.x % 192]);
-							}*/
-							continue;
-						}
-					}
-
-					bool foundBlockers = false;
-
-					if (proxList.FindNear(subPathTo, requisiteClearanceCritters))
-						foundBlockers = true;
-
-					if (foundBlockers)
-						continue;
-
-				}
-				else if (!PathStraightLineIsClear(pqr, pq, subPathFrom, subPathTo))
-				{
-					continue;
-				}
-
-				pathFindAstar[newIdx].length = newLength;
-				pathFindAstar[newIdx].refererIdx = refererIdx;
-				if (!pathFindAstar[newIdx].idxPreviousChain && !pathFindAstar[newIdx].idxNextChain) //  if node is not part of chain
-				{
-					pathFindAstar[lastChainIdx].idxNextChain = newIdx + 1;
-					pathFindAstar[newIdx].idxPreviousChain = lastChainIdx + 1;
-					pathFindAstar[newIdx].idxNextChain = 0;
-					lastChainIdx = newIdx;
-				}
-
-			}
-
-		}
-
-
-		/*
-		remove the referer from the Open Set chain
-		and prepare the chain for looping it over again
-		*/
-		pathFindAstar[refererIdx].length = -pathFindAstar[refererIdx].length; 
-		// connect referer's previous to its next
-		idxPrevChain = pathFindAstar[refererIdx].idxPreviousChain - 1;
-		if (idxPrevChain != -1)
-		{
-			pathFindAstar[idxPrevChain].idxNextChain = pathFindAstar[refererIdx].idxNextChain;
-			curIdx = firstChainIdx;
-		}
-		else // if no "previous" exists, set the First Chain as the referer's next
-		{
-			firstChainIdx = curIdx = pathFindAstar[refererIdx].idxNextChain - 1;
-		}
-		//connect its next to its previous
-		if (pathFindAstar[refererIdx].idxNextChain)
-			pathFindAstar[pathFindAstar[refererIdx].idxNextChain - 1].idxPreviousChain
-			= pathFindAstar[refererIdx].idxPreviousChain;
-		else // if no "next" exists, set the last chain as its previous
-			lastChainIdx = pathFindAstar[refererIdx].idxPreviousChain - 1;
-		pathFindAstar[refererIdx].idxPreviousChain = 0;
-		pathFindAstar[refererIdx].idxNextChain = 0;
-		if (curIdx == -1)
-		{
-			if (referenceTime)
-				npcPathTimeCumulative += timeGetTime() - referenceTime;
-			if (config.pathfindingDebugMode) {
-				logger->info("*** END OF PF ATTEMPT ADJ RADIUS - A* OPTIONS EXHAUSTED ***");
-			}
-			return 0;
-		}
-
-	} //  major loop
-
-	// count the directions
-	auto refIdx = &pathFindAstar[refererIdx].refererIdx;
-	int directionsCount = 0;
-	while (*refIdx != -1)
-	{
-		directionsCount++;
-		refIdx = &pathFindAstar[*refIdx].refererIdx;
-	}
-
-
-	if (directionsCount > pq->maxShortPathFindLength)
-	{
-		if (referenceTime)
-			npcPathTimeCumulative += timeGetTime() - referenceTime;
-		return 0;
-	}
-
-	int lastIdx = refererIdx;
-	for (int i = directionsCount - 1; i >= 0; --i)
-	{
-		refIdx = &pathFindAstar[lastIdx].refererIdx;
-		pqr->directions[i] = GetDirection(*refIdx, gridSize, lastIdx);
-		lastIdx = *refIdx;
-	}
-	if (pq->flags & PQF_10)
-		--directionsCount;
-	if (referenceTime)
-		npcPathTimeCumulative += timeGetTime() - referenceTime;
-
-	// modify the destination to the found location
-	pqr->to = subPathFrom;
-	if (directionsCount == 0) // in case the destination is already within reach
-		pqr->to = pqr->from;
-
-	return directionsCount;
-
-	// return addresses.FindPathShortDistanceAdjRadius(pq, pqr);
-}
-
-int Pathfinding::FindPathForcecdStraightLine(Path* pqr, PathQuery* pq)
-{
-	static int npcPathTimeRef = 0;
-	static int npcPathAttemps = 0;
-	static int npcPathCumulativeTime = 0;
-
-	auto critter = pq->critter;
-	if (critter)
-	{
-		// auto critterRadius = objects.GetRadius(pq->critter); //wtf? looks like they commented something out here
-		if (objects.GetType(critter) == obj_t_npc)
-		{
-			if (npcPathTimeRef 
-				&& (timeGetTime() - npcPathTimeRef) < 1000)
-			{
-				
-				if (npcPathAttemps > 10	|| npcPathCumulativeTime > 250)
-					return 0;
-				(npcPathAttemps)++;
-			} else
-			{
-				npcPathAttemps = 1;
-				npcPathCumulativeTime = 0;
-				npcPathTimeRef = timeGetTime();
-			}
-		}
-	}
-	return 0;
-}
-
-int Pathfinding::FindPathSansNodes(PathQuery* pq, Path* pqr)
-{
-	auto pqFlags = pq->flags;
-	int result = 0;
-	if (!(pqFlags & PQF_DONT_USE_STRAIGHT_LINE))
-	{
-		result = FindPathStraightLine(pqr, pq);
-		pqr->nodeCount = 0;
-		pqr->nodeCount2 = 0;
-		pqr->nodeCount3 = 0;
-		if (result)
-		{
-			if (config.pathfindingDebugMode)
-			{
-				logger->info("Straight line succeeded.");
-			}
-			PathNodesAddByDirections(pqr, pq);
-			return pqr->nodeCount;
-		}
-	}
-	pqFlags = pq->flags;
-
-	if (!(pqFlags&PQF_STRAIGHT_LINE_ONLY_FOR_SANS_NODE)) {
-		if (pqFlags &PQF_100)
-			result = FindPathShortDistanceSansTarget(pq, pqr);
-		else if (pqFlags & PQF_ADJUST_RADIUS)
-			result = FindPathShortDistanceAdjRadius(pq, pqr);
-		else if (!(pqFlags & PQF_FORCED_STRAIGHT_LINE))
-		{
-				result = FindPathShortDistanceSansTarget(pq, pqr);
-		}
-			
-		else
-			result = FindPathForcecdStraightLine(pqr, pq); // does nothing - looks like some WIP
-
-		pqr->nodeCount = result;
-		pqr->nodeCount2 = result;
-		pqr->nodeCount3 = result;
-		if (result)
-			PathNodesAddByDirections(pqr, pq);
-		
-	}
-	return pqr->nodeCount;
-}
-
-int Pathfinding::FindPath(PathQuery* pq, PathQueryResult* pqr)
-{
-	
-	int gotPath = 0;
-	int triedPathNodes = 0;
-	int refTime;
-
-	PathInit(pqr, pq);
-	if (config.pathfindingDebugMode || !combatSys.isCombatActive())
-	{
-		
-		pdbgUsingNodes = false;
-		pdbgAbortedSansNodes = false;
-		pdbgNodeNum = 0;
-		pdbgGotPath = 0;
-		if (pq->critter)
-		{
-			pdbgMover = pq->critter;
-			logger->info("Starting path attempt for {}", pdbgMover);
-		}
-		pdbgFrom = pq->from;
-		if ((pq->flags & PQF_TARGET_OBJ) && pq->targetObj )
-		{
-			pdbgTargetObj = pq->targetObj;
-			pdbgTo = objects.GetLocationFull(pdbgTargetObj);
-		}
-			
-		else
-		{
-			pdbgTargetObj = 0i64;
-			pdbgTo = pqr->to;
-		}
-	}
-	auto toSubtile = locSys.subtileFromLoc(&pqr->to);
-	if (locSys.subtileFromLoc(&pqr->from) == toSubtile || !GetAlternativeTargetLocation(pqr, pq))
-	{
-		if (config.pathfindingDebugMode || !combatSys.isCombatActive())
+		if (config.pathfindingDebugMode || !combatSys.isCombatActive())
 		{
 			if (locSys.subtileFromLoc(&pqr->from) == toSubtile)
 				logger->info("Pathfinding: Aborting because from = to.");
@@ -1580,14 +1500,14 @@ int Pathfinding::FindPath(PathQuery* pq, PathQueryResult* pqr)
 				logger->info("Pathfinding: Aborting because target tile is occupied and cannot find alternative tile.");
 		}
 		pdbgGotPath = 0;
-		return 0;
+		return false;
 	}
 		
 
 	if (TargetSurrounded(pqr, pq))
 	{
 		logger->info("Pathfinding: Aborting because target is surrounded.");
-		return 0;
+		return false;
 	}
 
 	//if (!config.pathfindingDebugModeFlushCache )
@@ -1595,7 +1515,8 @@ int Pathfinding::FindPath(PathQuery* pq, PathQueryResult* pqr)
 		// has this query been done before? if so copies it and returns the result
 		if (config.pathfindingDebugMode || !combatSys.isCombatActive())
 			logger->info("Query found in cache, fetching result.");
-			return pqr->nodeCount;
+		gotPath = pqr->nodeCount;
+		return false;
 	}
 		
 
@@ -1603,18 +1524,21 @@ int Pathfinding::FindPath(PathQuery* pq, PathQueryResult* pqr)
 	{
 		logger->info("Astar timed out, aborting.");
 		pqr->flags |= PF_TIMED_OUT;
-		return 0;
+		return false;
 	}
 
+	return true;
+}
 
-	refTime = timeGetTime();
-	if (ShouldUsePathnodes(pqr, pq))
+int Pathfinding::FindPathSearch(PathQuery* pq, PathQueryResult* pqr, bool useNodes)
+{
+	int gotPath;
+	if (useNodes)
 	{
 		if (config.pathfindingDebugMode || !combatSys.isCombatActive())
 		{
 			logger->info("Attempting using nodes...");
 		}
-		triedPathNodes = 1;
 		gotPath = FindPathUsingNodes(pq, pqr);
 		if ( config.pathfindingDebugMode || !combatSys.isCombatActive()){
 			logger->info("Nodes attempt result: {}..." , gotPath);
@@ -1628,7 +1552,11 @@ int Pathfinding::FindPath(PathQuery* pq, PathQueryResult* pqr)
 		}
 		gotPath = FindPathSansNodes(pq, pqr);
 	}
-		
+	return gotPath;
+}
+
+int Pathfinding::FindPathFinish(PathQuery* pq, PathQueryResult* pqr, int gotPath, bool triedPathNodes, int refTime)
+{
 	if (!gotPath)
 	{
 		if (!(pq->flags & PQF_DONT_USE_PATHNODES)  && !triedPathNodes)
@@ -1639,10 +1567,6 @@ int Pathfinding::FindPath(PathQuery* pq, PathQueryResult* pqr)
 				logger->info("Failed Sans Nodes attempt... trying nodes.");
 			}
 			gotPath = FindPathUsingNodes(pq, pqr);
-			if (!gotPath)
-			{
-				int dummy = 1;
-			}
 		}
 	}
 
@@ -1670,17 +1594,128 @@ int Pathfinding::FindPath(PathQuery* pq, PathQueryResult* pqr)
 		pdbgTo = pqr->to;
 	}
 	return gotPath;
-
 }
 
-bool Pathfinding::CanPathTo(objHndl obj, objHndl target, PathQueryFlags flags, float maxDistanceFeet){
-	auto from = objects.GetLocationFull(obj);
-	
-	auto partyMember = target;
-	PathQueryResult path;
-	memset(&path, 0, sizeof(PathQueryResult));
-	PathQuery pathQ;
-	pathQ.from = from;
+void Pathfinding::FindPaths(std::vector<PathJob>& jobs)
+{
+	// Without clearance data the searches need raycasts all the way; debug mode needs the diagnostics of each search
+	if (!PathNodeSys::hasClearanceData || config.pathfindingDebugMode)
+	{
+		for (auto& job : jobs)
+			job.gotPath = FindPath(&job.query, &job.result);
+		return;
+	}
+
+	struct DeferredSearch
+	{
+		PathJob* job;
+		int timeSpent; // before the search, in ms
+		int searchTime;
+		int directionsCount;
+		ShortPathSearch search;
+	};
+
+	// The searches run in waves of one per thread, and each wave is only prepared once the one before is finished.
+	// That way the time limits (PQF_A_STAR_TIME_CAPPED and NpcPathThrottle) include the searches done so far.
+	auto waveSize = (size_t)std::max(1u, std::thread::hardware_concurrency());
+	std::vector<DeferredSearch> deferred;
+	deferred.reserve(waveSize);
+
+	size_t nextJob = 0;
+	while (nextJob < jobs.size())
+	{
+		deferred.clear();
+
+		// Everything up to the short distance searches is done here, as in FindPath
+		for (; nextJob < jobs.size() && deferred.size() < waveSize; ++nextJob)
+		{
+			auto& job = jobs[nextJob];
+			auto pq = &job.query;
+			auto pqr = &job.result;
+			if (!FindPathPrepare(pq, pqr, job.gotPath))
+				continue;
+
+			int refTime = timeGetTime();
+			bool useNodes = ShouldUsePathnodes(pqr, pq) != 0;
+			auto flags = pq->flags;
+			if (useNodes || (flags & PQF_STRAIGHT_LINE_ONLY_FOR_SANS_NODE)
+				|| (!(flags & (PQF_100 | PQF_ADJUST_RADIUS)) && (flags & PQF_FORCED_STRAIGHT_LINE)))
+			{
+				job.gotPath = FindPathFinish(pq, pqr, FindPathSearch(pq, pqr, useNodes), useNodes, refTime);
+				continue;
+			}
+
+			if (!combatSys.isCombatActive())
+			{
+				logger->info("Attempting sans nodes...");
+			}
+			if (!(flags & PQF_DONT_USE_STRAIGHT_LINE) && FindPathSansNodesStraightLine(pq, pqr))
+			{
+				job.gotPath = FindPathFinish(pq, pqr, pqr->nodeCount, false, refTime);
+				continue;
+			}
+
+			deferred.emplace_back();
+			auto& item = deferred.back();
+			item.job = &job;
+			item.search.adjRadius = !(flags & PQF_100) && (flags & PQF_ADJUST_RADIUS);
+			if (!BeginShortPath(pq, pqr, item.search))
+			{
+				deferred.pop_back();
+				SetShortPathDirections(pq, pqr, 0);
+				job.gotPath = FindPathFinish(pq, pqr, pqr->nodeCount, false, refTime);
+				continue;
+			}
+			item.timeSpent = timeGetTime() - refTime;
+		}
+
+		if (deferred.empty())
+			continue;
+
+		// The searches themselves only read the clearance data and the critters gathered above, so they can run on worker threads
+		auto threadCount = deferred.size();
+		MainThreadDestChecks destChecks((int)threadCount);
+		std::atomic<int> nextSearch{ 0 };
+
+		auto runSearches = [&]() {
+			for (int i = nextSearch++; i < (int)deferred.size(); i = nextSearch++) {
+				auto& item = deferred[i];
+				auto pq = &item.job->query;
+				auto pqr = &item.job->result;
+				AdjRadiusDestCheck destCheck = [&destChecks, pq, pqr](LocAndOffsets subPathFrom, LocAndOffsets subPathTo) {
+					return destChecks.Check(pq, pqr, subPathFrom, subPathTo);
+				};
+
+				int startTime = timeGetTime();
+				item.directionsCount = SearchShortPath(pq, pqr, item.search.setup, item.search.adjRadius ? &destCheck : nullptr);
+				item.searchTime = timeGetTime() - startTime;
+			}
+			destChecks.WorkerDone();
+		};
+
+		shortPathWorkers.Start(threadCount, runSearches);
+		destChecks.Serve();
+		shortPathWorkers.Wait();
+
+		// and the rest is done in order again, so the cache and the time limits are updated as in FindPath
+		for (auto& item : deferred)
+		{
+			auto pq = &item.job->query;
+			auto pqr = &item.job->result;
+			int refTime = timeGetTime() - item.timeSpent - item.searchTime;
+			if (item.search.npcReferenceTime)
+				item.search.Throttle().timeCumulative += item.searchTime;
+
+			SetShortPathDirections(pq, pqr, item.directionsCount);
+			item.job->gotPath = FindPathFinish(pq, pqr, pqr->nodeCount, false, refTime);
+		}
+	}
+}
+
+// The query CanPathTo makes for getting within reach of the target
+static void InitCanPathToQuery(objHndl obj, objHndl target, PathQueryFlags flags, PathQuery& pathQ)
+{
+	pathQ.from = objects.GetLocationFull(obj);
 	pathQ.flags = flags;
 	auto reach = critterSys.GetReach(obj, D20A_UNSPECIFIED_ATTACK);
 	pathQ.tolRadius = reach * 12.0f - ( INCH_PER_SUBTILE / 2 + 8.0f);
@@ -1689,7 +1724,13 @@ bool Pathfinding::CanPathTo(objHndl obj, objHndl target, PathQueryFlags flags, f
 		logger->info("PF attempt to party member: {}", target);
 	pathQ.critter = obj;
 	pathQ.distanceToTargetMin = reach;
-	
+}
+
+bool Pathfinding::CanPathTo(objHndl obj, objHndl target, PathQueryFlags flags, float maxDistanceFeet){
+	PathQueryResult path;
+	memset(&path, 0, sizeof(PathQueryResult));
+	PathQuery pathQ;
+	InitCanPathToQuery(obj, target, flags, pathQ);
 
 	if (!FindPath(&pathQ, &path)){
 		return false;
@@ -1705,11 +1746,30 @@ bool Pathfinding::CanPathTo(objHndl obj, objHndl target, PathQueryFlags flags, f
 	return true;
 }
 
+void Pathfinding::CanPathTo(objHndl obj, const std::vector<objHndl>& targets, std::vector<bool>& canPathOut, PathQueryFlags flags, float maxDistanceFeet)
+{
+	std::vector<PathJob> jobs(targets.size());
+	for (size_t i = 0; i < targets.size(); i++) {
+		InitCanPathToQuery(obj, targets[i], flags, jobs[i].query);
+	}
+
+	FindPaths(jobs);
+
+	canPathOut.resize(targets.size());
+	for (size_t i = 0; i < jobs.size(); i++) {
+		auto canPath = jobs[i].gotPath != 0;
+		if (canPath && maxDistanceFeet > 0 && jobs[i].result.GetPathResultLength() > maxDistanceFeet)
+			canPath = false;
+		canPathOut[i] = canPath;
+	}
+}
+
 objHndl Pathfinding::CanPathToParty(objHndl obj, bool excludeUnconscious)
 {
 	if (party.IsInParty(obj))
 		return objHndl::null;
-	auto from = objects.GetLocationFull(obj);
+
+	// one after the other, since each search counts towards the NPC's pathfinding limits (see NpcPathThrottle)
 	int partySize = party.GroupListGetLen();
 	for (int i = 0; i < partySize; i++){
 
@@ -2082,359 +2142,291 @@ int Pathfinding::FindPathShortDistanceSansTargetLegacy(PathQuery* pq, Path* pqr)
 
 int Pathfinding::FindPathShortDistanceSansTarget(PathQuery* pq, Path* pqr)
 {
-	// uses a form of A*
-	// pathfinding heuristic:
-	// taxicab metric h(dx,dy)=max(dx, dy), wwhere  dx,dy is the subtile difference
-	#pragma region Preamble
-	const unsigned int gridSize = 160; // number of subtiles spanned in the grid (vanilla: 128)
-	int referenceTime = 0;
-	Subtile fromSubtile, toSubtile, _fromSubtile, shiftedSubtile;
+	ShortPathSearch search;
+	search.adjRadius = false;
+	if (!BeginShortPath(pq, pqr, search))
+		return 0;
 
-	fromSubtile = fromSubtile.fromField(locSys.subtileFromLoc(&pqr->from));	toSubtile = toSubtile.fromField(locSys.subtileFromLoc(&pqr->to));
+	auto directionsCount = SearchShortPath(pq, pqr, search.setup, nullptr);
+	if (search.npcReferenceTime)
+		sansTargetThrottle.timeCumulative += timeGetTime() - search.npcReferenceTime;
+	return directionsCount;
+}
 
-	static int npcPathFindRefTime = 0;	static int npcPathFindAttemptCount = 0; 	static int npcPathTimeCumulative = 0;
+bool Pathfinding::BeginShortPath(PathQuery* pq, Path* pqr, ShortPathSearch& search)
+{
+	if (search.adjRadius)
+	{
+		if (!adjRadiusThrottle.Begin(pq->critter, 10, search.npcReferenceTime))
+			return false;
+		return PrepareShortPath(pq, pqr, search.setup);
+	}
 
-	if (pq->critter)
+	// limits the number of attempts to 10 per second (50 with clearance data) and the cumulative time to 250 ms
+	int maxAttempts = 10 + (40 * (pathNodeSys.hasClearanceData == true));
+	if (!sansTargetThrottle.Begin(pq->critter, maxAttempts, search.npcReferenceTime))
 	{
-		int attemptCount;
-		if (objects.GetType(pq->critter) == obj_t_npc)
+		if (config.pathfindingDebugMode)
 		{
-			if (npcPathFindRefTime && (timeGetTime() - npcPathFindRefTime) < 1000  ) // && !pathNodeSys.hasClearanceData limits the number of attempt to 10 per second and cumulative time to 250 sec
+			pdbgDirectionsCount = 0;
+			if (sansTargetThrottle.attemptCount > maxAttempts)
 			{
-				attemptCount = npcPathFindAttemptCount;
-				if ( (npcPathFindAttemptCount > 10 + (40 * (pathNodeSys.hasClearanceData == true))  ) || npcPathTimeCumulative > 250)
-				{
-					if (config.pathfindingDebugMode)
-					{
-						pdbgDirectionsCount = 0;
-						if (npcPathFindAttemptCount > 10 + (40 * (pathNodeSys.hasClearanceData == true)))
-						{
-							logger->info("NPC pathing attempt count exceeded, aborting.");
-							pdbgShortRangeError = -(10 + (40 * (pathNodeSys.hasClearanceData == true)));
-						}
-						else
-				{
-							pdbgShortRangeError = -250;
-							logger->info("NPC pathing cumulative time exceeded, aborting.");
-						}
-							
-					}
-					return 0;
-				}
+				logger->info("NPC pathing attempt count exceeded, aborting.");
+				pdbgShortRangeError = -maxAttempts;
 			}
 			else
 			{
-				npcPathFindRefTime = timeGetTime();
-				attemptCount = 0;
-				npcPathTimeCumulative = 0;
+				pdbgShortRangeError = -250;
+				logger->info("NPC pathing cumulative time exceeded, aborting.");
 			}
-			npcPathFindAttemptCount = attemptCount + 1;
-			referenceTime = timeGetTime();
 		}
+		return false;
 	}
 
-	int fromSubtileX = fromSubtile.x;	int fromSubtileY = fromSubtile.y;
-	int toSubtileX = toSubtile.x;	int toSubtileY = toSubtile.y;
+	if (shortPathRecording && shortPathRecorded.size() < ShortPathRecordingCap)
+	{
+		shortPathRecorded.push_back({ *pq, pqr->from, pqr->to, pqr->mover, pqr->flags });
+	}
 
-	int deltaSubtileX = abs(toSubtileX - fromSubtileX);	int deltaSubtileY = abs(toSubtileY - fromSubtileY);
-	if (deltaSubtileX > gridSize/2 || deltaSubtileY > gridSize/2)
+	if (!PrepareShortPath(pq, pqr, search.setup))
 	{
 		pdbgDirectionsCount = 0;
-		pdbgShortRangeError = gridSize;
+		pdbgShortRangeError = ShortPathWorkspace::GridSize;
 		logger->info("Desitnation too far for short distance PF grid! Aborting.");
-		return 0;
+		return false;
 	}
-		
-	
-	int lowerSubtileX = min(fromSubtileX, toSubtileX);	int lowerSubtileY = min(fromSubtileY, toSubtileY);
-
-	int cornerX = lowerSubtileX + deltaSubtileX / 2 - gridSize/2;	int cornerY = lowerSubtileY + deltaSubtileY / 2 - gridSize/2;
-
-
-	//TileRect tileR;
-	//tileR.x1 = lowerSubtileX/3 - 64; tileR.y1 = lowerSubtileY / 3 - 64;
-	//tileR.x2 = tileR.x1 + 128; tileR.y2 = tileR.y1 + 128;
-	//Subtile blockedSubtiles[129*129];
-	//int count;
-	//sectorSys.GetTileFlagsArea(&tileR, blockedSubtiles, &count);
-
-	int curIdx = fromSubtileX - cornerX + ((fromSubtileY - cornerY) * gridSize);
-	int idxTarget = toSubtileX - cornerX + ((toSubtileY - cornerY) * gridSize);
+	return true;
+}
 
-	int idxTgtX = idxTarget % gridSize;
-	int idxTgtY = idxTarget / gridSize;
+bool Pathfinding::PrepareShortPath(PathQuery* pq, Path* pqr, ShortPathSetup& setup)
+{
+	const int gridSize = ShortPathWorkspace::GridSize;
+	Subtile fromSubtile, toSubtile;
 
-	struct PathSubtile
-	{
-		int length;
-		int refererIdx;
-		int idxPreviousChain; // is actually +1 (0 means none); i.e. subtract 1 to get the actual idx
-		int idxNextChain; // same as above
-	};
-	PathSubtile pathFindAstar[gridSize * gridSize];
-	memset(pathFindAstar, 0, sizeof(pathFindAstar));
+	fromSubtile = fromSubtile.fromField(locSys.subtileFromLoc(&pqr->from));	toSubtile = toSubtile.fromField(locSys.subtileFromLoc(&pqr->to));
 
-	pathFindAstar[curIdx].length = 1;
-	pathFindAstar[curIdx].refererIdx = -1;
+	int fromSubtileX = fromSubtile.x;	int fromSubtileY = fromSubtile.y;
+	int toSubtileX = toSubtile.x;	int toSubtileY = toSubtile.y;
 
+	int deltaSubtileX = abs(toSubtileX - fromSubtileX);	int deltaSubtileY = abs(toSubtileY - fromSubtileY);
+	if (deltaSubtileX > gridSize/2 || deltaSubtileY > gridSize/2)
+		return false;
 
-	int lastChainIdx = curIdx;
-	int firstChainIdx = curIdx;
-	int deltaIdxX;
-	int distanceMetric;
+	int lowerSubtileX = min(fromSubtileX, toSubtileX);	int lowerSubtileY = min(fromSubtileY, toSubtileY);
 
-	int refererIdx, heuristic;
-	int minHeuristic = 0x7FFFffff;
-	int idxPrevChain, idxNextChain;
+	setup.cornerX = lowerSubtileX + deltaSubtileX / 2 - gridSize/2;	setup.cornerY = lowerSubtileY + deltaSubtileY / 2 - gridSize/2;
 
-	int shiftedXidx, shiftedYidx, newIdx;
+	setup.idxFrom = fromSubtileX - setup.cornerX + ((fromSubtileY - setup.cornerY) * gridSize);
+	setup.idxTarget = toSubtileX - setup.cornerX + ((toSubtileY - setup.cornerY) * gridSize);
+	setup.toSubtile = toSubtile;
 
 	float requisiteClearance = 1.0f;
 	if (pq->critter)
 		requisiteClearance = objects.GetRadius(pq->critter);
-	float diagonalClearance = requisiteClearance * 0.7f;
-	float requisiteClearanceCritters = requisiteClearance * 0.7f;
+	setup.diagonalClearance = requisiteClearance * 0.7f; // diagonals need to be more restrictive to avoid jaggy paths
+	setup.requisiteClearanceCritters = requisiteClearance * 0.7f;
 	if (requisiteClearance > 12)
 		requisiteClearance *= 0.85f;
+	setup.requisiteClearance = requisiteClearance;
 
+	setup.proxList.count = 0;
+	setup.proxList.Populate(pq, pqr, INCH_PER_TILE * 40);
+	return true;
+}
 
+int Pathfinding::SearchShortPath(PathQuery* pq, Path* pqr, ShortPathSetup& setup, const AdjRadiusDestCheck* adjRadiusDestCheck)
+{
+	// uses a form of A*
+	// pathfinding heuristic:
+	// taxicab metric h(dx,dy)=max(dx, dy), wwhere  dx,dy is the subtile difference
+	#pragma region Preamble
+	const int gridSize = ShortPathWorkspace::GridSize;
+	Subtile _fromSubtile, shiftedSubtile;
 
+	int idxTgtX = setup.idxTarget % gridSize;
+	int idxTgtY = setup.idxTarget / gridSize;
 
-	if (curIdx == -1)
-	{
-		if (referenceTime)
-			npcPathTimeCumulative += timeGetTime() - referenceTime;
-		if (config.pathfindingDebugMode)
-		{
-			pdbgDirectionsCount = 0;
-			pdbgShortRangeError = -1;
-			logger->info("curIdx is -1, aborting.");
-		}
-		return 0;
-	}
-
+	auto estimateLength = [&](int idx, int length) {
+		int distanceMetric = max(abs(idx % gridSize - idxTgtX), abs(idx / gridSize - idxTgtY));
+		return length + 10 * distanceMetric;
+	};
 
+	auto& ws = shortPathWorkspace;
+	ws.BeginQuery();
+
+	// The clearance of a subtile doesn't depend on where it is entered from, so it's checked once per query and subtile
+	auto getClearanceFlags = [&](int idx, Subtile subtile) -> uint8_t {
+		auto& cell = ws.cells[idx];
+		if (cell.flags & ShortPathWorkspace::CF_CLEARANCE_CHECKED)
+			return cell.flags;
+		cell.flags |= ShortPathWorkspace::CF_CLEARANCE_CHECKED;
+
+		LocAndOffsets subPathTo;
+		locSys.SubtileToLocAndOff(subtile, &subPathTo);
+		SectorLoc secLoc(subPathTo.location);
+		int secClrIdx = PathNodeSys::clearanceData.clrIdx.clrAddr[secLoc.y()][secLoc.x()];
+		if (secClrIdx == 0xFFFF) // no clearance data for the sector
+			return cell.flags;
+		auto clearance = PathNodeSys::clearanceData.secClr[secClrIdx].val[subtile.y % 192][subtile.x % 192];
+		if (clearance < setup.diagonalClearance && clearance < setup.requisiteClearance)
+			return cell.flags;
+		if (setup.proxList.FindNear(subPathTo, setup.requisiteClearanceCritters))
+			return cell.flags;
+
+		if (clearance >= setup.requisiteClearance)
+			cell.flags |= ShortPathWorkspace::CF_STRAIGHT_CLEAR;
+		if (clearance >= setup.diagonalClearance)
+			cell.flags |= ShortPathWorkspace::CF_DIAGONAL_CLEAR;
+		return cell.flags;
+	};
 
-	struct ProximityList proxList;
-	proxList.Populate(pq, pqr, INCH_PER_TILE * 40);
+	// adjusted radius searches check the line of sight from their destination to the target's subtile
+	LocAndOffsets targetCenter;
+	if (adjRadiusDestCheck)
+		locSys.SubtileToLocAndOff(setup.toSubtile, &targetCenter);
 
 #pragma endregion
 	if (config.pathfindingDebugMode)
 	{
-		logger->info("*** START OF PF ATTEMPT SANS TARGET - DESTINATION {} ***", pqr->to);
-		pdbgDirectionsCount = 0;
-		pdbgShortRangeError = 0;
-	}
-	while (1)
-	{
-		refererIdx = -1;
-		do // loop over the chain to find the node with minimal heuristic; initially the chain is just the "from" node
+		if (adjRadiusDestCheck)
 		{
-			deltaIdxX = abs((int) (curIdx % gridSize - idxTgtX));
-			distanceMetric = abs( (int) (curIdx / gridSize - idxTgtY));
-			if (deltaIdxX > distanceMetric)
-				distanceMetric = deltaIdxX;
+			logger->info("*** START OF PF ATTEMPT ADJ RADIUS - DESTINATION {} ***", pqr->to);
+		}
+		else
+		{
+			logger->info("*** START OF PF ATTEMPT SANS TARGET - DESTINATION {} ***", pqr->to);
+			pdbgDirectionsCount = 0;
+			pdbgShortRangeError = 0;
+		}
+	}
 
-			heuristic = pathFindAstar[curIdx].length + 10 * distanceMetric;
-			if ((heuristic / 10) <= pq->maxShortPathFindLength)
-			{
-				if (refererIdx == -1 || heuristic < minHeuristic)
-				{
-					minHeuristic = pathFindAstar[curIdx].length + 10 * distanceMetric;
-					refererIdx = curIdx;
-				}
-				idxNextChain = pathFindAstar[curIdx].idxNextChain;
-			}
-			else
-			{
-				idxPrevChain = pathFindAstar[curIdx].idxPreviousChain;
-				pathFindAstar[curIdx].length = DontUseLength;
-				if (idxPrevChain)
-					pathFindAstar[idxPrevChain - 1].idxNextChain = pathFindAstar[curIdx].idxNextChain;
-				else
-					firstChainIdx = pathFindAstar[curIdx].idxNextChain - 1;
-				idxNextChain = pathFindAstar[curIdx].idxNextChain;
-				if (idxNextChain)
-					pathFindAstar[idxNextChain - 1].idxPreviousChain = pathFindAstar[curIdx].idxPreviousChain;
-				else
-					lastChainIdx = pathFindAstar[curIdx].idxPreviousChain - 1;
-				pathFindAstar[curIdx].idxPreviousChain = 0;
-				pathFindAstar[curIdx].idxNextChain = 0;
-			}
-			curIdx = idxNextChain - 1;
-		} while (curIdx >= 0);
+	auto& fromCell = ws.Get(setup.idxFrom);
+	fromCell.length = 1;
+	fromCell.refererIdx = -1;
+	auto fromEstimate = estimateLength(setup.idxFrom, 1);
+	if (fromEstimate / 10 <= pq->maxShortPathFindLength)
+		ws.Push(setup.idxFrom, fromEstimate, false);
+	else
+		fromCell.length = DontUseLength;
 
+	int refererIdx;
+	LocAndOffsets subPathFrom;
+	while (1)
+	{
+		refererIdx = ws.PopMin();
 		if (refererIdx == -1)
 		{
-			if (referenceTime)
-				npcPathTimeCumulative += timeGetTime() - referenceTime;
 			if (config.pathfindingDebugMode) {
-				pdbgShortRangeError = -999;
-				logger->info("*** END OF PF ATTEMPT SANS TARGET - OPEN SET EMPTY; from {} to {} ***", pqr->from, pqr->to);
+				if (adjRadiusDestCheck) {
+					logger->info("*** END OF PF ATTEMPT ADJ RADIUS - A* OPTIONS EXHAUSTED ***");
+				} else {
+					pdbgShortRangeError = -999;
+					logger->info("*** END OF PF ATTEMPT SANS TARGET - OPEN SET EMPTY; from {} to {} ***", pqr->from, pqr->to);
+				}
 			}
 			return 0;
 		}
-		
+
+		_fromSubtile.x = setup.cornerX + (refererIdx % gridSize);
+		_fromSubtile.y = setup.cornerY + (refererIdx / gridSize);
+		if (adjRadiusDestCheck || !PathNodeSys::hasClearanceData)
+			locSys.SubtileToLocAndOff(_fromSubtile, &subPathFrom);
+
 		// halt condition
-		if (refererIdx == idxTarget) break;
-		
-		_fromSubtile.x = cornerX + (refererIdx % gridSize);
-		_fromSubtile.y = cornerY + (refererIdx / gridSize);
+		if (!adjRadiusDestCheck)
+		{
+			if (refererIdx == setup.idxTarget) break;
+		}
+		else
+		{
+			// within reach of the target
+			float distToTgt = locSys.distBtwnLocAndOffs(subPathFrom, pqr->to);
+			if (distToTgt >= pq->distanceToTargetMin && distToTgt <= pq->tolRadius
+				&& (*adjRadiusDestCheck)(subPathFrom, targetCenter))
+				break;
+		}
+
+		auto refererLength = ws.cells[refererIdx].length;
 
 		// loop over all possible directions for better path
 		for (auto direction = 0; direction < 8; direction++)
 		{
 			if (!locSys.ShiftSubtileOnceByDirection(_fromSubtile, direction, &shiftedSubtile))
 				continue;
-			shiftedXidx = shiftedSubtile.x - cornerX;
-			shiftedYidx = shiftedSubtile.y - cornerY;
-			if (shiftedXidx >= 0 && shiftedXidx < gridSize && shiftedYidx >= 0 && shiftedYidx < gridSize)
-			{
-				newIdx = shiftedXidx + (shiftedYidx * gridSize);
-			}
-			else
+			int shiftedXidx = shiftedSubtile.x - setup.cornerX;
+			int shiftedYidx = shiftedSubtile.y - setup.cornerY;
+			if (shiftedXidx < 0 || shiftedXidx >= gridSize || shiftedYidx < 0 || shiftedYidx >= gridSize)
 				continue;
+			int newIdx = shiftedXidx + (shiftedYidx * gridSize);
 
-			if (pathFindAstar[newIdx].length == DontUseLength)
+			auto& newCell = ws.Get(newIdx);
+			int oldLength = newCell.length;
+			if (oldLength == DontUseLength)
 				continue;
 
-			LocAndOffsets subPathFrom;
-			LocAndOffsets subPathTo;
-			locSys.SubtileToLocAndOff(_fromSubtile, &subPathFrom);
-			locSys.SubtileToLocAndOff(shiftedSubtile, &subPathTo);
-			
-			int oldLength = pathFindAstar[newIdx].length;
-			int newLength = pathFindAstar[refererIdx].length + 14 - 4 * (direction % 2); // +14 for diagonal, +10 for straight
+			int newLength = refererLength + 14 - 4 * (direction % 2); // +14 for diagonal, +10 for straight
+			if (oldLength != 0 && abs(oldLength) <= newLength)
+				continue;
 
-			if (oldLength == 0 || abs(oldLength) > newLength)
+			// Check whether the shorter path would be valid.
+			if (PathNodeSys::hasClearanceData)
 			{
-				// Check whether the shorter path would be valid.
-				if (PathNodeSys::hasClearanceData)
-				{
-					SectorLoc secLoc(subPathTo.location);
-					//secLoc.GetFromLoc(subPathTo.location);
-					int secX = (int)secLoc.x(), secY = (int)secLoc.y();
-					int secClrIdx = PathNodeSys::clearanceData.clrIdx.clrAddr[secLoc.y()][secLoc.x()];
-					auto secBaseTile = secLoc.GetBaseTile();
-					int ssty = shiftedSubtile.y % 192;
-					int sstx = shiftedSubtile.x % 192;
-					if (direction % 2) // xy straight
-					{
-						if (PathNodeSys::clearanceData.secClr[secClrIdx].val[ssty][sstx] < requisiteClearance){
-							//if (config.pathfindingDebugMode)
-							//{
-							//	//logger->info("Pathfinding clearance too small:  {},  clearance value {}", subPathTo, PathNodeSys::clearanceData.secClr[secClrIdx].val[shiftedSubtile.y % 192][shiftedSubtile.x % 192]);
-							//}
-							continue;
-						}
-					}
-					else // xy diagonal
-					{
-						if (PathNodeSys::clearanceData.secClr[secClrIdx].val[ssty][sstx] < diagonalClearance)
-						{
-							/*if (config.pathfindingDebugMode)
-							{
-								logger->info("Pathfinding clearance too small:  {},  clearance value {}", subPathTo, PathNodeSys::clearanceData.secClr[secClrIdx].val[shiftedSubtile.y % 192][shiftedSubtile.x % 192]);
-							}*/
-							continue;
-						}
-					}
-
-
-
-					bool foundBlockers = false;
-
-					if (proxList.FindNear(subPathTo, requisiteClearanceCritters))
-						foundBlockers = true;
-
-					if (foundBlockers)
-						continue;
-
-				}
-				else if (!PathStraightLineIsClear(pqr, pq, subPathFrom, subPathTo))
-				{
+				auto clearFlag = (direction % 2) ? ShortPathWorkspace::CF_STRAIGHT_CLEAR : ShortPathWorkspace::CF_DIAGONAL_CLEAR;
+				if (!(getClearanceFlags(newIdx, shiftedSubtile) & clearFlag))
+					continue;
+			}
+			else
+			{
+				LocAndOffsets subPathTo;
+				locSys.SubtileToLocAndOff(shiftedSubtile, &subPathTo);
+				if (!PathStraightLineIsClear(pqr, pq, subPathFrom, subPathTo))
 					continue;
-				}
-
-				pathFindAstar[newIdx].length = newLength;
-				pathFindAstar[newIdx].refererIdx = refererIdx;
-				if (!pathFindAstar[newIdx].idxPreviousChain && !pathFindAstar[newIdx].idxNextChain) //  if node is not part of chain
-				{
-					pathFindAstar[lastChainIdx].idxNextChain = newIdx + 1;
-					pathFindAstar[newIdx].idxPreviousChain = lastChainIdx + 1;
-					pathFindAstar[newIdx].idxNextChain = 0;
-					lastChainIdx = newIdx;
-				}
-
 			}
 
-		}
-
-		pathFindAstar[refererIdx].length = -pathFindAstar[refererIdx].length; // mark the referer as used
-		// remove the referer from the chain
-		// connect its previous to its next
-		idxPrevChain = pathFindAstar[refererIdx].idxPreviousChain - 1;
-		if (idxPrevChain != -1)
-		{
-			pathFindAstar[idxPrevChain].idxNextChain = pathFindAstar[refererIdx].idxNextChain;
-			curIdx = firstChainIdx;
-		}
-		else // if no "previous" exists, set the First Chain as the referer's next
-		{
-			curIdx = pathFindAstar[refererIdx].idxNextChain - 1;
-			firstChainIdx = curIdx;
-		}
-		//connect its next to its previous
-		if (pathFindAstar[refererIdx].idxNextChain)
-			pathFindAstar[pathFindAstar[refererIdx].idxNextChain - 1].idxPreviousChain
-			= pathFindAstar[refererIdx].idxPreviousChain;
-		else // if no "next" exists, set the last chain as its previous
-			lastChainIdx = pathFindAstar[refererIdx].idxPreviousChain - 1;
-		pathFindAstar[refererIdx].idxPreviousChain = 0;
-		pathFindAstar[refererIdx].idxNextChain = 0;
-		if (curIdx == -1)
-		{
-			if (referenceTime)
-				npcPathTimeCumulative += timeGetTime() - referenceTime;
-			if (config.pathfindingDebugMode){
-				logger->info("*** END OF PF ATTEMPT SANS TARGET - A* OPTIONS EXHAUSTED; from {} to {} ***", pqr->from, pqr->to);
+			newCell.length = newLength;
+			newCell.refererIdx = refererIdx;
+			auto newEstimate = estimateLength(newIdx, newLength);
+			if (newEstimate / 10 > pq->maxShortPathFindLength)
+			{
+				newCell.length = DontUseLength;
+				continue;
 			}
-			return 0;
+			ws.Push(newIdx, newEstimate, oldLength > 0);
 		}
-		idxTgtX = idxTarget % gridSize;
+
+		ws.cells[refererIdx].length = -refererLength; // mark the referer as used
 	}
 
 
 	// count the directions
-	auto refIdx = &pathFindAstar[refererIdx].refererIdx;
 	int directionsCount = 0;
-	while (*refIdx != -1)
+	for (auto refIdx = ws.cells[refererIdx].refererIdx; refIdx != -1; refIdx = ws.cells[refIdx].refererIdx)
 	{
 		directionsCount++;
-		refIdx = &pathFindAstar[*refIdx].refererIdx;
 	}
 
-
 	if (directionsCount > pq->maxShortPathFindLength)
 	{
-		if (referenceTime)
-			npcPathTimeCumulative += timeGetTime() - referenceTime;
 		return 0;
 	}
-	int lastIdx = idxTarget;
-	refIdx = &pathFindAstar[lastIdx].refererIdx;
+	int lastIdx = refererIdx;
 	for (int i = directionsCount - 1; i >= 0; --i)
 	{
-		refIdx = &pathFindAstar[lastIdx].refererIdx;
-		pqr->directions[i] = GetDirection(*refIdx, gridSize, lastIdx);
-		lastIdx = *refIdx;
+		auto refIdx = ws.cells[lastIdx].refererIdx;
+		pqr->directions[i] = GetDirection(refIdx, gridSize, lastIdx);
+		lastIdx = refIdx;
 	}
 	if (pq->flags & PQF_10)
 		--directionsCount;
-	if (referenceTime)
-		npcPathTimeCumulative += timeGetTime() - referenceTime;
 
-	if (config.pathfindingDebugMode)
+	if (adjRadiusDestCheck)
+	{
+		// modify the destination to the found location
+		pqr->to = subPathFrom;
+		if (directionsCount == 0) // in case the destination is already within reach
+			pqr->to = pqr->from;
+	}
+	else if (config.pathfindingDebugMode)
 	{
 		logger->info("*** END OF PF ATTEMPT SANS TARGET - {} DIRECTIONS USED ***", directionsCount);
 		pdbgDirectionsCount = directionsCount;
@@ -2445,6 +2437,36 @@ int Pathfinding::FindPathShortDistanceSansTarget(PathQuery* pq, Path* pqr)
 	return directionsCount;
 }
 
+void Pathfinding::SetShortPathRecording(bool enable)
+{
+	if (enable)
+		shortPathRecorded.clear();
+	shortPathRecording = enable;
+}
+
+int Pathfinding::ReplayShortPathQueries(int iterations, int64_t& elapsedUs)
+{
+	int pathsFound = 0;
+	Path path;
+	Stopwatch sw;
+	for (int i = 0; i < iterations; i++)
+	{
+		for (auto& query : shortPathRecorded)
+		{
+			auto pq = query.pq;
+			path.flags = query.flags;
+			path.from = query.from;
+			path.to = query.to;
+			path.mover = query.mover;
+			ShortPathSetup setup;
+			if (PrepareShortPath(&pq, &path, setup) && SearchShortPath(&pq, &path, setup, nullptr) > 0)
+				pathsFound++;
+		}
+	}
+	elapsedUs = sw.GetElapsedUs();
+	return pathsFound;
+}
+
 int Pathfinding::GetPartialPath(Path* path, Path* pathTrunc, float startDistFeet, float endDistFeet)
 {
 	return addresses.GetPartialPath(path, pathTrunc, startDistFeet, endDistFeet);
@@ -1,12 +1,14 @@
 #pragma once
 
+#include <functional>
 #include <optional>
+#include <vector>
 
 #include <temple/dll.h>
 #include "temple_functions.h"
+#include "path_cache.h"
 
 #define PQR_CACHE_SIZE  0x20 // cache used for storing paths for specific action sequences
-#define PATH_RESULT_CACHE_SIZE 0x28 // different from the above, used for storing past results to minimize PF time
 
 #pragma region structs
 
@@ -15,6 +17,8 @@ class PathNodeSys;
 struct MapPathNode;
 struct MapPathNodeList;
 struct ProximityList;
+struct ShortPathSetup;
+struct ShortPathSearch;
 
 enum PathQueryFlags : uint32_t {
 	/*
@@ -149,13 +153,6 @@ struct PathQueryResult : Path {
 	}
 };
 
-struct PathResultCache : PathQuery
-{
-	Path path;
-	uint32_t timeCached =0;
-};
-
-
 const uint32_t TestSizeofPathQueryResult = sizeof(PathQueryResult); // should be 6688 (0x1A20)
 
 #pragma pack(pop)
@@ -167,9 +164,7 @@ struct Pathfinding : temple::AddressTable {
 	LocationSys * loc;
 	PathNodeSys * pathNode;
 
-	PathResultCache pathCache[PATH_RESULT_CACHE_SIZE]; // used as a ring buffer
-	int pathCacheIdx;
-	int pathCacheCleared;
+	PathCache pathCache;
 	
 	int aStarMaxTimeMs;
 	int aStarMaxWindowMs;
@@ -222,9 +217,26 @@ struct Pathfinding : temple::AddressTable {
 	bool TargetSurrounded(Path* pqr, PathQuery* pq);
 
 	int FindPath(PathQuery* pq, PathQueryResult* result);
-	
 
-	bool CanPathTo(objHndl handle, objHndl target, PathQueryFlags flags = static_cast<PathQueryFlags>(PQF_HAS_CRITTER | PQF_TO_EXACT | PQF_800 | PQF_ADJ_RADIUS_REQUIRE_LOS | PQF_ADJUST_RADIUS | PQF_TARGET_OBJ), float maxDistance = -1);
+	struct PathJob
+	{
+		PathQuery query;
+		PathQueryResult result;
+		int gotPath = 0; // what FindPath returned
+	};
+	/*
+		Runs FindPath for each of the jobs, with the short distance searches on worker threads. Use this when
+		checking several paths at once (e.g. the AI looking for a target), rather than calling FindPath for each.
+		The searches run in waves of one per thread: the critters and clearance data of a wave are gathered once the
+		wave before is done, so the time limits apply as in FindPath, and the raycasts that remain are done on this
+		thread. Falls back to FindPath one after the other without clearance data or in debug mode.
+	*/
+	void FindPaths(std::vector<PathJob>& jobs);
+
+	static constexpr PathQueryFlags CanPathToFlags = static_cast<PathQueryFlags>(PQF_HAS_CRITTER | PQF_TO_EXACT | PQF_800 | PQF_ADJ_RADIUS_REQUIRE_LOS | PQF_ADJUST_RADIUS | PQF_TARGET_OBJ);
+	bool CanPathTo(objHndl handle, objHndl target, PathQueryFlags flags = CanPathToFlags, float maxDistance = -1);
+	// Checks all of the targets at once (see FindPaths); canPathOut[i] is the result for targets[i]
+	void CanPathTo(objHndl handle, const std::vector<objHndl>& targets, std::vector<bool>& canPathOut, PathQueryFlags flags = CanPathToFlags, float maxDistance = -1);
 	objHndl CanPathToParty(objHndl objHnd, bool excludeUnconscious = true);
 	BOOL PathStraightLineIsClear(Path* pqr, PathQuery* pq, LocAndOffsets subPathFrom, LocAndOffsets subPathTo); // including static obstacles it seems
 	BOOL PathAdjRadiusLosClear(Path* pqr, PathQuery* pq, LocAndOffsets subPathFrom, LocAndOffsets subPathTo);
@@ -232,6 +244,15 @@ struct Pathfinding : temple::AddressTable {
 	int FindPathShortDistanceSansTargetLegacy(PathQuery * pq, Path* pqr);
 	int FindPathShortDistanceSansTarget(PathQuery * pq, Path* pqr);
 
+	/*
+		While enabled, the queries handled by FindPathShortDistanceSansTarget are recorded, so they can be
+		replayed later on to benchmark the grid search (see debug.pf_record and debug.pf_replay).
+		Replaying them requires the map they were recorded on.
+	*/
+	void SetShortPathRecording(bool enable);
+	// Runs the recorded queries iterations times without the NPC time limits; returns the number of paths found
+	int ReplayShortPathQueries(int iterations, int64_t& elapsedUs);
+
 	/*
 		gets a partial path (based on path) starting from startDistFeet to endDistFeet and writes it to pathTrunc
 	*/
@@ -255,6 +276,44 @@ protected:
 	int FindPathShortDistanceAdjRadius(PathQuery* pq, Path* pqr);
 	int FindPathForcecdStraightLine(Path* pqr, PathQuery* pq);
 	int FindPathSansNodes(PathQuery* pq, Path* pqr);
+	bool FindPathSansNodesStraightLine(PathQuery* pq, Path* pqr);
+	void SetShortPathDirections(PathQuery* pq, Path* pqr, int directionsCount);
+
+	// The parts of FindPath before and after the search; FindPathPrepare returns false if the query is done already
+	bool FindPathPrepare(PathQuery* pq, PathQueryResult* pqr, int& gotPath);
+	int FindPathSearch(PathQuery* pq, PathQueryResult* pqr, bool useNodes);
+	int FindPathFinish(PathQuery* pq, PathQueryResult* pqr, int gotPath, bool triedPathNodes, int refTime);
+
+	/*
+		The short distance searches of FindPathSansNodes are split up so FindPaths can run SearchShortPath
+		on worker threads: BeginShortPath applies the NPC limits and calls PrepareShortPath, which gathers
+		what the search needs on the main thread. Both return false if there's nothing to search.
+	*/
+	bool BeginShortPath(PathQuery* pq, Path* pqr, ShortPathSearch& search);
+	bool PrepareShortPath(PathQuery* pq, Path* pqr, ShortPathSetup& setup);
+	/*
+		Checks whether an adjusted radius search can stop at subPathFrom, which is within range of the target.
+		Gets the center of the target's subtile as subPathTo.
+	*/
+	using AdjRadiusDestCheck = std::function<bool(LocAndOffsets subPathFrom, LocAndOffsets subPathTo)>;
+	/*
+		The A* search of FindPathShortDistanceSansTarget, or of FindPathShortDistanceAdjRadius if adjRadiusDestCheck
+		is given (which then also changes pqr->to to the subtile it stopped at). Only touches the game state through
+		adjRadiusDestCheck if there is clearance data.
+	*/
+	int SearchShortPath(PathQuery* pq, Path* pqr, ShortPathSetup& setup, const AdjRadiusDestCheck* adjRadiusDestCheck);
+
+	struct RecordedShortPathQuery
+	{
+		PathQuery pq;
+		LocAndOffsets from;
+		LocAndOffsets to;
+		objHndl mover;
+		int flags;
+	};
+	static constexpr size_t ShortPathRecordingCap = 4096;
+	bool shortPathRecording = false;
+	std::vector<RecordedShortPathQuery> shortPathRecorded;
 
 	void(__cdecl *ToEEpathDistBtwnToAndFrom)(Path *path); // outputs to FPU (st0);  apparently distance in feet (since it divides by 12)
 } ;
@@ -10,6 +10,7 @@
 #include <pathfinding.h>
 #include <gamesystems/map/sector.h>
 #include <location.h>
+#include "../tio/tio.h"
 
 static std::string GetNiceName(void* ptr) {
 	
@@ -246,10 +247,20 @@ PyObject *PyDebug_ReciprocityDebug()
 	return PyLong_FromLongLong(1);
 }
 
-PyObject *PyDebug_GenerateClearanceFile()
+/*
+ regenerates clearance.bin for the current map, optionally into the given folder (e.g. "maps\\<map name>");
+ returns the number of sectors that were recomputed, or -1 on failure
+*/
+PyObject *PyDebug_GenerateClearanceFile(PyObject*, PyObject* args)
 {
-	pathNodeSys.GenerateClearanceFile();
-	return PyLong_FromLongLong(1);
+	char* saveDir = nullptr;
+	if (!PyArg_ParseTuple(args, "|s:genclearance", &saveDir)) {
+		return 0;
+	}
+	if (saveDir && saveDir[0]) {
+		tio_mkdir(saveDir);
+	}
+	return PyLong_FromLong(pathNodeSys.GenerateClearanceFile(saveDir));
 }
 
 /*
@@ -331,6 +342,34 @@ PyObject *PyDebug_PathTo(PyObject*, PyObject* args)
 	return PyLong_FromLongLong(result);
 }
 
+/*
+ starts (pf_record(1)) or stops (pf_record(0)) recording the short distance pathfinding queries
+*/
+PyObject *PyDebug_RecordPathQueries(PyObject*, PyObject* args)
+{
+	int enable = 1;
+	if (!PyArg_ParseTuple(args, "|i:pf_record", &enable)) {
+		return 0;
+	}
+	pathfindingSys.SetShortPathRecording(enable != 0);
+	return PyInt_FromLong(enable != 0);
+}
+
+/*
+ replays the recorded short distance pathfinding queries; returns (paths found, elapsed microseconds)
+*/
+PyObject *PyDebug_ReplayPathQueries(PyObject*, PyObject* args)
+{
+	int iterations = 1;
+	if (!PyArg_ParseTuple(args, "|i:pf_replay", &iterations)) {
+		return 0;
+	}
+	int64_t elapsedUs = 0;
+	auto pathsFound = pathfindingSys.ReplayShortPathQueries(iterations, elapsedUs);
+	logger->info("Replayed short distance path queries {} times: {} paths found in {} us", iterations, pathsFound, elapsedUs);
+	return Py_BuildValue("(iL)", pathsFound, elapsedUs);
+}
+
 static void PyDebug_Crash() {
 	*(reinterpret_cast<int*>(0)) = 1;
 }
@@ -358,6 +397,8 @@ static PyMethodDef PyDebug_Methods[] = {
 	{ "genclr", (PyCFunction)PyDebug_GenerateClearanceFile, METH_VARARGS, NULL },
 	{ "getclr", (PyCFunction)PyDebug_GetLocClearance, METH_VARARGS, NULL },
 	{ "pathto", (PyCFunction)PyDebug_PathTo, METH_VARARGS, NULL },
+	{ "pf_record", (PyCFunction)PyDebug_RecordPathQueries, METH_VARARGS, NULL },
+	{ "pf_replay", (PyCFunction)PyDebug_ReplayPathQueries, METH_VARARGS, NULL },
 	{ "breakp", (PyCFunction)PyDebug_BreakP, METH_VARARGS, NULL },
 	{ NULL, }
 };
@@ -346,7 +346,7 @@ PyObject* PyGame_Fade(PyObject*, PyObject* args) {
 
 	if (timeToAdvance > 0) {
 		auto time = GameTime::FromSeconds(timeToAdvance);
-		gameSystems->GetTimeEvent().GameTimeAdd(time);
+		gameSystems->GetTimeEvent().FastForward(time);
 	}
 
 	if (movieId) {
@@ -1125,7 +1125,7 @@ PyObject* PyGame_GametimeAdd(PyObject*, PyObject* args) {
 		return 0;
 	}
 
-	gameSystems->GetTimeEvent().AddTime(timeInMs);
+	gameSystems->GetTimeEvent().SkipTime(timeInMs);
 	auto time = gameSystems->GetTimeEvent().GetTime();
 	auto formattedTime = gameSystems->GetTimeEvent().FormatTime(time);
 	return PyString_FromString(formattedTime.c_str());
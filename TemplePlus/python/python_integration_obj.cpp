@@ -85,7 +85,7 @@ static void PcStart(objHndl pc) {
 	}
 
 	try {
-		auto content(MesFile::ParseFile("rules\\start_equipment.mes"));
+		auto content(MesFile::ParseFileToTable("rules\\start_equipment.mes"));
 		
 		auto key = classIndex;
 
@@ -95,9 +95,9 @@ static void PcStart(objHndl pc) {
 			key += 100;
 		}
 
-		auto it = content.find(key);
-		if (it != content.end()) {
-			auto protoIds = split(it->second, ' ', true);
+		auto line = content.Find(key);
+		if (line) {
+			auto protoIds = split(std::string(line), ' ', true);
 			for (auto protoIdStr : protoIds) {
 				auto protoId = stoi(protoIdStr);
 				auto protoHandle = objSystem->GetProtoHandle(protoId);
@@ -7,6 +7,8 @@
 
 #include <debugui.h>
 
+#include <infrastructure/mesparser.h>
+
 #include <temple/dll.h>
 #include <temple/vfs.h>
 #include <temple/soundsystem.h>
@@ -26,6 +28,7 @@
 #include "../gameview.h"
 
 #include "../config/config.h"
+#include "../util/folderutils.h"
 #include <fstream>
 #include <mod_support.h>
 #include <winsock.h>
@@ -98,6 +101,9 @@ TigInitializer::TigInitializer(HINSTANCE hInstance)
 	tio_path_add(".");
 	LoadDataFiles();
 
+	// Parsed .mes files are cached in the user's data folder to speed up subsequent starts
+	MesFile::SetCacheDir(ucs2_to_local(GetUserDataFolder()) + "MesCache");
+
 	// No longer used: mStartedSystems.emplace_back(StartSystem("memory.c", 0x101E04F0, 0x101E0510));
 	// No longer used: mStartedSystems.emplace_back(StartSystem("debug.c", 0x101E4DE0, TigShutdownNoop));
 	mMainWindow = std::make_unique<MainWindow>(hInstance);
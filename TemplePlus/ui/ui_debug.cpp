@@ -16,6 +16,8 @@
 #include <animgoals/anim.h>
 #include <animgoals/anim_slot.h>
 #include <gamesystems/objects/objsystem.h>
+#include <gamesystems/timeevents.h>
+#include <gamesystems/map/sector.h>
 
 static bool debugUiVisible = false;
 
@@ -161,6 +163,8 @@ static void DrawWidgetTreeNode(int widgetId) {
 }
 
 static void DrawAnimSlots();
+static void DrawTimeEventStats();
+static void DrawSectorCacheStats();
 
 void UIRenderDebug()
 {
@@ -203,6 +207,14 @@ void UIRenderDebug()
 		ImGui::Checkbox("Draw Cylinder Hitboxes", &config.drawObjCylinders);
 	}
 
+	if (ImGui::CollapsingHeader("Time Events")) {
+		DrawTimeEventStats();
+	}
+
+	if (ImGui::CollapsingHeader("Sector Cache")) {
+		DrawSectorCacheStats();
+	}
+
 	if (messageQueue)
 	if (ImGui::CollapsingHeader("Message Debugging")) {
 		static bool debugMsgs;
@@ -254,4 +266,35 @@ void DrawAnimSlots()
 		}
 	}
 	
-}
\ No newline at end of file
+}
+
+void DrawTimeEventStats()
+{
+	auto& timeEvents = gameSystems->GetTimeEvent();
+	if (ImGui::Button("Reset")) {
+		timeEvents.ResetTypeStats();
+	}
+	for (auto i = 0; i < (int)TimeEventType::TimeEventSystemCount; ++i) {
+		auto type = (TimeEventType)i;
+		auto& stats = timeEvents.GetTypeStats(type);
+		if (!stats.expiredCount) {
+			continue;
+		}
+		ImGui::BulletText(fmt::format("{}: {} expired, {:.2f} ms in callbacks", GetTimeEventTypeName(type), stats.expiredCount, stats.callbackTimeUs / 1000.0).c_str());
+	}
+}
+
+void DrawSectorCacheStats()
+{
+	if (ImGui::Button("Reset##SectorCache")) {
+		MapSectorSystem::ResetCacheStats();
+	}
+	auto& stats = MapSectorSystem::GetCacheStats();
+	auto hitCount = stats.lockCount > stats.loadCount ? stats.lockCount - stats.loadCount : 0;
+	auto hitRate = stats.lockCount ? 100.0 * hitCount / stats.lockCount : 100.0;
+	ImGui::BulletText(fmt::format("{} locks, {:.1f}% hit rate", stats.lockCount, hitRate).c_str());
+	auto avgLoadMs = stats.loadCount ? stats.loadTimeUs / 1000.0 / stats.loadCount : 0.0;
+	ImGui::BulletText(fmt::format("{} loads on demand, {:.2f} ms avg, {:.2f} ms max", stats.loadCount, avgLoadMs, stats.maxLoadTimeUs / 1000.0).c_str());
+	auto avgPrefetchMs = stats.prefetchCount ? stats.prefetchTimeUs / 1000.0 / stats.prefetchCount : 0.0;
+	ImGui::BulletText(fmt::format("{} prefetched, {:.2f} ms avg", stats.prefetchCount, avgPrefetchMs).c_str());
+}
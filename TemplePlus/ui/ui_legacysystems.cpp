@@ -13,6 +13,7 @@
 #include "fade.h"
 #include "gamesystems/gamesystems.h"
 #include "gamesystems/mapsystem.h"
+#include "gamesystems/timeevents.h"
 #include "legacyscriptsystem.h"
 #include "tutorial.h"
 #include "gamesystems/random_encounter.h"
@@ -1097,8 +1098,7 @@ BOOL UiCamping::Camp(int hoursToRest){
 
 		while (restedCount < hoursToRest){
 			
-			auto addTime = temple::GetRef<void(__cdecl)(unsigned int)>(0x10062390);
-			addTime(HOUR_IN_MS);
+			gameSystems->GetTimeEvent().SkipTime(HOUR_IN_MS);
 			RandomEncounterSetup randEncSetup;
 			RandomEncounter *randEncOut;
 			if (GetSleepStatus() == 1){
@@ -0,0 +1,166 @@
+#include "stdafx.h"
+
+#include <array>
+#include <random>
+#include <vector>
+
+#include <infrastructure/bitops.h>
+#include <infrastructure/stopwatch.h>
+
+static uint32_t PopCountSlow(uint32_t value) {
+	uint32_t count = 0;
+	while (value != 0) {
+		count += value & 1;
+		value >>= 1;
+	}
+	return count;
+}
+
+/**
+ * The 16-bit lookup table rank ArrayIndexBitmaps used before switching to BitOps.
+ * Kept here as the baseline.
+ */
+class LutRank {
+public:
+	LutRank() {
+		uint32_t bitmask = 0;
+		mPartialBitmasks[0] = bitmask;
+		for (auto i = 1; i < 32; ++i) {
+			bitmask = (bitmask << 1) | 1;
+			mPartialBitmasks[i] = bitmask;
+		}
+		for (size_t i = 0; i <= UINT16_MAX; ++i) {
+			mBitCountLut[i] = (uint8_t) PopCountSlow((uint32_t) i);
+		}
+	}
+
+	uint32_t PopCnt(uint32_t value) const {
+		return mBitCountLut[value & UINT16_MAX] + mBitCountLut[value >> 16];
+	}
+
+	uint32_t PopCntConstrained(uint32_t value, uint32_t upToExclusive) const {
+		return PopCnt(value & mPartialBitmasks[upToExclusive]);
+	}
+
+	// Rank of index in the bitmap, counting block by block like the old GetPackedIndex did
+	uint32_t Rank(const std::vector<uint32_t> &blocks, size_t index) const {
+		auto blockIdx = index / 32;
+		uint32_t count = 0;
+		for (size_t i = 0; i < blockIdx; ++i) {
+			count += PopCnt(blocks[i]);
+		}
+		return count + PopCntConstrained(blocks[blockIdx], index % 32);
+	}
+
+private:
+	std::array<uint32_t, 32> mPartialBitmasks;
+	std::array<uint8_t, UINT16_MAX + 1> mBitCountLut;
+};
+
+TEST(BitOpsBenchmark, RankAgainstLut) {
+	// Sparse bitmaps the size of a large inventory or spell list
+	constexpr size_t BlockCount = 8;
+	constexpr size_t Queries = 4000000;
+
+	std::mt19937 rng(5678);
+	std::vector<uint32_t> blocks(BlockCount);
+	for (auto &block : blocks) {
+		block = rng() & rng();
+	}
+
+	// Cumulative ranks, like ArrayIndexBitmaps keeps per block
+	std::vector<uint32_t> ranks(BlockCount);
+	uint32_t rank = 0;
+	for (size_t i = 0; i < BlockCount; ++i) {
+		ranks[i] = rank;
+		rank += BitOps::PopCount(blocks[i]);
+	}
+
+	std::vector<uint32_t> indices(1024);
+	for (auto &index : indices) {
+		index = rng() % (BlockCount * 32);
+	}
+
+	LutRank lut;
+	uint64_t lutSum = 0;
+	Stopwatch lutSw;
+	for (size_t i = 0; i < Queries; ++i) {
+		lutSum += lut.Rank(blocks, indices[i % indices.size()]);
+	}
+	auto lutUs = lutSw.GetElapsedUs();
+
+	uint64_t rankSum = 0;
+	Stopwatch rankSw;
+	for (size_t i = 0; i < Queries; ++i) {
+		auto index = indices[i % indices.size()];
+		auto blockIdx = index / 32;
+		rankSum += ranks[blockIdx] + BitOps::PopCountBelow(blocks[blockIdx], index % 32);
+	}
+	auto rankUs = rankSw.GetElapsedUs();
+
+	ASSERT_EQ(lutSum, rankSum);
+
+	printf("Rank of %zu queries: LUT %lld us, BitOps (hw popcnt: %s) %lld us\n",
+		Queries, (long long) lutUs, BitOps::HasHardwarePopCount() ? "yes" : "no", (long long) rankUs);
+}
+
+TEST(BitOpsBenchmark, PropertyRankAgainstBlockWalk) {
+	// Shaped like the property bitmap of a critter: 14 blocks, about a third of the fields set.
+	// GameObjectBody used to count the blocks before a field's block on every access;
+	// now it keeps a rank per block and adjusts it when a field is added or removed.
+	constexpr size_t BlockCount = 14;
+	constexpr size_t Queries = 4000000;
+	constexpr size_t QueriesPerChange = 1000;
+
+	std::mt19937 rng(4321);
+	std::vector<uint32_t> blocks(BlockCount);
+	for (auto &block : blocks) {
+		block = (rng() & rng()) | (rng() & rng());
+	}
+
+	std::vector<uint32_t> indices(1024);
+	for (auto &index : indices) {
+		index = rng() % (BlockCount * 32);
+	}
+
+	auto walkBlocks = blocks;
+	uint64_t walkSum = 0;
+	Stopwatch walkSw;
+	for (size_t i = 0; i < Queries; ++i) {
+		auto index = indices[i % indices.size()];
+		if (i % QueriesPerChange == 0) {
+			walkBlocks[index / 32] ^= 1u << (index % 32);
+		}
+		auto blockIdx = index / 32;
+		uint32_t count = 0;
+		for (size_t j = 0; j < blockIdx; ++j) {
+			count += BitOps::PopCount(walkBlocks[j]);
+		}
+		walkSum += count + BitOps::PopCountBelow(walkBlocks[blockIdx], index % 32);
+	}
+	auto walkUs = walkSw.GetElapsedUs();
+
+	auto rankBlocks = blocks;
+	std::vector<uint32_t> ranks(BlockCount);
+	BitmapRanks::Build(rankBlocks.data(), ranks.data(), BlockCount);
+
+	uint64_t rankSum = 0;
+	Stopwatch rankSw;
+	for (size_t i = 0; i < Queries; ++i) {
+		auto index = indices[i % indices.size()];
+		auto blockIdx = index / 32;
+		if (i % QueriesPerChange == 0) {
+			auto mask = 1u << (index % 32);
+			int delta = (rankBlocks[blockIdx] & mask) ? -1 : 1;
+			rankBlocks[blockIdx] ^= mask;
+			BitmapRanks::Adjust(ranks.data(), BlockCount, blockIdx, delta);
+		}
+		rankSum += BitmapRanks::Rank(rankBlocks.data(), ranks.data(), blockIdx, index % 32);
+	}
+	auto rankUs = rankSw.GetElapsedUs();
+
+	ASSERT_EQ(walkSum, rankSum);
+
+	printf("Property index of %zu queries: block walk %lld us, block ranks %lld us\n",
+		Queries, (long long) walkUs, (long long) rankUs);
+}
@@ -0,0 +1,26 @@
+#include "stdafx.h"
+#include <windows.h>
+
+#include <filesystem>
+using namespace std::filesystem;
+
+// The benchmarks read game data relative to the repository root
+static void ChangeToRootDirectory() {
+	path p = current_path();
+
+	while (p.has_parent_path()) {
+		if (exists(p / "TemplePlus.sln")) {
+			current_path(p);
+			return;
+		}
+
+		p = p.parent_path();
+	}
+}
+
+int main(int argc, char **argv)
+{
+	ChangeToRootDirectory();
+	::testing::InitGoogleTest(&argc, argv);
+	return RUN_ALL_TESTS();
+}
@@ -0,0 +1,100 @@
+#include "stdafx.h"
+
+#include <infrastructure/mesparser.h>
+#include <infrastructure/vfs.h>
+#include <infrastructure/stringutil.h>
+#include <infrastructure/stopwatch.h>
+
+#include <filesystem>
+
+TEST(MesFileBenchmark, DataFiles)
+{
+	vfs.reset(Vfs::CreateStdIoVfs());
+
+	std::vector<std::string> filenames;
+	std::vector<std::string> contents;
+	for (auto dir : { "tpdata", "tpdatasrc" }) {
+		if (!std::filesystem::exists(dir)) {
+			continue;
+		}
+		for (auto &entry : std::filesystem::recursive_directory_iterator(dir)) {
+			if (entry.is_regular_file() && tolower(entry.path().extension().string()) == ".mes") {
+				filenames.push_back(entry.path().string());
+				contents.push_back(vfs->ReadAsString(filenames.back()));
+			}
+		}
+	}
+	if (contents.empty()) {
+		return;
+	}
+
+	// Parsing text that is already in memory
+	size_t mapEntries = 0;
+	Stopwatch mapSw;
+	for (auto &content : contents) {
+		mapEntries += MesFile::ParseString(content).size();
+	}
+	auto mapUs = mapSw.GetElapsedUs();
+
+	std::vector<MesTable> tables;
+	Stopwatch tableSw;
+	for (auto &content : contents) {
+		tables.push_back(MesFile::ParseStringToTable(content));
+	}
+	auto tableUs = tableSw.GetElapsedUs();
+
+	std::vector<std::vector<uint8_t>> cached;
+	for (size_t i = 0; i < tables.size(); ++i) {
+		cached.push_back(tables[i].Serialize(i + 1));
+	}
+
+	size_t tableEntries = 0, tableBytes = 0;
+	Stopwatch cacheSw;
+	for (size_t i = 0; i < cached.size(); ++i) {
+		MesTable table;
+		ASSERT_TRUE(MesTable::Deserialize(cached[i], i + 1, table));
+		tableEntries += table.size();
+		tableBytes += table.GetMemoryUsage();
+	}
+	auto cacheUs = cacheSw.GetElapsedUs();
+
+	ASSERT_EQ(mapEntries, tableEntries);
+
+	printf("Parsing %zu .mes files with %zu entries: map %lld us, table %lld us, from cache %lld us (%zu KB)\n",
+		contents.size(), tableEntries, (long long) mapUs, (long long) tableUs, (long long) cacheUs, tableBytes / 1024);
+
+	// Loading the files, like the game does. ParseFile reads and parses every time, while
+	// ParseFileToTable fills the cache on the first start and skips both on a warm start.
+	size_t fileEntries = 0;
+	Stopwatch fileSw;
+	for (auto &filename : filenames) {
+		fileEntries += MesFile::ParseFile(filename).size();
+	}
+	auto fileUs = fileSw.GetElapsedUs();
+
+	auto cacheDir = (std::filesystem::temp_directory_path() / "TemplePlusMesCache").string();
+	std::filesystem::remove_all(cacheDir);
+	MesFile::SetCacheDir(cacheDir);
+
+	Stopwatch firstSw;
+	for (auto &filename : filenames) {
+		MesFile::ParseFileToTable(filename);
+	}
+	auto firstUs = firstSw.GetElapsedUs();
+
+	size_t warmEntries = 0;
+	Stopwatch warmSw;
+	for (auto &filename : filenames) {
+		warmEntries += MesFile::ParseFileToTable(filename).size();
+	}
+	auto warmUs = warmSw.GetElapsedUs();
+
+	MesFile::SetCacheDir("");
+	std::filesystem::remove_all(cacheDir);
+
+	ASSERT_EQ(mapEntries, fileEntries);
+	ASSERT_EQ(mapEntries, warmEntries);
+
+	printf("Loading %zu .mes files: ParseFile %lld us, ParseFileToTable first start %lld us, warm start %lld us\n",
+		filenames.size(), (long long) fileUs, (long long) firstUs, (long long) warmUs);
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "targetver.h"
+
+#include <stdio.h>
+#include <tchar.h>
+
+#include <gtest/gtest.h>
+#include <gmock/gmock.h>
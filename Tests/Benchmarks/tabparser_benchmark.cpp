@@ -0,0 +1,48 @@
+#include "stdafx.h"
+
+#include <infrastructure/tabparser.h>
+#include <infrastructure/vfs.h>
+#include <infrastructure/stringutil.h>
+#include <infrastructure/stopwatch.h>
+
+TEST(TabFileBenchmark, PartSysFiles)
+{
+	// Init VFS with mock/dummy code
+	vfs.reset(Vfs::CreateStdIoVfs());
+
+	std::string content;
+	for (auto filename : { "Tests\\PartSysTests\\data\\partsys0.tab", "Tests\\PartSysTests\\data\\partsys1.tab", "Tests\\PartSysTests\\data\\partsys2.tab" }) {
+		content.append(vfs->ReadAsString(filename));
+		content.push_back('\n');
+	}
+
+	constexpr int Iterations = 20;
+
+	// The per-line split that TabFile used before the table was introduced
+	size_t legacyColumns = 0;
+	Stopwatch legacySw;
+	for (int i = 0; i < Iterations; ++i) {
+		std::vector<gsl::cstring_span<>> columns;
+		for (auto &line : split(gsl::cstring_span<>(content), '\n')) {
+			columns.clear();
+			split(line, '\t', columns, false, true);
+			legacyColumns += columns.size();
+		}
+	}
+	auto legacyUs = legacySw.GetElapsedUs();
+
+	size_t tableColumns = 0;
+	Stopwatch tableSw;
+	for (int i = 0; i < Iterations; ++i) {
+		auto table = TabFileTable::FromView(content);
+		table.ForEachRow([&](const TabFileRecord &record) {
+			tableColumns += record.GetColumnCount();
+		});
+	}
+	auto tableUs = tableSw.GetElapsedUs();
+
+	ASSERT_GT(tableColumns, 0u);
+
+	printf("Parsing %zu KB of particle system tab files: legacy split %lld us, table %lld us\n",
+		content.size() / 1024, (long long) legacyUs / Iterations, (long long) tableUs / Iterations);
+}
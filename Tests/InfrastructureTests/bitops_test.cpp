@@ -0,0 +1,158 @@
+#include "stdafx.h"
+
+#include <random>
+#include <vector>
+
+#include <infrastructure/bitops.h>
+
+static uint32_t PopCountSlow(uint32_t value) {
+	uint32_t count = 0;
+	while (value != 0) {
+		count += value & 1;
+		value >>= 1;
+	}
+	return count;
+}
+
+TEST(BitOpsTest, TestPopCount) {
+	std::mt19937 rng(1234);
+	for (auto i = 0; i < 10000; ++i) {
+		auto value = rng();
+		ASSERT_EQ(PopCountSlow(value), BitOps::PopCount(value));
+		ASSERT_EQ(PopCountSlow(value), BitOps::PopCountPortable(value));
+	}
+	ASSERT_EQ(0u, BitOps::PopCount(0));
+	ASSERT_EQ(32u, BitOps::PopCount(0xFFFFFFFF));
+}
+
+TEST(BitOpsTest, TestPopCountBelow) {
+	uint32_t value = 0xF0F0F0F1;
+	ASSERT_EQ(0u, BitOps::PopCountBelow(value, 0));
+	ASSERT_EQ(1u, BitOps::PopCountBelow(value, 1));
+	ASSERT_EQ(1u, BitOps::PopCountBelow(value, 4));
+	ASSERT_EQ(2u, BitOps::PopCountBelow(value, 5));
+	ASSERT_EQ(16u, BitOps::PopCountBelow(value, 31));
+	ASSERT_EQ(17u, BitOps::PopCountBelow(value, 32));
+}
+
+TEST(BitOpsTest, TestCountTrailingZeros) {
+	for (uint32_t bit = 0; bit < 32; ++bit) {
+		ASSERT_EQ(bit, BitOps::CountTrailingZeros(1u << bit));
+		ASSERT_EQ(bit, BitOps::CountTrailingZeros(0x80000000u | (1u << bit)));
+	}
+}
+
+/**
+ * Stores properties like GameObjectBody: a bit per field in the property bitmap, the values of
+ * the set fields packed in field order, and the same BitmapRanks calls to add and remove them.
+ */
+class PropertyBody {
+public:
+	explicit PropertyBody(size_t blockCount) : mBlocks(blockCount), mRanks(blockCount) {
+	}
+
+	bool Has(uint32_t field) const {
+		return (mBlocks[field / 32] & (1u << (field % 32))) != 0;
+	}
+
+	uint32_t GetIdx(uint32_t field) const {
+		return BitmapRanks::Rank(mBlocks.data(), mRanks.data(), field / 32, field % 32);
+	}
+
+	// Like GetMutableStorageLocation
+	void Set(uint32_t field, int value) {
+		if (!Has(field)) {
+			mValues.resize(mValues.size() + 1);
+			auto idx = BitmapRanks::Insert(mBlocks.data(), mRanks.data(), mBlocks.size(), field / 32, field % 32,
+				mValues.data(), mValues.size() - 1);
+			ASSERT_EQ(0, mValues[idx]);
+		}
+		mValues[GetIdx(field)] = value;
+	}
+
+	// Like ResetField
+	void Reset(uint32_t field) {
+		if (Has(field)) {
+			BitmapRanks::Remove(mBlocks.data(), mRanks.data(), mBlocks.size(), field / 32, field % 32,
+				mValues.data(), mValues.size());
+			mValues.pop_back();
+		}
+	}
+
+	int Get(uint32_t field) const {
+		return mValues[GetIdx(field)];
+	}
+
+	// Like loading or cloning an object: the bitmap is copied, then the ranks are built
+	PropertyBody Copy() const {
+		PropertyBody copy(mBlocks.size());
+		copy.mBlocks = mBlocks;
+		copy.mValues = mValues;
+		BitmapRanks::Build(copy.mBlocks.data(), copy.mRanks.data(), copy.mBlocks.size());
+		return copy;
+	}
+
+	size_t GetCount() const {
+		return mValues.size();
+	}
+
+private:
+	std::vector<uint32_t> mBlocks;
+	std::vector<uint32_t> mRanks;
+	std::vector<int> mValues;
+};
+
+TEST(BitOpsTest, TestPropertyRanksFollowFieldChanges) {
+	// The size of a critter's property bitmap
+	constexpr size_t BlockCount = 14;
+	constexpr uint32_t FieldCount = BlockCount * 32;
+
+	std::mt19937 rng(2468);
+	PropertyBody body(BlockCount);
+	std::vector<int> expected(FieldCount, -1);
+
+	auto checkFields = [&](const PropertyBody &checked) {
+		size_t count = 0;
+		for (uint32_t field = 0; field < FieldCount; ++field) {
+			ASSERT_EQ(expected[field] != -1, checked.Has(field)) << "field " << field;
+			if (expected[field] != -1) {
+				ASSERT_EQ(count, checked.GetIdx(field)) << "field " << field;
+				ASSERT_EQ(expected[field], checked.Get(field)) << "field " << field;
+				count++;
+			}
+		}
+		ASSERT_EQ(count, checked.GetCount());
+	};
+
+	for (auto step = 0; step < 5000; ++step) {
+		auto field = rng() % FieldCount;
+		if (rng() % 3 == 0) {
+			body.Reset(field);
+			expected[field] = -1;
+		} else {
+			auto value = (int)(rng() % 1000);
+			body.Set(field, value);
+			expected[field] = value;
+		}
+		if (step % 50 == 0) {
+			checkFields(body);
+		}
+	}
+	checkFields(body);
+	checkFields(body.Copy());
+
+	// The first and last field of every block
+	for (uint32_t block = 0; block < BlockCount; ++block) {
+		body.Set(block * 32, (int)block);
+		expected[block * 32] = (int)block;
+		body.Reset(block * 32 + 31);
+		expected[block * 32 + 31] = -1;
+	}
+	checkFields(body);
+
+	for (uint32_t field = 0; field < FieldCount; ++field) {
+		body.Reset(field);
+		expected[field] = -1;
+	}
+	checkFields(body);
+}
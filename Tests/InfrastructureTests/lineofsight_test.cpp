@@ -0,0 +1,265 @@
+#include "stdafx.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <infrastructure/lineofsight.h>
+
+using FogMap = std::vector<std::string>;
+
+struct ViewerPos {
+	int x;
+	int y;
+};
+
+// '#' blocks vision and '@' is a viewer
+static VisionBlockers ParseMap(const FogMap &map, std::vector<ViewerPos> &viewersOut) {
+	VisionBlockers blockers;
+	blockers.Reset(0, 0, (int)map[0].size(), (int)map.size());
+	for (int y = 0; y < (int)map.size(); ++y) {
+		for (int x = 0; x < (int)map[y].size(); ++x) {
+			if (map[y][x] == '#') {
+				blockers.SetBlocking(x, y);
+			} else if (map[y][x] == '@') {
+				viewersOut.push_back({ x, y });
+			}
+		}
+	}
+	return blockers;
+}
+
+// The map with the cells that can't be seen blanked out
+static FogMap RenderVisible(const FogMap &map, const LineOfSight &los) {
+	auto result = map;
+	for (int y = 0; y < (int)map.size(); ++y) {
+		for (int x = 0; x < (int)map[y].size(); ++x) {
+			if (!los.IsVisible(x, y)) {
+				result[y][x] = ' ';
+			}
+		}
+	}
+	return result;
+}
+
+static FogMap ComputeFog(const FogMap &map, int radius) {
+	std::vector<ViewerPos> viewers;
+	LineOfSight los;
+	los.SetBlockers(ParseMap(map, viewers));
+	for (size_t i = 0; i < viewers.size(); ++i) {
+		los.SetViewer(i, viewers[i].x, viewers[i].y, radius);
+	}
+	los.Update();
+	return RenderVisible(map, los);
+}
+
+TEST(LineOfSightTest, TestOpenFieldIsLimitedByRadius) {
+	FogMap map{
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+		".....@.....",
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+	};
+	FogMap expected{
+		"           ",
+		"     .     ",
+		"   .....   ",
+		"  .......  ",
+		"  .......  ",
+		" ....@.... ",
+		"  .......  ",
+		"  .......  ",
+		"   .....   ",
+		"     .     ",
+		"           ",
+	};
+	ASSERT_EQ(expected, ComputeFog(map, 4));
+}
+
+TEST(LineOfSightTest, TestPillarCastsShadow) {
+	FogMap map{
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+		"..@.#......",
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+	};
+	FogMap expected{
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+		"........   ",
+		"..@.#      ",
+		"........   ",
+		"...........",
+		"...........",
+		"...........",
+		"...........",
+	};
+	ASSERT_EQ(expected, ComputeFog(map, 10));
+}
+
+TEST(LineOfSightTest, TestRoomWithDoorway) {
+	FogMap map{
+		"#######........",
+		"#.....#........",
+		"#..@..#........",
+		"#.....#........",
+		"###.###........",
+		"...............",
+		"...............",
+		"...............",
+	};
+	FogMap expected{
+		"#######        ",
+		"#.....#        ",
+		"#..@..#        ",
+		"#.....#        ",
+		"###.###        ",
+		"  ...          ",
+		"  ...          ",
+		"  ...          ",
+	};
+	ASSERT_EQ(expected, ComputeFog(map, 20));
+}
+
+TEST(LineOfSightTest, TestViewersAreCombined) {
+	FogMap map{
+		"#######.......",
+		"#.....#.......",
+		"#..@..#...@...",
+		"#.....#.......",
+		"#######.......",
+	};
+	// Neither viewer can see what the other one sees, but both are visible
+	ASSERT_EQ(map, ComputeFog(map, 20));
+}
+
+TEST(LineOfSightTest, TestOpeningDoor) {
+	FogMap map{
+		"#######....",
+		"#..@..#....",
+		"#######....",
+	};
+	std::vector<ViewerPos> viewers;
+	LineOfSight los;
+	los.SetBlockers(ParseMap(map, viewers));
+	los.SetViewer(0, viewers[0].x, viewers[0].y, 10);
+	ASSERT_EQ(1u, los.Update());
+	ASSERT_FALSE(los.IsVisible(8, 1));
+
+	los.SetBlocking(6, 1, false);
+	ASSERT_EQ(1u, los.Update());
+	ASSERT_TRUE(los.IsVisible(8, 1));
+
+	// Nothing changed, so nothing is computed again
+	ASSERT_EQ(0u, los.Update());
+}
+
+static VisionBlockers CreateRandomBlockers(std::mt19937 &rng, int size) {
+	VisionBlockers blockers;
+	blockers.Reset(-size / 2, 100, size, size);
+	for (int y = 0; y < size; ++y) {
+		for (int x = 0; x < size; ++x) {
+			if (rng() % 8 == 0) {
+				blockers.SetBlocking(blockers.GetOriginX() + x, blockers.GetOriginY() + y);
+			}
+		}
+	}
+	return blockers;
+}
+
+TEST(LineOfSightTest, TestUnionMatchesSingleViewers) {
+	constexpr int Size = 64;
+	constexpr int Radius = 20;
+	std::mt19937 rng(4321);
+	auto blockers = CreateRandomBlockers(rng, Size);
+
+	LineOfSight los;
+	los.SetBlockers(blockers);
+	std::vector<ViewerPos> viewers;
+	for (size_t i = 0; i < 5; ++i) {
+		ViewerPos pos{ blockers.GetOriginX() + (int)(rng() % Size), blockers.GetOriginY() + (int)(rng() % Size) };
+		viewers.push_back(pos);
+		los.SetViewer(i, pos.x, pos.y, Radius);
+	}
+	ASSERT_EQ(viewers.size(), los.Update());
+
+	std::vector<uint8_t> expected(Size * Size, 0);
+	std::vector<uint32_t> visible;
+	for (size_t i = 0; i < viewers.size(); ++i) {
+		ShadowCaster::Compute(blockers, viewers[i].x, viewers[i].y, Radius, visible);
+		ASSERT_EQ(visible, los.GetVisibleCells(i));
+		for (auto cellIdx : visible) {
+			expected[cellIdx] = 1;
+		}
+	}
+
+	for (int y = 0; y < Size; ++y) {
+		for (int x = 0; x < Size; ++x) {
+			auto cellX = blockers.GetOriginX() + x, cellY = blockers.GetOriginY() + y;
+			ASSERT_EQ(expected[y * Size + x] != 0, los.IsVisible(cellX, cellY)) << "at " << cellX << "," << cellY;
+		}
+	}
+}
+
+TEST(LineOfSightTest, TestMovingOneViewerMatchesFullUpdate) {
+	constexpr int Size = 64;
+	constexpr int Radius = 20;
+	std::mt19937 rng(8765);
+	auto blockers = CreateRandomBlockers(rng, Size);
+
+	std::vector<ViewerPos> viewers(4);
+	LineOfSight incremental;
+	incremental.SetBlockers(blockers);
+	for (size_t i = 0; i < viewers.size(); ++i) {
+		viewers[i] = { blockers.GetOriginX() + (int)(rng() % Size), blockers.GetOriginY() + (int)(rng() % Size) };
+		incremental.SetViewer(i, viewers[i].x, viewers[i].y, Radius);
+	}
+	incremental.Update();
+
+	for (auto step = 0; step < 50; ++step) {
+		auto idx = rng() % viewers.size();
+		viewers[idx].x += (int)(rng() % 3) - 1;
+		viewers[idx].y += (int)(rng() % 3) - 1;
+		incremental.SetViewer(idx, viewers[idx].x, viewers[idx].y, Radius);
+		ASSERT_LE(incremental.Update(), 1u);
+
+		LineOfSight full;
+		full.SetBlockers(blockers);
+		for (size_t i = 0; i < viewers.size(); ++i) {
+			full.SetViewer(i, viewers[i].x, viewers[i].y, Radius);
+		}
+		full.Update();
+
+		for (int y = blockers.GetOriginY(); y < blockers.GetOriginY() + Size; ++y) {
+			for (int x = blockers.GetOriginX(); x < blockers.GetOriginX() + Size; ++x) {
+				ASSERT_EQ(full.IsVisible(x, y), incremental.IsVisible(x, y)) << "at " << x << "," << y << " in step " << step;
+			}
+		}
+	}
+
+	incremental.RemoveViewer(0);
+	incremental.RemoveViewer(1);
+	incremental.RemoveViewer(2);
+	incremental.RemoveViewer(3);
+	for (int y = blockers.GetOriginY(); y < blockers.GetOriginY() + Size; ++y) {
+		for (int x = blockers.GetOriginX(); x < blockers.GetOriginX() + Size; ++x) {
+			ASSERT_FALSE(incremental.IsVisible(x, y));
+		}
+	}
+}
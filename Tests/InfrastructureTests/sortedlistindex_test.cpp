@@ -0,0 +1,151 @@
+#include "stdafx.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <infrastructure/sortedlistindex.h>
+
+struct TestNode {
+	uint64_t key;
+	int id;
+	TestNode* next = nullptr;
+};
+
+static uint64_t KeyOfNode(const TestNode& node) {
+	return node.key;
+}
+
+using TestIndex = SortedListIndex<TestNode, KeyOfNode, &TestNode::next>;
+
+class SortedListIndexTest : public ::testing::Test {
+protected:
+	TestNode* head = nullptr;
+	TestIndex index;
+	std::vector<std::unique_ptr<TestNode>> nodes;
+
+	TestNode* NewNode(uint64_t key) {
+		nodes.emplace_back(new TestNode{ key, (int)nodes.size() });
+		return nodes.back().get();
+	}
+
+	// Same as the insertion without an index: before any nodes with an equal or later key
+	static void InsertLinear(TestNode** list, TestNode* node) {
+		while (*list && (*list)->key < node->key) {
+			list = &(*list)->next;
+		}
+		node->next = *list;
+		*list = node;
+	}
+
+	static std::vector<int> Ids(const TestNode* list) {
+		std::vector<int> result;
+		for (; list; list = list->next) {
+			result.push_back(list->id);
+		}
+		return result;
+	}
+
+	// Unlinks every node matching the predicate behind the index's back, like the vanilla remove functions
+	template <typename Predicate>
+	void RemoveDirectly(TestNode** list, Predicate predicate) {
+		while (*list) {
+			if (predicate(**list)) {
+				*list = (*list)->next;
+			} else {
+				list = &(*list)->next;
+			}
+		}
+	}
+};
+
+TEST_F(SortedListIndexTest, TestInsertMatchesLinearInsertion) {
+	std::mt19937 rng(42);
+	TestNode* expected = nullptr;
+	for (int i = 0; i < 500; i++) {
+		auto key = rng() % 50;
+		index.Insert(&head, NewNode(key));
+		InsertLinear(&expected, new TestNode(*nodes.back()));
+		ASSERT_TRUE(index.IsConsistent(head));
+	}
+	EXPECT_EQ(Ids(expected), Ids(head));
+
+	while (expected) {
+		auto next = expected->next;
+		delete expected;
+		expected = next;
+	}
+}
+
+TEST_F(SortedListIndexTest, TestHeadRemoval) {
+	for (auto key : { 5, 1, 3, 3, 1, 8 }) {
+		index.Insert(&head, NewNode(key));
+	}
+
+	while (head) {
+		auto node = head;
+		head = node->next;
+		index.OnHeadRemoved(node);
+		ASSERT_TRUE(index.IsConsistent(head));
+	}
+
+	index.Insert(&head, NewNode(4));
+	EXPECT_TRUE(index.IsConsistent(head));
+	EXPECT_EQ(std::vector<int>{ 6 }, Ids(head));
+}
+
+TEST_F(SortedListIndexTest, TestDirectRemovalIsDetected) {
+	for (auto key : { 1, 2, 2, 3 }) {
+		index.Insert(&head, NewNode(key));
+	}
+
+	// the last node with key 2, which the index points at
+	RemoveDirectly(&head, [](const TestNode& node) { return node.id == 1; });
+	EXPECT_FALSE(index.IsConsistent(head));
+
+	index.Invalidate();
+	EXPECT_TRUE(index.IsConsistent(head));
+}
+
+TEST_F(SortedListIndexTest, TestScheduleAfterLegacyRemoval) {
+	std::mt19937 rng(7);
+	TestNode* expected = nullptr;
+	auto insert = [&](uint64_t key) {
+		index.Insert(&head, NewNode(key));
+		InsertLinear(&expected, new TestNode(*nodes.back()));
+	};
+
+	for (int i = 0; i < 200; i++) {
+		insert(rng() % 20);
+	}
+
+	// remove some of the events the way the vanilla code does, then schedule more
+	for (int round = 0; round < 10; round++) {
+		auto removedKey = rng() % 20;
+		auto removed = [&](const TestNode& node) { return node.key == removedKey || node.id % 7 == round; };
+		RemoveDirectly(&head, removed);
+		std::vector<TestNode*> removedExpected;
+		for (auto node = expected; node; node = node->next) {
+			if (removed(*node)) {
+				removedExpected.push_back(node);
+			}
+		}
+		RemoveDirectly(&expected, removed);
+		for (auto node : removedExpected) {
+			delete node;
+		}
+		index.Invalidate();
+
+		for (int i = 0; i < 20; i++) {
+			insert(rng() % 20);
+			ASSERT_TRUE(index.IsConsistent(head));
+		}
+		ASSERT_EQ(Ids(expected), Ids(head));
+	}
+
+	while (expected) {
+		auto next = expected->next;
+		delete expected;
+		expected = next;
+	}
+}
@@ -23,3 +23,39 @@ TEST(MesFileTest, TestParseFile)
 	ASSERT_EQ(0, content.begin()->first);
 	ASSERT_EQ(18019, (--content.end())->first);
 }
+
+TEST(MesFileTest, TestTable)
+{
+	// Later definitions of a key replace earlier ones, like they do in the map
+	auto table = MesFile::ParseStringToTable("{5}{five} {1}{one}\n{5}{FIVE}{3}{}");
+	ASSERT_EQ(3, table.size());
+	ASSERT_STREQ("one", table.Find(1));
+	ASSERT_STREQ("", table.Find(3));
+	ASSERT_STREQ("FIVE", table.Find(5));
+	ASSERT_EQ(nullptr, table.Find(2));
+	ASSERT_EQ("", table[2]);
+
+	std::vector<int> keys;
+	for (auto entry : table) {
+		keys.push_back(entry.first);
+	}
+	ASSERT_EQ(std::vector<int>({ 1, 3, 5 }), keys);
+
+	// The table and the map parser agree
+	ASSERT_EQ(MesFile::ParseString("{5}{five} {1}{one}\n{5}{FIVE}{3}{}"), table.ToMap());
+}
+
+TEST(MesFileTest, TestSerialize)
+{
+	auto table = MesFile::ParseStringToTable("{1}{one}{2}{two}{10}{ten}");
+	auto data = table.Serialize(1234);
+
+	MesTable loaded;
+	ASSERT_TRUE(MesTable::Deserialize(data, 1234, loaded));
+	ASSERT_EQ(table.ToMap(), loaded.ToMap());
+
+	// Stale or truncated cache entries must be rejected
+	ASSERT_FALSE(MesTable::Deserialize(data, 4321, loaded));
+	data.pop_back();
+	ASSERT_FALSE(MesTable::Deserialize(data, 1234, loaded));
+}
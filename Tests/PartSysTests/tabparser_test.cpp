@@ -0,0 +1,74 @@
+#include "stdafx.h"
+
+#include <infrastructure/tabparser.h>
+
+TEST(TabFileTest, TestColumnSplitting)
+{
+	// Empty lines are skipped, a trailing tab doesn't add a column, but inner empty columns are kept
+	std::string content = "a\t\tb\t\r\n\r\n\tx \x0b\n\t\n";
+
+	auto table = TabFileTable::FromView(content);
+	ASSERT_EQ(3, table.GetRowCount());
+
+	auto row = table.GetRow(0);
+	ASSERT_EQ(0, row.GetLineNumber());
+	ASSERT_EQ(3, row.GetColumnCount());
+	ASSERT_EQ("a", row[0].AsString());
+	ASSERT_TRUE(row[1].IsEmpty());
+	ASSERT_EQ("b", row[2].AsString());
+	ASSERT_TRUE(row[3].IsEmpty());
+
+	row = table.GetRow(1);
+	ASSERT_EQ(1, row.GetLineNumber());
+	ASSERT_EQ(2, row.GetColumnCount());
+	ASSERT_TRUE(row[0].IsEmpty());
+	ASSERT_EQ("x", row[1].AsString()); // Trailing spaces and vertical tabs are trimmed
+
+	row = table.GetRow(2);
+	ASSERT_EQ(1, row.GetColumnCount());
+}
+
+TEST(TabFileTest, TestTryGetFloat)
+{
+	std::string content = "1.5\t -2\t+3e2\t4abc\tabc\t.25";
+	auto table = TabFileTable::FromView(content);
+	auto row = table.GetRow(0);
+
+	float value;
+	ASSERT_TRUE(row[0].TryGetFloat(value));
+	ASSERT_FLOAT_EQ(1.5f, value);
+	ASSERT_TRUE(row[1].TryGetFloat(value));
+	ASSERT_FLOAT_EQ(-2.0f, value);
+	ASSERT_TRUE(row[2].TryGetFloat(value));
+	ASSERT_FLOAT_EQ(300.0f, value);
+	ASSERT_TRUE(row[3].TryGetFloat(value));
+	ASSERT_FLOAT_EQ(4.0f, value);
+	ASSERT_FALSE(row[4].TryGetFloat(value));
+	ASSERT_TRUE(row[5].TryGetFloat(value));
+	ASSERT_FLOAT_EQ(0.25f, value);
+	ASSERT_FALSE(row[6].TryGetFloat(value));
+}
+
+TEST(TabFileTest, TestEnumLookup)
+{
+	static const TabFileEnumLookup<int> lookup = {
+		{"World", 1},
+		{"Object Pos", 2},
+		{"Object YPR", 3},
+		{"Bones", 4}
+	};
+
+	std::string content = "world\tOBJECT YPR\tObject\tNode";
+	auto table = TabFileTable::FromView(content);
+	auto row = table.GetRow(0);
+
+	int value;
+	ASSERT_TRUE(row[0].TryGetEnum(lookup, value));
+	ASSERT_EQ(1, value);
+	ASSERT_TRUE(row[1].TryGetEnum(lookup, value));
+	ASSERT_EQ(3, value);
+	// Prefixes resolve to the first matching name in sorted order, like ToEE did
+	ASSERT_TRUE(row[2].TryGetEnum(lookup, value));
+	ASSERT_EQ(2, value);
+	ASSERT_FALSE(row[3].TryGetEnum(lookup, value));
+}